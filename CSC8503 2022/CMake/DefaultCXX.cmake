@@ -1,6 +1,11 @@
 include("${CMAKE_CURRENT_LIST_DIR}/Default.cmake")
 
-set_config_specific_property("OUTPUT_DIRECTORY" "${CMAKE_SOURCE_DIR}$<$<NOT:$<STREQUAL:${CMAKE_VS_PLATFORM_NAME},Win32>>:/${CMAKE_VS_PLATFORM_NAME}>/${PROPS_CONFIG}")
+if(PHYSICS_BENCHMARK_ONLY)
+    #Headless builds run on build machines, so keep what they make out of the source tree
+    set_config_specific_property("OUTPUT_DIRECTORY" "${CMAKE_BINARY_DIR}/${CMAKE_VS_PLATFORM_NAME}/${PROPS_CONFIG}")
+else()
+    set_config_specific_property("OUTPUT_DIRECTORY" "${CMAKE_SOURCE_DIR}$<$<NOT:$<STREQUAL:${CMAKE_VS_PLATFORM_NAME},Win32>>:/${CMAKE_VS_PLATFORM_NAME}>/${PROPS_CONFIG}")
+endif()
 
 if(MSVC)
     create_property_reader("DEFAULT_CXX_EXCEPTION_HANDLING")
@@ -3,6 +3,7 @@
 #include "RenderObject.h"
 #include "Camera.h"
 #include "TextureLoader.h"
+#include "Profiler.h"
 using namespace NCL;
 using namespace Rendering;
 using namespace CSC8503; 
@@ -109,6 +110,7 @@ void GameTechRenderer::LoadSkybox() {
 }
 
 void GameTechRenderer::RenderFrame() {
+	PROFILE_SCOPE("GameTechRenderer::RenderFrame");
 	glEnable(GL_CULL_FACE);
 	glClearColor(1, 1, 1, 1);
 	BuildObjectList();
@@ -128,6 +130,7 @@ void GameTechRenderer::RenderFrame() {
 }
 
 void GameTechRenderer::BuildObjectList() {
+	PROFILE_SCOPE("GameTechRenderer::BuildObjectList");
 	activeObjects.clear();
 
 	gameWorld.OperateOnContents(
@@ -147,6 +150,7 @@ void GameTechRenderer::SortObjectList() {
 }
 
 void GameTechRenderer::RenderShadowMap() {
+	PROFILE_SCOPE("GameTechRenderer::RenderShadowMap");
 	glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
 	glClear(GL_DEPTH_BUFFER_BIT);
 	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
@@ -165,7 +169,7 @@ void GameTechRenderer::RenderShadowMap() {
 	shadowMatrix = biasMatrix * mvMatrix; //we'll use this one later on
 
 	for (const auto&i : activeObjects) {
-		Matrix4 modelMatrix = (*i).GetTransform()->GetMatrix();
+		Matrix4 modelMatrix = (*i).GetTransform()->GetRenderMatrix();
 		Matrix4 mvpMatrix	= mvMatrix * modelMatrix;
 		glUniformMatrix4fv(mvpLocation, 1, false, (float*)&mvpMatrix);
 		BindMesh((*i).GetMesh());
@@ -213,6 +217,7 @@ void GameTechRenderer::RenderSkybox() {
 }
 
 void GameTechRenderer::RenderCamera() {
+	PROFILE_SCOPE("GameTechRenderer::RenderCamera");
 	float screenAspect = (float)windowWidth / (float)windowHeight;
 	Matrix4 viewMatrix = gameWorld.GetMainCamera()->BuildViewMatrix();
 	Matrix4 projMatrix = gameWorld.GetMainCamera()->BuildProjectionMatrix(screenAspect);
@@ -273,7 +278,7 @@ void GameTechRenderer::RenderCamera() {
 			activeShader = shader;
 		}
 
-		Matrix4 modelMatrix = (*i).GetTransform()->GetMatrix();
+		Matrix4 modelMatrix = (*i).GetTransform()->GetRenderMatrix();
 		glUniformMatrix4fv(modelLocation, 1, false, (float*)&modelMatrix);			
 		
 		Matrix4 fullShadowMat = shadowMatrix * modelMatrix;
@@ -301,6 +306,13 @@ MeshGeometry* GameTechRenderer::LoadMesh(const string& name) {
 	return mesh;
 }
 
+//For meshes built at runtime, which need uploading once they've been filled in
+MeshGeometry* GameTechRenderer::CreateMesh() {
+	OGLMesh* mesh = new OGLMesh();
+	mesh->SetPrimitiveType(GeometryPrimitive::Triangles);
+	return mesh;
+}
+
 void GameTechRenderer::NewRenderLines() {
 	const std::vector<Debug::DebugLineEntry>& lines = Debug::GetDebugLines();
 	if (lines.empty()) {
@@ -18,6 +18,7 @@ namespace NCL {
 			~GameTechRenderer();
 
 			MeshGeometry*	LoadMesh(const string& name);
+			MeshGeometry*	CreateMesh();
 			TextureBase*	LoadTexture(const string& name);
 			ShaderBase*		LoadShader(const string& vertex, const string& fragment);
 
@@ -3,6 +3,7 @@
 #include "RenderObject.h"
 #include "Camera.h"
 #include "VulkanUtils.h"
+#include "Profiler.h"
 #ifdef USEVULKAN
 using namespace NCL;
 using namespace Rendering;
@@ -222,6 +223,7 @@ void GameTechVulkanRenderer::BuildDebugPipelines() {
 }
 
 void GameTechVulkanRenderer::RenderFrame() {
+	PROFILE_SCOPE("GameTechVulkanRenderer::RenderFrame");
 	TransitionSwapchainForRendering(defaultCmdBuffer);
 
 	int texID = _TEXCOUNT - 1;
@@ -324,7 +326,7 @@ void GameTechVulkanRenderer::UpdateObjectList() {
 					activeObjects.emplace_back(g);
 
 					ObjectState state;
-					state.modelMatrix = g->GetTransform()->GetMatrix();
+					state.modelMatrix = g->GetTransform()->GetRenderMatrix();
 					state.colour = g->GetColour();
 					state.index[0] = 0;
 					if (g->GetMesh()) {
@@ -474,6 +476,13 @@ MeshGeometry* GameTechVulkanRenderer::LoadMesh(const string& name) {
 	return newMesh;
 }
 
+//For meshes built at runtime, which need uploading once they've been filled in
+MeshGeometry* GameTechVulkanRenderer::CreateMesh() {
+	VulkanMesh* newMesh = new VulkanMesh();
+	newMesh->SetPrimitiveType(NCL::GeometryPrimitive::Triangles);
+	return newMesh;
+}
+
 TextureBase* GameTechVulkanRenderer::LoadTexture(const string& name) {
 	VulkanGameTechTexture* t = new VulkanGameTechTexture(name);
 	//Write the texture to our big descriptor set
@@ -14,6 +14,7 @@ namespace NCL::Rendering {
 		~GameTechVulkanRenderer();
 
 		MeshGeometry*	LoadMesh(const string& name);
+		MeshGeometry*	CreateMesh();
 		TextureBase*	LoadTexture(const string& name);
 		ShaderBase*		LoadShader(const string& vertex, const string& fragment);
 
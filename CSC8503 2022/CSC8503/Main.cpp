@@ -23,6 +23,8 @@
 #include "BehaviourSequence.h"
 #include "BehaviourAction.h"
 
+#include "Profiler.h"
+
 using namespace NCL;
 using namespace CSC8503;
 
@@ -376,5 +378,9 @@ int main() {
 	TutorialGame* g = new TutorialGame();
 	RunGame(w, g);
 
+#ifdef USEPROFILING
+	Profiler::WriteChromeTrace("Trace.json"); //The last few seconds of zones, for chrome://tracing
+#endif
+
 	Window::DestroyGameWindow();
 }
\ No newline at end of file
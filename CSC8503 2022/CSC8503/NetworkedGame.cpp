@@ -3,6 +3,7 @@
 #include "NetworkObject.h"
 #include "GameServer.h"
 #include "GameClient.h"
+#include "Profiler.h"
 
 #define COLLISION_MSG 30
 
@@ -73,6 +74,7 @@ void NetworkedGame::UpdateGame(float dt) {
 }
 
 void NetworkedGame::UpdateAsServer(float dt) {
+	PROFILE_SCOPE("NetworkedGame::UpdateAsServer");
 	packetsToSnapshot--;
 	if (packetsToSnapshot < 0) {
 		BroadcastSnapshot(false);
@@ -84,6 +86,7 @@ void NetworkedGame::UpdateAsServer(float dt) {
 }
 
 void NetworkedGame::UpdateAsClient(float dt) {
+	PROFILE_SCOPE("NetworkedGame::UpdateAsClient");
 	ClientPacket newPacket;
 
 	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::SPACE)) {
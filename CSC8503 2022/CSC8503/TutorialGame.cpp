@@ -4,6 +4,7 @@
 #include "RenderObject.h"
 #include "TextureLoader.h"
 #include "Maths.h"
+#include "Profiler.h"
 
 #include <algorithm>
 
@@ -12,16 +13,14 @@ using namespace CSC8503;
 using namespace Maths;
 using namespace std; 
 
+//Everything nearby is pushed away, not just what the rocket hit, and the rocket is removed once it has gone off
 void Rocket::OnCollisionBegin(GameObject* otherobj) {
-    
-    PhysicsObject* objPhys = otherobj->GetPhysicsObject();
-	Vector3 direction = (otherobj->GetTransform().GetPosition() - this->GetTransform().GetPosition()).Normalised();
-	float distance = (otherobj->GetTransform().GetPosition() / this->GetTransform().GetPosition()).Length();
-	float distanceScale = 1.0 - Maths::Clamp(distance / radius, 0.0f, 1.0f);
-	objPhys->AddForce(direction * (explosionForce * distanceScale));
-	this->SetIsActive(false); //Hides the sphere from the rocket (However, this leaves the collider)
-	//world->RemoveGameObject(this);
-	//delete this;
+	if (exploded) {
+		return;
+	}
+	exploded = true;
+	this->SetIsActive(false);
+	explosions->Detonate(this->GetTransform().GetPosition(), blastRadius, explosionImpulse, this);
 }
 
 void Coin::OnCollisionBegin(GameObject* otherobj) {
@@ -43,9 +42,16 @@ TutorialGame::TutorialGame()	{
 #endif
 
 	physics		= new PhysicsSystem(*world);
+	explosions	= new ExplosionSystem(*world);
+	explosions->SetRemovalCallback([this](GameObject* o) { ForgetObject(o); });
+
+	PhysicsConfig physicsConfig;
+	if (physicsConfig.LoadFromFile(Assets::DATADIR + "PhysicsConfig.txt")) {
+		physics->SetConfig(physicsConfig);
+	}
 
 	forceMagnitude	= 10.0f;
-	useGravity		= false;
+	useGravity		= physics->GetConfig().useGravity;
 	inSelectionMode = false;
 
 	InitialiseAssets();
@@ -76,6 +82,7 @@ void TutorialGame::InitialiseAssets() {
 TutorialGame::~TutorialGame()	{
 	delete cubeMesh;
 	delete sphereMesh;
+	delete mazeMesh;
 	delete charMesh;
 	delete enemyMesh;
 	delete bonusMesh;
@@ -83,12 +90,14 @@ TutorialGame::~TutorialGame()	{
 	delete basicTex;
 	delete basicShader;
 
+	delete explosions;
 	delete physics;
 	delete renderer;
 	delete world;
 }
 
 void TutorialGame::UpdateGame(float dt) {
+	PROFILE_SCOPE("TutorialGame::UpdateGame");
 	if (!inSelectionMode) {
 		world->GetMainCamera()->UpdateCamera(dt);
 	}
@@ -150,6 +159,7 @@ void TutorialGame::UpdateGame(float dt) {
 	world->UpdateWorld(dt);
 	renderer->Update(dt);
 	physics->Update(dt);
+	explosions->Update();
 
 	renderer->Render();
 	Debug::UpdateRenderables(dt);
@@ -169,6 +179,21 @@ void TutorialGame::UpdateKeys() {
 		useGravity = !useGravity; //Toggle gravity!
 		physics->UseGravity(useGravity);
 	}
+
+	//The physics settings can be changed on the fly, to compare them against each other
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::B)) {
+		PhysicsSystem::BroadPhaseType type = (PhysicsSystem::BroadPhaseType)(((int)physics->GetBroadPhase() + 1) % 3);
+		physics->SetBroadPhase(type);
+		std::cout << "Setting broadphase to " << PhysicsConfig::GetBroadPhaseName(type) << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::I)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() - 1);
+		std::cout << "Setting constraint iterations to " << physics->GetConstraintIterationCount() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::O)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() + 1);
+		std::cout << "Setting constraint iterations to " << physics->GetConstraintIterationCount() << std::endl;
+	}
 	//Running certain physics updates in a consistent order might cause some
 	//bias in the calculations - the same objects might keep 'winning' the constraint
 	//allowing the other one to stretch too much etc. Shuffling the order so that it
@@ -360,6 +385,15 @@ void TutorialGame::InitCamera() {
 void TutorialGame::InitWorld() {
 	world->ClearAndErase();
 	physics->Clear();
+	explosions->Clear();
+
+	//The world has just deleted all of these
+	toBeTethered	= nullptr;
+	TetheredTo		= nullptr;
+	tetherConst		= nullptr;
+	isSwinging		= false;
+	links.clear();
+	constraints.clear();
 
 	//InitMixedGridWorld(15, 15, 5.0f, 5.0f);
 	AddCubeToWorld(Vector3(-175, 25, -140), Vector3(2, 2, 2), 0);
@@ -471,6 +505,27 @@ GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimens
 	return cube;
 }
 
+//An immovable box that's only there to be collided with, with something else drawing it
+GameObject* TutorialGame::AddWallToWorld(const Vector3& position, const Vector3& dimensions) {
+	GameObject* wall = new GameObject();
+
+	AABBVolume* volume = new AABBVolume(dimensions);
+	wall->SetBoundingVolume((CollisionVolume*)volume);
+
+	wall->GetTransform()
+		.SetPosition(position)
+		.SetScale(dimensions * 2);
+
+	wall->SetPhysicsObject(new PhysicsObject(&wall->GetTransform(), wall->GetBoundingVolume()));
+
+	wall->GetPhysicsObject()->SetInverseMass(0.0f);
+	wall->GetPhysicsObject()->InitCubeInertia();
+
+	world->AddGameObject(wall);
+
+	return wall;
+}
+
 GameObject* TutorialGame::AddPlayerToWorld(const Vector3& position) {
 	float meshSize		= 1.0f;
 	float inverseMass	= 0.5f;
@@ -489,6 +544,7 @@ GameObject* TutorialGame::AddPlayerToWorld(const Vector3& position) {
 
 	character->GetPhysicsObject()->SetInverseMass(inverseMass);
 	character->GetPhysicsObject()->InitSphereInertia();
+	character->SetLayers(PlayerLayer);
 
 	world->AddGameObject(character);
 	return character;
@@ -553,6 +609,8 @@ Coin* TutorialGame::AddCoinToWorld(const Vector3& position) {
 
 	coin->GetPhysicsObject()->SetInverseMass(0.0f);
 	coin->GetPhysicsObject()->InitSphereInertia();
+	coin->SetLayers(CoinLayer);
+	coin->SetCollisionMask(PlayerLayer); //Nothing else can pick it up, so nothing else needs testing against it
 	world->AddGameObject(coin);
 	return coin;
 }
@@ -598,7 +656,7 @@ BehaviourGameObject* TutorialGame::AddGooseToWorld(const Vector3& position) {
 }
 
 Rocket* TutorialGame::CreateRocket(const Vector3& position, float radius) {
-	Rocket* rocket = new Rocket();
+	Rocket* rocket = new Rocket(explosions);
 
 	Vector3 sphereSize = Vector3(radius, radius, radius);
 	SphereVolume* volume = new SphereVolume(radius);
@@ -611,8 +669,11 @@ Rocket* TutorialGame::CreateRocket(const Vector3& position, float radius) {
 	rocket->SetRenderObject(new RenderObject(&rocket->GetTransform(), sphereMesh, basicTex, basicShader));
 	rocket->SetPhysicsObject(new PhysicsObject(&rocket->GetTransform(), rocket->GetBoundingVolume()));
 
-	rocket->GetPhysicsObject()->SetInverseMass(0);
+	rocket->GetPhysicsObject()->SetInverseMass(1.0f);
 	rocket->GetPhysicsObject()->InitSphereInertia();
+	rocket->GetPhysicsObject()->SetContinuousCollision(true); //Too fast to rely on landing inside a wall for a step
+	rocket->SetLayers(RocketLayer);
+	rocket->SetCollisionMask(GameObject::AllLayers & ~RocketLayer); //Rockets fired in quick succession mustn't set each other off
 
 	world->AddGameObject(rocket);
 
@@ -705,13 +766,60 @@ void TutorialGame::TetherObjects() {
 	}
 }
 
+void TutorialGame::ForgetObject(GameObject* o) {
+	if (selectionObject == o) {
+		selectionObject = nullptr;
+	}
+	if (prevSelectionObject == o) {
+		prevSelectionObject = nullptr;
+	}
+	if (objClosest == o) {
+		objClosest = nullptr;
+	}
+	if (lockedObject == o) {
+		lockedObject = nullptr;
+	}
+
+	if (tetherConst) {
+		GameObject* a = nullptr;
+		GameObject* b = nullptr;
+		tetherConst->GetObjects(a, b);
+		if (a == o || b == o) {
+			world->RemoveConstraint(tetherConst, true);
+			tetherConst = nullptr;
+			TetheredTo	= nullptr;
+		}
+	}
+	if (toBeTethered == o) {
+		toBeTethered = nullptr;
+	}
+	if (TetheredTo == o) {
+		TetheredTo = nullptr;
+	}
+
+	//The rope can't hang from half of itself, so take it down and leave its link to fall
+	bool ropeUsesObject = false;
+	for (PositionConstraint* c : constraints) {
+		GameObject* a = nullptr;
+		GameObject* b = nullptr;
+		c->GetObjects(a, b);
+		ropeUsesObject |= (a == o || b == o);
+	}
+	if (ropeUsesObject) {
+		for (PositionConstraint* c : constraints) {
+			world->RemoveConstraint(c, true);
+		}
+		constraints.clear();
+		links.clear();
+		isSwinging = false;
+	}
+}
+
 void TutorialGame::FireRocket() {
 	if (currentItem == Rockets) {
 		Ray ray = CollisionDetection::BuildRayFromMouse(*world->GetMainCamera());
-		RayCollision closestCollision;
-		world->Raycast(ray, closestCollision, true);
-		Vector3 position = closestCollision.collidedAt;
-		CreateRocket(position, 10.0f);
+		Rocket* rocket = CreateRocket(ray.GetPosition() + ray.GetDirection() * 5.0f, 1.0f);
+		rocket->GetPhysicsObject()->SetLinearVelocity(ray.GetDirection() * rocketSpeed);
 	}
 }
 
@@ -760,9 +868,12 @@ void TutorialGame::InitCubeGridWorld(int numRows, int numCols, float rowSpacing,
 	}
 }
 
+/*
+Rather than a cube for every wall cell, neighbouring cells are merged into as
+few boxes as possible, and each box only gets a collider. The walls are all
+drawn by one object, using a mesh with every box baked into it.
+*/
 void TutorialGame::InitMaze(const std::string& filename) {
-	NavigationGrid grid(filename);
-
 	std::ifstream infile(Assets::DATADIR + filename);
 	int nodeSize;
 	int gridWidth;
@@ -771,20 +882,42 @@ void TutorialGame::InitMaze(const std::string& filename) {
 	infile >> gridWidth;
 	infile >> gridHeight;
 
-	GridNode* allNodes = new GridNode[gridWidth * gridHeight];
-
+	std::vector<bool> walls(gridWidth * gridHeight);
 	for (int y = 0; y < gridHeight; ++y) {
 		for (int x = 0; x < gridWidth; ++x) {
-			GridNode& n = allNodes[(gridWidth * y) + x];
 			char type = 0;
 			infile >> type;
-			n.type = type;
-			n.position = Vector3((float)(x * nodeSize), 0, (float)(y * nodeSize));
-			if (type == 'x') { 
-				AddCubeToWorld(n.position + Vector3(-200, 8, -180), Vector3(10, 15, 10), 0); }
+			walls[(gridWidth * y) + x] = type == 'x';
 		}
 	}
+	std::vector<GridBoxMerger::CellBox> boxes;
+	GridBoxMerger::MergeCells(walls, gridWidth, gridHeight, boxes);
+
+	Vector3 cellHalfSize = Vector3(10, 15, 10);
+	std::vector<Vector3> centres;
+	std::vector<Vector3> halfSizes;
+	for (const GridBoxMerger::CellBox& box : boxes) {
+		Vector3 firstCell	= Vector3((float)(box.x * nodeSize), 0, (float)(box.y * nodeSize));
+		Vector3 halfSize	= Vector3(cellHalfSize.x * box.width, cellHalfSize.y, cellHalfSize.z * box.depth);
+		Vector3 centre		= firstCell + Vector3((box.width - 1) * nodeSize * 0.5f, 0, (box.depth - 1) * nodeSize * 0.5f);
+		centre += Vector3(-200, 8, -180);
+
+		AddWallToWorld(centre, halfSize);
+		centres.push_back(centre);
+		halfSizes.push_back(halfSize);
+	}
+
+	delete mazeMesh;
+	mazeMesh = renderer->CreateMesh();
+	GridBoxMerger::BuildBoxMesh(*mazeMesh, centres, halfSizes, cellHalfSize.x * 2.0f);
+	mazeMesh->SetDebugName("Maze");
+	mazeMesh->UploadToGPU(renderer);
+
+	GameObject* mazeWalls = new GameObject("Maze");
+	mazeWalls->SetRenderObject(new RenderObject(&mazeWalls->GetTransform(), mazeMesh, basicTex, basicShader));
+	world->AddGameObject(mazeWalls);
 }
+
 /*
 Every frame, this code will let you perform a raycast, to see if there's an object
 underneath the cursor, and if so 'select it' into a pointer, so that it can be 
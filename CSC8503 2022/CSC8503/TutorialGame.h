@@ -4,24 +4,36 @@
 #include "GameTechVulkanRenderer.h"
 #endif
 #include "PhysicsSystem.h"
+#include "ExplosionSystem.h"
 
 #include "PositionConstraint.h"
 #include "OrientationConstraint.h"
 #include "StateGameObject.h"
 #include "BehaviourGameObject.h"
 #include "NavigationGrid.h"
+#include "GridBoxMerger.h"
 #include <fstream>
 #include "Assets.h"
 
 namespace NCL {
 	namespace CSC8503 {
+		//Which layer each kind of object is on, for GameObject::SetLayers and SetCollisionMask
+		enum GameLayers : uint32_t {
+			DefaultLayer	= 1,
+			PlayerLayer		= 2,
+			CoinLayer		= 4,
+			RocketLayer		= 8
+		};
+
 		class Rocket : public GameObject {
 		public:
+			Rocket(ExplosionSystem* e) { explosions = e; }
 			void OnCollisionBegin(GameObject* otherobj);
 		protected:
-			float explosionForce = 20.0f;
-			float radius = 10.0f;
-			float inverseMass = 0.0f;
+			ExplosionSystem* explosions;
+			float explosionImpulse = 20.0f;
+			float blastRadius = 10.0f;
+			bool exploded = false;
 		};
 
 		class Coin : public GameObject {
@@ -80,12 +92,16 @@ namespace NCL {
 			GameObject* AddSphereToWorld(const Vector3& position, float radius, float inverseMass = 10.0f);
 			Coin* AddCoinToWorld(const Vector3& position);
 			GameObject* AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f);
+			GameObject* AddWallToWorld(const Vector3& position, const Vector3& dimensions);
 			void BridgeConstraint();
 			void RopeSwing();
 			void TetherObjects();
-			GameObject* toBeTethered;
-			GameObject* TetheredTo;
-			PositionConstraint* tetherConst;
+			GameObject* toBeTethered		= nullptr;
+			GameObject* TetheredTo			= nullptr;
+			PositionConstraint* tetherConst	= nullptr;
+
+			//Lets go of an object the explosions are about to delete
+			void ForgetObject(GameObject* o);
 
 			GameObject* AddPlayerToWorld(const Vector3& position);
 			GameObject* AddEnemyToWorld(const Vector3& position);
@@ -102,6 +118,7 @@ namespace NCL {
 #endif
 			PhysicsSystem*		physics;
 			GameWorld*			world;
+			ExplosionSystem*	explosions;
 
 			bool useGravity;
 			bool inSelectionMode;
@@ -115,6 +132,7 @@ namespace NCL {
 			Item currentItem = None;
 
 			void FireRocket();
+			float rocketSpeed = 200.0f; //Units per second, along the mouse ray
 
 			bool isSwinging = false;
 			vector<GameObject*> links;
@@ -128,6 +146,7 @@ namespace NCL {
 			MeshGeometry*	capsuleMesh = nullptr;
 			MeshGeometry*	cubeMesh	= nullptr;
 			MeshGeometry*	sphereMesh	= nullptr;
+			MeshGeometry*	mazeMesh	= nullptr;	//All of the maze's walls, built by InitMaze
 
 			TextureBase*	basicTex	= nullptr;
 			ShaderBase*		basicShader = nullptr;
@@ -3,6 +3,7 @@
 #include "AABBVolume.h"
 #include "OBBVolume.h"
 #include "SphereVolume.h"
+#include "GJK.h"
 #include "Window.h"
 #include "Maths.h"
 #include "Debug.h"
@@ -142,6 +143,79 @@ bool CollisionDetection::RayCapsuleIntersection(const Ray& r, const Transform& w
 	return false;
 }
 
+/*
+Which intersection function handles each pair of volume types, indexed by
+the bit each type sets. A pair that's only registered one way round is
+handled by swapping the two objects over, rather than flipping the normal
+afterwards - the contact's normal then runs from the collision's a to its b,
+just as it would if they'd been given in that order.
+
+The table is filled in when the program loads, not when it first runs, so
+there's no check for whether it's ready on every call.
+*/
+namespace {
+	struct IntersectionEntry {
+		CollisionDetection::IntersectionFunction	function;
+		bool										swapped;
+	};
+
+	struct IntersectionTable {
+		IntersectionEntry entries[CollisionDetection::VolumeTypeCount][CollisionDetection::VolumeTypeCount];
+
+		constexpr void Register(VolumeType typeA, VolumeType typeB, CollisionDetection::IntersectionFunction function) {
+			int a = CollisionDetection::GetVolumeTypeIndex(typeA);
+			int b = CollisionDetection::GetVolumeTypeIndex(typeB);
+			entries[a][b] = { function, false };
+			if (a != b && (!entries[b][a].function || entries[b][a].swapped)) {
+				entries[b][a] = { function, true };
+			}
+		}
+	};
+
+	//Lets the functions that take a particular type of volume go in the table
+	template <typename VolumeA, typename VolumeB, bool (*Function)(const VolumeA&, const Transform&, const VolumeB&, const Transform&, CollisionDetection::CollisionInfo&)>
+	bool CastVolumes(const CollisionVolume& volumeA, const Transform& worldTransformA,
+		const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionDetection::CollisionInfo& collisionInfo) {
+		return Function((const VolumeA&)volumeA, worldTransformA, (const VolumeB&)volumeB, worldTransformB, collisionInfo);
+	}
+
+	bool GJKIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+		const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionDetection::CollisionInfo& collisionInfo) {
+		return GJK::Intersection(volumeA, worldTransformA, volumeB, worldTransformB, collisionInfo, collisionInfo.searchDirection);
+	}
+
+	constexpr IntersectionTable BuildIntersectionTable() {
+		using CD = CollisionDetection;
+		IntersectionTable table{};
+		table.Register(VolumeType::AABB,	VolumeType::AABB,	CastVolumes<AABBVolume, AABBVolume, CD::AABBIntersection>);
+		table.Register(VolumeType::Sphere,	VolumeType::Sphere,	CastVolumes<SphereVolume, SphereVolume, CD::SphereIntersection>);
+		table.Register(VolumeType::OBB,		VolumeType::OBB,	CastVolumes<OBBVolume, OBBVolume, CD::OBBIntersection>);
+		table.Register(VolumeType::AABB,	VolumeType::OBB,	CastVolumes<AABBVolume, OBBVolume, CD::AABBOBBIntersection>);
+		table.Register(VolumeType::AABB,	VolumeType::Sphere,	CastVolumes<AABBVolume, SphereVolume, CD::AABBSphereIntersection>);
+		table.Register(VolumeType::OBB,		VolumeType::Sphere,	CastVolumes<OBBVolume, SphereVolume, CD::OBBSphereIntersection>);
+		table.Register(VolumeType::Capsule,	VolumeType::Sphere,	CastVolumes<CapsuleVolume, SphereVolume, CD::SphereCapsuleIntersection>);
+		table.Register(VolumeType::Capsule,	VolumeType::AABB,	CastVolumes<CapsuleVolume, AABBVolume, CD::AABBCapsuleIntersection>);
+
+		//Anything else - two capsules, or a capsule and an OBB - only needs the shapes' support functions
+		for (int a = 0; a < CD::VolumeTypeCount; ++a) {
+			for (int b = a; b < CD::VolumeTypeCount; ++b) {
+				VolumeType typeA = (VolumeType)(1 << a);
+				VolumeType typeB = (VolumeType)(1 << b);
+				if (!table.entries[a][b].function && GJK::HasSupportFunction(typeA) && GJK::HasSupportFunction(typeB)) {
+					table.Register(typeA, typeB, GJKIntersection);
+				}
+			}
+		}
+		return table;
+	}
+
+	constinit IntersectionTable intersectionTable = BuildIntersectionTable();
+}
+
+void CollisionDetection::RegisterIntersection(VolumeType typeA, VolumeType typeB, IntersectionFunction function) {
+	intersectionTable.Register(typeA, typeB, function);
+}
+
 bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo) {
 	const CollisionVolume* volA = a->GetBoundingVolume();
 	const CollisionVolume* volB = b->GetBoundingVolume();
@@ -150,68 +224,51 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return false;
 	}
 
-	collisionInfo.a = a;
-	collisionInfo.b = b;
-
-	Transform& transformA = a->GetTransform();
-	Transform& transformB = b->GetTransform();
-
-	VolumeType pairType = (VolumeType)((int)volA->type | (int)volB->type);
-
-	//Two AABBs
-	if (pairType == VolumeType::AABB) {
-		return AABBIntersection((AABBVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
-	}
-	//Two Spheres
-	if (pairType == VolumeType::Sphere) {
-		return SphereIntersection((SphereVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	}
-	//Two OBBs
-	if (pairType == VolumeType::OBB) {
-		return OBBIntersection((OBBVolume&)*volA, transformA, (OBBVolume&)*volB, transformB, collisionInfo);
+	int indexA = GetVolumeTypeIndex(volA->type);
+	int indexB = GetVolumeTypeIndex(volB->type);
+	if (indexA >= VolumeTypeCount || indexB >= VolumeTypeCount) {
+		return false;
 	}
-	//Two Capsules
 
-	//AABB vs Sphere pairs
-	if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere) {
-		return AABBSphereIntersection((AABBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
+	const IntersectionEntry& entry = intersectionTable.entries[indexA][indexB];
+	if (!entry.function) {
+		return false;
 	}
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::AABB) {
+
+	if (entry.swapped) {
 		collisionInfo.a = b;
 		collisionInfo.b = a;
-		return AABBSphereIntersection((AABBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
+		return entry.function(*volB, b->GetTransform(), *volA, a->GetTransform(), collisionInfo);
 	}
+	collisionInfo.a = a;
+	collisionInfo.b = b;
+	return entry.function(*volA, a->GetTransform(), *volB, b->GetTransform(), collisionInfo);
+}
 
-	//OBB vs sphere pairs
-	if (volA->type == VolumeType::OBB && volB->type == VolumeType::Sphere) {
-		return OBBSphereIntersection((OBBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	}
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::OBB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return OBBSphereIntersection((OBBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
+bool CollisionDetection::VolumeIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	int indexA = GetVolumeTypeIndex(volumeA.type);
+	int indexB = GetVolumeTypeIndex(volumeB.type);
+	if (indexA >= VolumeTypeCount || indexB >= VolumeTypeCount) {
+		return false;
 	}
 
-	//Capsule vs other interactions
-	if (volA->type == VolumeType::Capsule && volB->type == VolumeType::Sphere) {
-		return SphereCapsuleIntersection((CapsuleVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
+	const IntersectionEntry& entry = intersectionTable.entries[indexA][indexB];
+	if (!entry.function) {
+		return false;
 	}
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Capsule) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return SphereCapsuleIntersection((CapsuleVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
+	if (!entry.swapped) {
+		return entry.function(volumeA, worldTransformA, volumeB, worldTransformB, collisionInfo);
 	}
-
-	if (volA->type == VolumeType::Capsule && volB->type == VolumeType::AABB) {
-		return AABBCapsuleIntersection((CapsuleVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
+	if (!entry.function(volumeB, worldTransformB, volumeA, worldTransformA, collisionInfo)) {
+		return false;
 	}
-	if (volB->type == VolumeType::Capsule && volA->type == VolumeType::AABB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return AABBCapsuleIntersection((CapsuleVolume&)*volB, transformB, (AABBVolume&)*volA, transformA, collisionInfo);
+	for (int i = 0; i < collisionInfo.pointCount; ++i) {
+		ContactPoint& p = collisionInfo.points[i];
+		std::swap(p.localA, p.localB);
+		p.normal = -p.normal;
 	}
-
-	return false;
+	return true;
 }
 
 bool CollisionDetection::AABBTest(const Vector3& posA, const Vector3& posB, const Vector3& halfSizeA, const Vector3& halfSizeB) {
@@ -262,14 +319,53 @@ bool CollisionDetection::AABBIntersection(const AABBVolume& volumeA, const Trans
 
 		float penetration = FLT_MAX;
 		Vector3 bestAxis;
+		int bestFace = 0;
 
 		for (int i = 0; i < 6; i++) {
 			if (distances[i] < penetration) {
 				penetration = distances[i];
 				bestAxis = faces[i];
+				bestFace = i;
+			}
+		}
+
+		/*
+		The boxes touch wherever their faces overlap, which for two AABBs is
+		always a rectangle - so a contact goes at each of its corners, rather
+		than just one in the middle that a box could rock about. The corners
+		are placed on B's face, and pushed back along the normal onto A's.
+		*/
+		int axis		= bestFace / 2;
+		int tangent0	= (axis + 1) % 3;
+		int tangent1	= (axis + 2) % 3;
+
+		Vector3 pointOnB;
+		pointOnB[axis] = bestFace % 2 ? minB[axis] : maxB[axis];
+
+		float lo[2] = { std::max(minA[tangent0], minB[tangent0]), std::max(minA[tangent1], minB[tangent1]) };
+		float hi[2] = { std::min(maxA[tangent0], maxB[tangent0]), std::min(maxA[tangent1], maxB[tangent1]) };
+		//Which box each edge of the rectangle came from, so the corners keep their IDs as the boxes slide
+		uint32_t loFromB[2] = { minB[tangent0] > minA[tangent0], minB[tangent1] > minA[tangent1] };
+		uint32_t hiFromB[2] = { maxB[tangent0] < maxA[tangent0], maxB[tangent1] < maxA[tangent1] };
+
+		//An edge lying across a face only needs a contact at each end
+		const float minWidth = 0.001f;
+		int cornersX = hi[0] - lo[0] > minWidth ? 2 : 1;
+		int cornersY = hi[1] - lo[1] > minWidth ? 2 : 1;
+
+		for (int x = 0; x < cornersX; ++x) {
+			for (int y = 0; y < cornersY; ++y) {
+				pointOnB[tangent0] = cornersX == 1 ? (lo[0] + hi[0]) * 0.5f : (x ? hi[0] : lo[0]);
+				pointOnB[tangent1] = cornersY == 1 ? (lo[1] + hi[1]) * 0.5f : (y ? hi[1] : lo[1]);
+
+				Vector3 pointOnA = pointOnB + bestAxis * penetration;
+
+				uint32_t featureID = (bestFace << 8) | (x << 5) | (y << 4) |
+					((x ? hiFromB[0] : loFromB[0]) << 1) | (y ? hiFromB[1] : loFromB[1]);
+
+				collisionInfo.AddContactPoint(pointOnA - boxAPos, pointOnB - boxBPos, bestAxis, penetration, featureID);
 			}
 		}
-		collisionInfo.AddContactPoint(Vector3(), Vector3(), bestAxis, penetration);
 		return true;
 	}
 	
@@ -280,7 +376,7 @@ bool CollisionDetection::AABBIntersection(const AABBVolume& volumeA, const Trans
 bool CollisionDetection::SphereIntersection(const SphereVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
 	
-	float radii = volumeA.GetRadius() + volumeA.GetRadius();
+	float radii = volumeA.GetRadius() + volumeB.GetRadius();
 	Vector3 delta = worldTransformB.GetPosition() - worldTransformA.GetPosition();
 
 	float deltaLength = delta.Length();
@@ -326,24 +422,407 @@ bool CollisionDetection::AABBSphereIntersection(const AABBVolume& volumeA, const
 
 bool  CollisionDetection::OBBSphereIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	Quaternion orientation = worldTransformA.GetOrientation();
+	Matrix3 transform		= Matrix3(orientation);
+	Matrix3 invTransform	= Matrix3(orientation.Conjugate());
+
+	Vector3 boxSize = volumeA.GetHalfDimensions();
+	float	radius	= volumeB.GetRadius();
+
+	//Once in the box's space, this is just the AABB test
+	Vector3 delta = invTransform * (worldTransformB.GetPosition() - worldTransformA.GetPosition());
+	Vector3 closestPointOnBox = Clamp(delta, -boxSize, boxSize);
+	Vector3 localPoint = delta - closestPointOnBox;
+	float distance = localPoint.Length();
+
+	Vector3 localNormal;
+	float penetration;
+
+	if (distance > 0.0f) {
+		if (distance >= radius) {
+			return false;
+		}
+		localNormal = localPoint / distance;
+		penetration = radius - distance;
+	}
+	else {
+		//The sphere's centre is inside the box, so it's pushed out of the nearest face
+		float nearest = FLT_MAX;
+		for (int i = 0; i < 3; ++i) {
+			float toFace = boxSize[i] - abs(delta[i]);
+			if (toFace < nearest) {
+				nearest		= toFace;
+				localNormal = Vector3();
+				localNormal[i] = delta[i] < 0.0f ? -1.0f : 1.0f;
+				closestPointOnBox = delta;
+				closestPointOnBox[i] = localNormal[i] * boxSize[i];
+			}
+		}
+		penetration = radius + nearest;
+	}
+	Vector3 collisionNormal = transform * localNormal;
+
+	Vector3 localA = transform * closestPointOnBox;
+	Vector3 localB = -collisionNormal * radius;
+
+	collisionInfo.AddContactPoint(localA, localB, collisionNormal, penetration);
+	return true;
 }
 
 bool CollisionDetection::AABBCapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	return GJK::Intersection(volumeA, worldTransformA, (const CollisionVolume&)volumeB, worldTransformB, collisionInfo, collisionInfo.searchDirection);
 }
 
 bool CollisionDetection::SphereCapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	return GJK::Intersection(volumeA, worldTransformA, (const CollisionVolume&)volumeB, worldTransformB, collisionInfo, collisionInfo.searchDirection);
+}
+
+/*
+A box, as a centre, the world space directions of its local axes, and how
+far it extends along each of them - an AABB is just a box whose axes are
+the world axes, so AABBs and OBBs can be collided by the same code.
+*/
+struct CollisionBox {
+	Vector3 position;
+	Vector3 axes[3];
+	Vector3 halfSizes;
+
+	CollisionBox(const Transform& transform, const Vector3& halfDims, bool rotated) {
+		position	= transform.GetPosition();
+		halfSizes	= halfDims;
+		Matrix3 orientation = rotated ? Matrix3(transform.GetOrientation()) : Matrix3();
+		for (int i = 0; i < 3; ++i) {
+			axes[i] = orientation.GetColumn(i);
+		}
+	}
+
+	//How far the box reaches along the given direction, either side of its centre
+	float ProjectedRadius(const Vector3& axis) const {
+		return	halfSizes.x * abs(Vector3::Dot(axes[0], axis)) +
+				halfSizes.y * abs(Vector3::Dot(axes[1], axis)) +
+				halfSizes.z * abs(Vector3::Dot(axes[2], axis));
+	}
+};
+
+/*
+There are 15 axes that could separate two boxes - the three face normals of
+each, and the nine cross products of an edge of one with an edge of the
+other. They're numbered in that order, so that the cache can remember which
+one it was last time. Edges that are parallel to each other give no axis,
+and are never separating.
+*/
+static const int BoxAxisCount = 15;
+
+static bool GetBoxAxis(const CollisionBox& a, const CollisionBox& b, int index, Vector3& axis) {
+	if (index < 3) {
+		axis = a.axes[index];
+		return true;
+	}
+	if (index < 6) {
+		axis = b.axes[index - 3];
+		return true;
+	}
+	int edge = index - 6;
+	axis = Vector3::Cross(a.axes[edge / 3], b.axes[edge % 3]);
+	float length = axis.Length();
+	if (length < 0.0001f) {
+		return false;
+	}
+	axis = axis / length;
+	return true;
+}
+
+//How far the boxes overlap along an axis - negative if there's a gap between them
+static float BoxOverlap(const CollisionBox& a, const CollisionBox& b, const Vector3& axis) {
+	float distance = abs(Vector3::Dot(b.position - a.position, axis));
+	return a.ProjectedRadius(axis) + b.ProjectedRadius(axis) - distance;
+}
+
+struct ClipVertex {
+	Vector3		position;
+	uint32_t	id;
+};
+
+//Keeps the parts of the polygon where Dot(p, normal) <= offset, numbering any new corners by the plane that made them
+static int ClipPolygon(const ClipVertex* in, int inCount, ClipVertex* out, const Vector3& normal, float offset, uint32_t plane) {
+	int outCount = 0;
+	for (int i = 0; i < inCount; ++i) {
+		const ClipVertex& from	= in[i];
+		const ClipVertex& to	= in[(i + 1) % inCount];
+		float fromDist	= Vector3::Dot(from.position, normal) - offset;
+		float toDist	= Vector3::Dot(to.position, normal) - offset;
+
+		if (fromDist <= 0.0f) {
+			out[outCount++] = from;
+		}
+		if (fromDist * toDist < 0.0f) {
+			float t = fromDist / (fromDist - toDist);
+			out[outCount].position	= from.position + (to.position - from.position) * t;
+			out[outCount].id		= 0x10 | (plane << 2) | (from.id & 3);
+			outCount++;
+		}
+	}
+	return outCount;
+}
+
+/*
+Clipping can leave up to eight corners, but four that are spread out as far
+as possible hold a box just as flat - the deepest corner, the one furthest
+from it, and then the ones furthest out either side of the line between them.
+*/
+static int ReduceContacts(ClipVertex* points, int count, const Vector3& normal) {
+	int chosen[4] = { 0, 0, 0, 0 };
+	for (int i = 1; i < count; ++i) {
+		if (Vector3::Dot(points[i].position, normal) < Vector3::Dot(points[chosen[0]].position, normal)) {
+			chosen[0] = i;
+		}
+	}
+	float furthest = -1.0f;
+	for (int i = 0; i < count; ++i) {
+		float distance = (points[i].position - points[chosen[0]].position).LengthSquared();
+		if (distance > furthest) {
+			furthest	= distance;
+			chosen[1]	= i;
+		}
+	}
+	Vector3 line = points[chosen[1]].position - points[chosen[0]].position;
+	float mostLeft	= 0.0f;
+	float mostRight	= 0.0f;
+	chosen[2] = chosen[0];
+	chosen[3] = chosen[1];
+	for (int i = 0; i < count; ++i) {
+		float side = Vector3::Dot(Vector3::Cross(line, points[i].position - points[chosen[0]].position), normal);
+		if (side > mostLeft) {
+			mostLeft	= side;
+			chosen[2]	= i;
+		}
+		if (side < mostRight) {
+			mostRight	= side;
+			chosen[3]	= i;
+		}
+	}
+	ClipVertex kept[4];
+	int keptCount = 0;
+	for (int i = 0; i < 4; ++i) {
+		bool duplicate = false;
+		for (int j = 0; j < keptCount; ++j) {
+			duplicate |= kept[j].id == points[chosen[i]].id;
+		}
+		if (!duplicate) {
+			kept[keptCount++] = points[chosen[i]];
+		}
+	}
+	for (int i = 0; i < keptCount; ++i) {
+		points[i] = kept[i];
+	}
+	return keptCount;
+}
+
+/*
+The face of the box the normal points furthest into (the reference face)
+has the most anti-parallel face of the other box (the incident face)
+clipped down to the edges of it. Whatever is left of the incident face
+below the reference face is touching it.
+*/
+static void AddFaceContacts(const CollisionBox& a, const CollisionBox& b, int axisIndex, const Vector3& normal, float overlap, CollisionDetection::CollisionInfo& collisionInfo) {
+	bool referenceIsA				= axisIndex < 3;
+	const CollisionBox& reference	= referenceIsA ? a : b;
+	const CollisionBox& incident	= referenceIsA ? b : a;
+	int referenceAxis				= axisIndex % 3;
+
+	//Pointing out of the reference box, towards the incident one
+	Vector3 referenceNormal = referenceIsA ? normal : -normal;
+	float referenceSign = Vector3::Dot(reference.axes[referenceAxis], referenceNormal) < 0.0f ? -1.0f : 1.0f;
+	Vector3 referenceFaceNormal = reference.axes[referenceAxis] * referenceSign;
+
+	int incidentAxis = 0;
+	float mostAntiParallel = -FLT_MAX;
+	for (int i = 0; i < 3; ++i) {
+		float d = abs(Vector3::Dot(incident.axes[i], referenceFaceNormal));
+		if (d > mostAntiParallel) {
+			mostAntiParallel	= d;
+			incidentAxis		= i;
+		}
+	}
+	float incidentSign = Vector3::Dot(incident.axes[incidentAxis], referenceFaceNormal) > 0.0f ? -1.0f : 1.0f;
+
+	int u = (incidentAxis + 1) % 3;
+	int v = (incidentAxis + 2) % 3;
+	Vector3 incidentCentre	= incident.position + incident.axes[incidentAxis] * (incident.halfSizes[incidentAxis] * incidentSign);
+	Vector3 incidentU		= incident.axes[u] * incident.halfSizes[u];
+	Vector3 incidentV		= incident.axes[v] * incident.halfSizes[v];
+
+	//Up to four clip planes can each add a corner
+	ClipVertex polygon[8] = {
+		{ incidentCentre + incidentU + incidentV, 0 },
+		{ incidentCentre - incidentU + incidentV, 1 },
+		{ incidentCentre - incidentU - incidentV, 2 },
+		{ incidentCentre + incidentU - incidentV, 3 },
+	};
+	ClipVertex clipped[8];
+	int count = 4;
+
+	for (int side = 0; side < 2 && count > 0; ++side) {
+		int sideAxis = (referenceAxis + 1 + side) % 3;
+		Vector3 sideNormal	= reference.axes[sideAxis];
+		float	centre		= Vector3::Dot(reference.position, sideNormal);
+		float	extent		= reference.halfSizes[sideAxis];
+
+		count = ClipPolygon(polygon, count, clipped, sideNormal, centre + extent, side * 2);
+		count = ClipPolygon(clipped, count, polygon, -sideNormal, -centre + extent, side * 2 + 1);
+	}
+
+	float	faceOffset	= Vector3::Dot(reference.position, referenceFaceNormal) + reference.halfSizes[referenceAxis];
+	uint32_t faces		= ((uint32_t)referenceIsA << 12) | ((referenceAxis * 2 + (referenceSign > 0.0f)) << 9) | ((incidentAxis * 2 + (incidentSign > 0.0f)) << 6);
+
+	if (count > CollisionDetection::CollisionInfo::MaxContactPoints) {
+		count = ReduceContacts(polygon, count, referenceFaceNormal);
+	}
+
+	for (int i = 0; i < count; ++i) {
+		float depth = faceOffset - Vector3::Dot(polygon[i].position, referenceFaceNormal);
+		if (depth < 0.0f) {
+			continue;
+		}
+		Vector3 onIncident	= polygon[i].position;
+		Vector3 onReference	= onIncident + referenceFaceNormal * depth;
+
+		Vector3 pointOnA = referenceIsA ? onReference : onIncident;
+		Vector3 pointOnB = referenceIsA ? onIncident : onReference;
+		collisionInfo.AddContactPoint(pointOnA - a.position, pointOnB - b.position, normal, depth, faces | polygon[i].id);
+	}
+	if (collisionInfo.pointCount == 0) {
+		//Only grazing - the overlap along the normal still needs pushing out
+		Vector3 pointOnB = b.position - normal * b.ProjectedRadius(normal);
+		collisionInfo.AddContactPoint(pointOnB + normal * overlap - a.position, pointOnB - b.position, normal, overlap, faces);
+	}
+}
+
+/*
+Two edges crossing each other touch at a single point - the closest points
+of the two edges that stick out furthest towards the other box.
+*/
+static void AddEdgeContact(const CollisionBox& a, const CollisionBox& b, int axisIndex, const Vector3& normal, float overlap, CollisionDetection::CollisionInfo& collisionInfo) {
+	int edgeA = (axisIndex - 6) / 3;
+	int edgeB = (axisIndex - 6) % 3;
+
+	Vector3 pointA = a.position;
+	Vector3 pointB = b.position;
+	uint32_t corners = 0;
+	for (int i = 0; i < 3; ++i) {
+		if (i != edgeA) {
+			float sign = Vector3::Dot(a.axes[i], normal) < 0.0f ? -1.0f : 1.0f;
+			pointA = pointA + a.axes[i] * (a.halfSizes[i] * sign);
+			corners |= (sign > 0.0f) << i;
+		}
+		if (i != edgeB) {
+			float sign = Vector3::Dot(b.axes[i], normal) > 0.0f ? -1.0f : 1.0f;
+			pointB = pointB + b.axes[i] * (b.halfSizes[i] * sign);
+			corners |= (sign > 0.0f) << (i + 3);
+		}
+	}
+	Vector3 dirA = a.axes[edgeA];
+	Vector3 dirB = b.axes[edgeB];
+
+	//Closest points between the two edge lines
+	Vector3 r	= pointA - pointB;
+	float dAB	= Vector3::Dot(dirA, dirB);
+	float denom	= 1.0f - dAB * dAB;
+	float s		= 0.0f;
+	float t		= 0.0f;
+	if (denom > 0.0001f) {
+		s = (dAB * Vector3::Dot(dirB, r) - Vector3::Dot(dirA, r)) / denom;
+		t = Vector3::Dot(dirB, r) + s * dAB;
+	}
+	s = std::clamp(s, -a.halfSizes[edgeA], a.halfSizes[edgeA]);
+	t = std::clamp(t, -b.halfSizes[edgeB], b.halfSizes[edgeB]);
+
+	Vector3 pointOnA = pointA + dirA * s;
+	Vector3 pointOnB = pointB + dirB * t;
+
+	uint32_t featureID = (1 << 15) | ((uint32_t)axisIndex << 6) | corners;
+	collisionInfo.AddContactPoint(pointOnA - a.position, pointOnB - b.position, normal, overlap, featureID);
+}
+
+/*
+Two boxes overlap unless some axis has a gap between them along it. If the
+pair had a separating axis last time, that one is tried first - objects
+that are near each other but not touching barely move between steps, so
+it's usually still separating them, and the other 14 axes never need to
+be tried. Otherwise, the axis they overlap least along gives the normal -
+with face axes preferred over edge ones when it's close, as face contacts
+give a steadier manifold.
+*/
+static bool BoxIntersection(const CollisionBox& a, const CollisionBox& b, CollisionDetection::CollisionInfo& collisionInfo) {
+	Vector3 axis;
+	int cached = collisionInfo.separatingAxis;
+	if (cached >= 0 && cached < BoxAxisCount && GetBoxAxis(a, b, cached, axis) && BoxOverlap(a, b, axis) < 0.0f) {
+		return false;
+	}
+
+	const float faceBias = 0.95f;
+	const float edgeBias = 0.01f;
+
+	int		bestFace		= -1;
+	float	bestFaceOverlap	= FLT_MAX;
+	int		bestEdge		= -1;
+	float	bestEdgeOverlap	= FLT_MAX;
+
+	for (int i = 0; i < BoxAxisCount; ++i) {
+		if (!GetBoxAxis(a, b, i, axis)) {
+			continue;
+		}
+		float overlap = BoxOverlap(a, b, axis);
+		if (overlap < 0.0f) {
+			collisionInfo.separatingAxis = i;
+			return false;
+		}
+		if (i < 6) {
+			//B's faces only win if they're clearly better than A's
+			if (bestFace < 0 || overlap < (i < 3 ? bestFaceOverlap : bestFaceOverlap * faceBias)) {
+				bestFace		= i;
+				bestFaceOverlap	= overlap;
+			}
+		}
+		else if (overlap < bestEdgeOverlap) {
+			bestEdge		= i;
+			bestEdgeOverlap	= overlap;
+		}
+	}
+	collisionInfo.separatingAxis = -1;
+
+	bool useEdge = bestEdge >= 0 && bestEdgeOverlap < bestFaceOverlap * faceBias - edgeBias;
+	int	  best			= useEdge ? bestEdge : bestFace;
+	float bestOverlap	= useEdge ? bestEdgeOverlap : bestFaceOverlap;
+
+	GetBoxAxis(a, b, best, axis);
+	Vector3 normal = Vector3::Dot(b.position - a.position, axis) < 0.0f ? -axis : axis;
+
+	if (useEdge) {
+		AddEdgeContact(a, b, best, normal, bestOverlap, collisionInfo);
+	}
+	else {
+		AddFaceContacts(a, b, best, normal, bestOverlap, collisionInfo);
+	}
+	return true;
 }
 
 bool CollisionDetection::OBBIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
 	const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	return false;
+	CollisionBox boxA(worldTransformA, volumeA.GetHalfDimensions(), true);
+	CollisionBox boxB(worldTransformB, volumeB.GetHalfDimensions(), true);
+	return BoxIntersection(boxA, boxB, collisionInfo);
+}
+
+bool CollisionDetection::AABBOBBIntersection(const AABBVolume& volumeA, const Transform& worldTransformA,
+	const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	CollisionBox boxA(worldTransformA, volumeA.GetHalfDimensions(), false);
+	CollisionBox boxB(worldTransformB, volumeB.GetHalfDimensions(), true);
+	return BoxIntersection(boxA, boxB, collisionInfo);
 }
 
 Matrix4 GenerateInverseView(const Camera &c) {
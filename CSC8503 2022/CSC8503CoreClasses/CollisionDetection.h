@@ -11,6 +11,8 @@
 #include "CapsuleVolume.h"
 #include "Ray.h"
 
+#include <bit>
+
 using NCL::Camera;
 using namespace NCL::Maths;
 using namespace NCL::CSC8503;
@@ -23,34 +25,57 @@ namespace NCL {
 			Vector3 localB;
 			Vector3 normal;
 			float	penetration;
+			//Identifies which features of the two shapes made this point, so it can be
+			//matched up with the same point from the last step, even if it has moved a little
+			uint32_t featureID;
 		};
 		struct CollisionInfo {
+			//A face resting on a face needs its four corners to stay flat
+			static constexpr int MaxContactPoints = 4;
+
 			GameObject* a;
 			GameObject* b;		
 			int		framesLeft;
 
-			ContactPoint point;
+			ContactPoint points[MaxContactPoints];
+			int		pointCount;
 
-			CollisionInfo() {
+			//Which axis last kept this pair apart, if any, so it can be tried first next time
+			int		separatingAxis;
+			//Where GJK last finished searching for this pair, so it can start from there next time
+			Vector3	searchDirection;
 
+			CollisionInfo() {
+				pointCount		= 0;
+				separatingAxis	= -1;
 			}
 
-			void AddContactPoint(const Vector3& localA, const Vector3& localB, const Vector3& normal, float p) {
+			void AddContactPoint(const Vector3& localA, const Vector3& localB, const Vector3& normal, float p, uint32_t featureID = 0) {
+				if (pointCount == MaxContactPoints) {
+					return;
+				}
+				ContactPoint& point = points[pointCount++];
 				point.localA		= localA;
 				point.localB		= localB;
 				point.normal		= normal;
 				point.penetration	= p;
+				point.featureID		= featureID;
+			}
+
+			//Packs both world IDs into one 64 bit key, the same whichever way round a and b are.
+			//The IDs are cast to unsigned 32 bit first, so a negative ID can't spill into the other half
+			uint64_t GetPairKey() const {
+				uint32_t idA = (uint32_t)a->GetWorldID();
+				uint32_t idB = (uint32_t)b->GetWorldID();
+				if (idA > idB) {
+					std::swap(idA, idB);
+				}
+				return ((uint64_t)idA << 32) | (uint64_t)idB;
 			}
 
 			//Advanced collision detection / resolution
 			bool operator < (const CollisionInfo& other) const {
-				size_t otherHash = (size_t)other.a->GetWorldID() + ((size_t)other.b->GetWorldID() << 32);
-				size_t thisHash  = (size_t)a->GetWorldID() + ((size_t)b->GetWorldID() << 32);
-
-				if (thisHash < otherHash) {
-					return true;
-				}
-				return false;
+				return GetPairKey() < other.GetPairKey();
 			}
 
 			bool operator ==(const CollisionInfo& other) const {
@@ -90,6 +115,25 @@ namespace NCL {
 
 		static bool ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo);
 
+		//As above, for volumes that needn't belong to an object - the contacts always come back with A first
+		static bool VolumeIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+			const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		//Collides two volumes, of the types it was registered for, in the order it was registered
+		typedef bool (*IntersectionFunction)(const CollisionVolume& volumeA, const Transform& worldTransformA,
+			const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		//Every volume type bit, from AABB up to Compound, gets a row and column of the table
+		static constexpr int VolumeTypeCount = 6;
+
+		static constexpr int GetVolumeTypeIndex(VolumeType type) {
+			return std::countr_zero((unsigned int)type);
+		}
+
+		//Also used for the pair the other way round, unless that has a function of its own.
+		//Call before the physics starts stepping - the table isn't locked while it's read
+		static void RegisterIntersection(VolumeType typeA, VolumeType typeB, IntersectionFunction function);
+
 
 		static bool AABBIntersection(	const AABBVolume& volumeA, const Transform& worldTransformA,
 										const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
@@ -103,6 +147,9 @@ namespace NCL {
 		static bool OBBIntersection(	const OBBVolume& volumeA, const Transform& worldTransformA,
 										const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 
+		static bool AABBOBBIntersection(const AABBVolume& volumeA, const Transform& worldTransformA,
+										const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
 
 		static bool OBBSphereIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
 			const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
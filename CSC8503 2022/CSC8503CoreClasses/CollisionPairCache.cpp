@@ -0,0 +1,138 @@
+#include "CollisionPairCache.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+CollisionPairCache::CollisionPairCache() {
+	slotMask = 0;
+	Clear();
+}
+
+CollisionPairCache::~CollisionPairCache() {
+}
+
+void CollisionPairCache::Clear() {
+	pairs.clear();
+	slots.assign(64, EmptySlot);
+	slotMask = slots.size() - 1;
+}
+
+//The world IDs count up from 0, so they need mixing before they make a good hash
+uint64_t CollisionPairCache::Hash(uint64_t key) {
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+	return key;
+}
+
+/*
+Linear probing - returns either the slot holding this key, or the empty slot
+the key would be placed in. The table is never more than half full, so there's
+always an empty slot to stop at.
+*/
+int CollisionPairCache::FindSlot(uint64_t key) const {
+	uint64_t slot = Hash(key) & slotMask;
+	while (slots[slot] != EmptySlot && pairs[slots[slot]].key != key) {
+		slot = (slot + 1) & slotMask;
+	}
+	return (int)slot;
+}
+
+CollisionPairCache::CollisionPair* CollisionPairCache::Find(uint64_t key) {
+	int slot = FindSlot(key);
+	if (slots[slot] == EmptySlot) {
+		return nullptr;
+	}
+	return &pairs[slots[slot]];
+}
+
+/*
+The new points won't necessarily come out of the narrowphase in the same
+order as last time, or even be the same number of them, so each one looks
+for the old point with its feature ID to take its impulses from.
+*/
+void CollisionPairCache::RefreshContacts(CollisionPair& pair, const CollisionDetection::CollisionInfo& info) {
+	const int maxPoints = CollisionDetection::CollisionInfo::MaxContactPoints;
+	float	normalImpulses[maxPoints];
+	Vector3	frictionImpulses[maxPoints];
+
+	for (int i = 0; i < info.pointCount; ++i) {
+		normalImpulses[i]	= 0.0f;
+		frictionImpulses[i]	= Vector3();
+		for (int j = 0; j < pair.info.pointCount; ++j) {
+			if (pair.info.points[j].featureID == info.points[i].featureID) {
+				normalImpulses[i]	= pair.normalImpulses[j];
+				frictionImpulses[i]	= pair.frictionImpulses[j];
+				break;
+			}
+		}
+	}
+	for (int i = 0; i < maxPoints; ++i) {
+		pair.normalImpulses[i]		= i < info.pointCount ? normalImpulses[i] : 0.0f;
+		pair.frictionImpulses[i]	= i < info.pointCount ? frictionImpulses[i] : Vector3();
+	}
+	pair.info = info;
+}
+
+CollisionPairCache::CollisionPair& CollisionPairCache::Insert(const CollisionDetection::CollisionInfo& info) {
+	uint64_t key = info.GetPairKey();
+	int slot = FindSlot(key);
+
+	if (slots[slot] != EmptySlot) {
+		CollisionPair& pair = pairs[slots[slot]];
+		RefreshContacts(pair, info);
+		return pair;
+	}
+	if ((pairs.size() + 1) * 2 > slots.size()) {
+		Grow();
+		slot = FindSlot(key);
+	}
+	slots[slot] = (int)pairs.size();
+	CollisionPair& pair = pairs.emplace_back();
+	pair.key	= key;
+	pair.info	= info;
+	pair.begun	= false;
+	pair.ClearImpulses();
+	return pair;
+}
+
+void CollisionPairCache::RemoveAt(int index) {
+	int hole = FindSlot(pairs[index].key);
+	slots[hole] = EmptySlot;
+
+	//Rather than leaving a tombstone, shuffle back any later entries in the
+	//same probe run that would no longer be reachable past the hole
+	uint64_t next = (hole + 1) & slotMask;
+	while (slots[next] != EmptySlot) {
+		uint64_t home = Hash(pairs[slots[next]].key) & slotMask;
+
+		bool reachable = ((uint64_t)hole <= next) ?
+			(home > (uint64_t)hole && home <= next) :
+			(home > (uint64_t)hole || home <= next);
+
+		if (!reachable) {
+			slots[hole] = slots[next];
+			slots[next] = EmptySlot;
+			hole		= (int)next;
+		}
+		next = (next + 1) & slotMask;
+	}
+
+	int last = (int)pairs.size() - 1;
+	if (index != last) {
+		pairs[index] = pairs[last];
+		slots[FindSlot(pairs[index].key)] = index;
+	}
+	pairs.pop_back();
+}
+
+void CollisionPairCache::Grow() {
+	slots.assign(slots.size() * 2, EmptySlot);
+	slotMask = slots.size() - 1;
+
+	for (int i = 0; i < (int)pairs.size(); ++i) {
+		slots[FindSlot(pairs[i].key)] = i;
+	}
+}
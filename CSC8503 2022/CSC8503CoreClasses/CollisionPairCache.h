@@ -0,0 +1,73 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Keeps track of every pair of objects currently in contact, keyed by the
+		pair of world IDs. The pairs themselves are packed into one contiguous
+		array, which is what gets walked each frame to send out the collision
+		begin / end events, while a separate open addressing hash table maps
+		a pair's key to where it sits in that array.
+		*/
+		class CollisionPairCache {
+		public:
+			struct CollisionPair {
+				uint64_t key;
+				CollisionDetection::CollisionInfo info;
+				bool	 begun;	//Has OnCollisionBegin been sent for this pair yet?
+
+				//The contact solver's total impulses for each of info's contact points,
+				//from the last time this pair was solved
+				float	normalImpulses[CollisionDetection::CollisionInfo::MaxContactPoints];
+				Vector3	frictionImpulses[CollisionDetection::CollisionInfo::MaxContactPoints];
+
+				void ClearImpulses() {
+					for (int i = 0; i < CollisionDetection::CollisionInfo::MaxContactPoints; ++i) {
+						normalImpulses[i]	= 0.0f;
+						frictionImpulses[i]	= Vector3();
+					}
+				}
+			};
+
+			CollisionPairCache();
+			~CollisionPairCache();
+
+			void Clear();
+
+			//Adds a new pair, or refreshes the contacts of one we already have - any contact
+			//point with the same feature as one from before keeps its impulses
+			CollisionPair& Insert(const CollisionDetection::CollisionInfo& info);
+
+			CollisionPair* Find(uint64_t key);
+
+			//Removes the pair at the given index - the last pair takes its place
+			void RemoveAt(int index);
+
+			int GetPairCount() const {
+				return (int)pairs.size();
+			}
+
+			CollisionPair& GetPair(int index) {
+				return pairs[index];
+			}
+
+			int GetPairIndex(const CollisionPair& pair) const {
+				return (int)(&pair - pairs.data());
+			}
+
+		protected:
+			static constexpr int EmptySlot = -1;
+
+			static uint64_t Hash(uint64_t key);
+
+			int  FindSlot(uint64_t key) const;
+			void RefreshContacts(CollisionPair& pair, const CollisionDetection::CollisionInfo& info);
+			void Grow();
+
+			std::vector<CollisionPair>	pairs;
+			std::vector<int>			slots;	//Indices into pairs, or EmptySlot
+			uint64_t					slotMask;
+		};
+	}
+}
@@ -2,12 +2,21 @@
 
 namespace NCL {
 	namespace CSC8503 {
+		class GameObject;
+
 		class Constraint	{
 		public:
 			Constraint() {}
 			virtual ~Constraint() {}
 
 			virtual void UpdateConstraint(float dt) = 0;
+
+			//The objects this constraint ties together, so the physics
+			//system can keep them in the same island
+			virtual void GetObjects(GameObject*& a, GameObject*& b) const {
+				a = nullptr;
+				b = nullptr;
+			}
 		};
 	}
 }
\ No newline at end of file
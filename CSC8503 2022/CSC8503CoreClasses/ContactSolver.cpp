@@ -0,0 +1,193 @@
+#include "ContactSolver.h"
+#include "PhysicsObject.h"
+#include "GameObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+ContactSolver::ContactSolver() {
+	baumgarte				= 0.2f;
+	penetrationSlop			= 0.01f;
+	restitutionThreshold	= 1.0f;
+}
+
+ContactSolver::~ContactSolver() {
+}
+
+void ContactSolver::Clear() {
+	contacts.clear();
+}
+
+void ContactSolver::AddContact(int pairIndex) {
+	ContactConstraint c = {};
+	c.pairIndex = pairIndex;
+	contacts.push_back(c);
+}
+
+//How much a unit impulse along dir changes the two objects' relative velocity at the contact, inverted
+static float EffectiveMass(const PhysicsObject* physA, const PhysicsObject* physB, const Vector3& relativeA, const Vector3& relativeB, const Vector3& dir) {
+	Vector3 inertiaA = Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, dir), relativeA);
+	Vector3 inertiaB = Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, dir), relativeB);
+
+	float k = physA->GetInverseMass() + physB->GetInverseMass() + Vector3::Dot(inertiaA + inertiaB, dir);
+	return k > 0.0f ? 1.0f / k : 0.0f;
+}
+
+static Vector3 ContactVelocity(const PhysicsObject* physA, const PhysicsObject* physB, const Vector3& relativeA, const Vector3& relativeB) {
+	Vector3 fullVelocityA = physA->GetLinearVelocity() + Vector3::Cross(physA->GetAngularVelocity(), relativeA);
+	Vector3 fullVelocityB = physB->GetLinearVelocity() + Vector3::Cross(physB->GetAngularVelocity(), relativeB);
+	return fullVelocityB - fullVelocityA;
+}
+
+//Any two directions at right angles to the normal will do for friction
+static void TangentBasis(const Vector3& normal, Vector3& t0, Vector3& t1) {
+	if (abs(normal.x) >= 0.57735f) {
+		t0 = Vector3(normal.y, -normal.x, 0.0f).Normalised();
+	}
+	else {
+		t0 = Vector3(0.0f, normal.z, -normal.y).Normalised();
+	}
+	t1 = Vector3::Cross(normal, t0);
+}
+
+/*
+An AABB stays lined up with the world axes however its object is rotated,
+so a contact can't turn it, or it would spin forever against a collision
+shape that never turns with it.
+*/
+static bool CanTurn(const GameObject* object) {
+	const CollisionVolume* volume = object->GetBoundingVolume();
+	return !(volume && volume->type == VolumeType::AABB);
+}
+
+/*
+The normal always points from A towards B, so a negative relative velocity
+along it means the objects are moving together. Each contact aims for a
+relative velocity that bounces them apart by their elasticity, or that
+pushes out a little of any penetration, whichever is greater.
+
+If neither object can turn, every point of a manifold would push on the
+objects' centres in exactly the same way, so they are solved as just the
+one point, with the deepest penetration and all of their impulses.
+*/
+void ContactSolver::PrepareContacts(CollisionPairCache& pairs, float dt) {
+	for (ContactConstraint& c : contacts) {
+		const CollisionPairCache::CollisionPair& pair = pairs.GetPair(c.pairIndex);
+		const CollisionDetection::CollisionInfo& info = pair.info;
+
+		bool turnA = CanTurn(info.a);
+		bool turnB = CanTurn(info.b);
+
+		c.physA			= info.a->GetPhysicsObject();
+		c.physB			= info.b->GetPhysicsObject();
+		c.normal		= info.points[0].normal;
+		c.pointCount	= (turnA || turnB) ? info.pointCount : 1;
+		TangentBasis(c.normal, c.tangents[0], c.tangents[1]);
+
+		float elasticity	= c.physA->GetElasticity() * c.physB->GetElasticity();
+		c.friction			= sqrt(c.physA->GetFriction() * c.physB->GetFriction());
+
+		for (int j = 0; j < c.pointCount; ++j) {
+			const CollisionDetection::ContactPoint& p = info.points[j];
+			ContactConstraintPoint& cp = c.points[j];
+
+			float	penetration		= p.penetration;
+			float	normalImpulse	= pair.normalImpulses[j];
+			Vector3	frictionImpulse	= pair.frictionImpulses[j];
+			for (int k = c.pointCount; k < info.pointCount; ++k) {
+				penetration		= std::max(penetration, info.points[k].penetration);
+				normalImpulse	+= pair.normalImpulses[k];
+				frictionImpulse	+= pair.frictionImpulses[k];
+			}
+
+			cp.relativeA	= turnA ? p.localA : Vector3();
+			cp.relativeB	= turnB ? p.localB : Vector3();
+			cp.normalMass	= EffectiveMass(c.physA, c.physB, cp.relativeA, cp.relativeB, c.normal);
+			for (int i = 0; i < 2; ++i) {
+				cp.tangentMass[i] = EffectiveMass(c.physA, c.physB, cp.relativeA, cp.relativeB, c.tangents[i]);
+			}
+
+			float approachSpeed = Vector3::Dot(ContactVelocity(c.physA, c.physB, cp.relativeA, cp.relativeB), c.normal);
+			float bounce		= approachSpeed < -restitutionThreshold ? -elasticity * approachSpeed : 0.0f;
+			float pushOut		= (baumgarte / dt) * std::max(penetration - penetrationSlop, 0.0f);
+			cp.velocityBias		= std::max(bounce, pushOut);
+
+			//The friction impulse is kept as a world space vector, as the tangents may have changed since
+			cp.normalImpulse = normalImpulse;
+			for (int i = 0; i < 2; ++i) {
+				cp.tangentImpulse[i] = Vector3::Dot(frictionImpulse, c.tangents[i]);
+			}
+		}
+	}
+
+	//Warm starting is done once every contact has measured its approach speed
+	for (ContactConstraint& c : contacts) {
+		for (int j = 0; j < c.pointCount; ++j) {
+			ContactConstraintPoint& cp = c.points[j];
+			ApplyImpulse(c, cp, c.normal * cp.normalImpulse + c.tangents[0] * cp.tangentImpulse[0] + c.tangents[1] * cp.tangentImpulse[1]);
+		}
+	}
+}
+
+/*
+Each iteration corrects each contact's velocity given what the others have
+done so far. The impulses are clamped on their running totals rather than
+on each correction, so a later iteration can take back some of what an
+earlier one did, as long as the contact never ends up pulling the objects
+together, or the friction ever exceeds what the normal impulse allows.
+*/
+void ContactSolver::SolveContacts(const int* indices, int count) {
+	for (int k = 0; k < count; ++k) {
+		ContactConstraint& c = contacts[indices[k]];
+
+		for (int j = 0; j < c.pointCount; ++j) {
+			ContactConstraintPoint& cp = c.points[j];
+			float maxFriction = c.friction * cp.normalImpulse;
+			for (int i = 0; i < 2; ++i) {
+				Vector3 contactVelocity = ContactVelocity(c.physA, c.physB, cp.relativeA, cp.relativeB);
+				float lambda = -Vector3::Dot(contactVelocity, c.tangents[i]) * cp.tangentMass[i];
+
+				float oldImpulse		= cp.tangentImpulse[i];
+				cp.tangentImpulse[i]	= std::clamp(oldImpulse + lambda, -maxFriction, maxFriction);
+				ApplyImpulse(c, cp, c.tangents[i] * (cp.tangentImpulse[i] - oldImpulse));
+			}
+		}
+
+		for (int j = 0; j < c.pointCount; ++j) {
+			ContactConstraintPoint& cp = c.points[j];
+			Vector3 contactVelocity = ContactVelocity(c.physA, c.physB, cp.relativeA, cp.relativeB);
+			float lambda = (cp.velocityBias - Vector3::Dot(contactVelocity, c.normal)) * cp.normalMass;
+
+			float oldImpulse	= cp.normalImpulse;
+			cp.normalImpulse	= std::max(oldImpulse + lambda, 0.0f);
+			ApplyImpulse(c, cp, c.normal * (cp.normalImpulse - oldImpulse));
+		}
+	}
+}
+
+void ContactSolver::StoreImpulses(CollisionPairCache& pairs) const {
+	for (const ContactConstraint& c : contacts) {
+		CollisionPairCache::CollisionPair& pair = pairs.GetPair(c.pairIndex);
+		pair.ClearImpulses();
+		for (int j = 0; j < c.pointCount; ++j) {
+			const ContactConstraintPoint& cp = c.points[j];
+			pair.normalImpulses[j]		= cp.normalImpulse;
+			pair.frictionImpulses[j]	= c.tangents[0] * cp.tangentImpulse[0] + c.tangents[1] * cp.tangentImpulse[1];
+		}
+	}
+}
+
+/*
+Static objects are left well alone - an impulse wouldn't move them anyway,
+and they can be touched by several islands being solved at once.
+*/
+void ContactSolver::ApplyImpulse(ContactConstraint& c, const ContactConstraintPoint& p, const Vector3& impulse) const {
+	if (c.physA->GetInverseMass() > 0.0f) {
+		c.physA->ApplyLinearImpulse(-impulse);
+		c.physA->ApplyAngularImpulse(Vector3::Cross(p.relativeA, -impulse));
+	}
+	if (c.physB->GetInverseMass() > 0.0f) {
+		c.physB->ApplyLinearImpulse(impulse);
+		c.physB->ApplyAngularImpulse(Vector3::Cross(p.relativeB, impulse));
+	}
+}
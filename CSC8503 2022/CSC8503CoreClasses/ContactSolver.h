@@ -0,0 +1,91 @@
+#pragma once
+#include "CollisionPairCache.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class PhysicsObject;
+
+		/*
+		Rather than resolving each collision once, as soon as it's found, every
+		contact found in a physics step is gathered up here, and then they're all
+		solved together, a little at a time, over several iterations - alongside
+		the other constraints in the world. Each pass corrects the velocities a
+		bit more, so contacts that affect each other, like a stack of boxes, can
+		all settle down together.
+
+		Each pair's contact can have several points - one for each corner of a box
+		resting on a face - which are solved one after the other, sharing the
+		pair's normal and friction. The total impulse applied at each point is
+		remembered in the pair cache, and applied again straight away the next
+		time the same pair is solved, so a resting contact starts off already
+		close to the right answer.
+		*/
+		class ContactSolver {
+		public:
+			ContactSolver();
+			~ContactSolver();
+
+			void Clear();
+
+			//Adds a contact for the pair at this index of the cache
+			void AddContact(int pairIndex);
+
+			int GetContactCount() const {
+				return (int)contacts.size();
+			}
+
+			int GetContactPairIndex(int contact) const {
+				return contacts[contact].pairIndex;
+			}
+
+			//Works out each contact's effective mass and target velocity, then warm starts it
+			void PrepareContacts(CollisionPairCache& pairs, float dt);
+			//Solves just the contacts at these indices - contacts that share no bodies can be solved at the same time
+			void SolveContacts(const int* indices, int count);
+			//Writes the total impulses back into the pair cache, ready for next time
+			void StoreImpulses(CollisionPairCache& pairs) const;
+
+			void SetBaumgarteFactor(float factor) {
+				baumgarte = factor;
+			}
+
+			void SetPenetrationSlop(float slop) {
+				penetrationSlop = slop;
+			}
+
+		protected:
+			struct ContactConstraintPoint {
+				Vector3 relativeA;
+				Vector3 relativeB;
+
+				float	normalMass;
+				float	tangentMass[2];
+				float	velocityBias;
+
+				float	normalImpulse;
+				float	tangentImpulse[2];
+			};
+
+			struct ContactConstraint {
+				int				pairIndex;
+				PhysicsObject*	physA;
+				PhysicsObject*	physB;
+
+				Vector3 normal;
+				Vector3 tangents[2];
+				float	friction;
+
+				ContactConstraintPoint	points[CollisionDetection::CollisionInfo::MaxContactPoints];
+				int						pointCount;
+			};
+
+			void ApplyImpulse(ContactConstraint& c, const ContactConstraintPoint& p, const Vector3& impulse) const;
+
+			std::vector<ContactConstraint> contacts;
+
+			float baumgarte;
+			float penetrationSlop;
+			float restitutionThreshold;
+		};
+	}
+}
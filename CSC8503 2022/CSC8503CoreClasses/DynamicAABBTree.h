@@ -0,0 +1,709 @@
+#pragma once
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+#include "Vector3.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		A dynamic bounding volume hierarchy of axis aligned boxes, used as a persistent
+		broadphase. Unlike the QuadTree, which is rebuilt from scratch every physics
+		tick, proxies live in the tree for as long as their object does.
+
+		Every leaf stores a 'fat' box - the object's real box grown by a margin, and
+		stretched along the direction it is moving. As long as the object stays inside
+		its fat box, moving it costs a single containment test. When it escapes, the
+		leaf is either refitted in place (if its parent still encloses the new box) or
+		removed and reinserted, with the tree rebalanced on the way back up.
+
+		Nodes are kept in a flat pool with a free list, so once the pool has grown to
+		fit the scene, creating, moving and destroying proxies never allocates.
+		*/
+		template<class T>
+		class DynamicAABBTree {
+		public:
+			static const int NullNode = -1;
+
+			DynamicAABBTree(float fatMargin = 0.5f, float predictionScale = 2.0f) {
+				this->fatMargin			= fatMargin;
+				this->predictionScale	= predictionScale;
+				Clear();
+			}
+			~DynamicAABBTree() {
+			}
+
+			void Clear() {
+				nodes.clear();
+				moveBuffer.clear();
+				root		= NullNode;
+				freeList	= NullNode;
+				proxyCount	= 0;
+			}
+
+			int CreateProxy(const Vector3& pos, const Vector3& halfSize, T object) {
+				int proxy = AllocateNode();
+				Node& n = nodes[proxy];
+				n.min		= pos - halfSize - Vector3(fatMargin, fatMargin, fatMargin);
+				n.max		= pos + halfSize + Vector3(fatMargin, fatMargin, fatMargin);
+				n.object	= object;
+				n.height	= 0;
+				n.moved		= false;
+
+				InsertLeaf(proxy);
+				BufferMove(proxy);
+				proxyCount++;
+				return proxy;
+			}
+
+			struct BuildEntry {
+				Vector3 min;
+				Vector3 max;
+				T		object;
+			};
+
+			/*
+			Throws away everything in the tree, and builds it again from scratch
+			around the given boxes, for objects that aren't going to move - like a
+			level's walls. Rather than inserting them one at a time, each node's
+			boxes are split in two wherever the surface area heuristic says will
+			be cheapest to query, which gives a better tree. The boxes aren't
+			fattened, and aren't put in the move buffer. Each entry's proxy is its
+			index in entries.
+			*/
+			void Build(const std::vector<BuildEntry>& entries) {
+				Clear();
+				if (entries.empty()) {
+					return;
+				}
+				std::vector<int> leaves;
+				for (const BuildEntry& e : entries) {
+					int proxy = AllocateNode();
+					nodes[proxy].min	= e.min;
+					nodes[proxy].max	= e.max;
+					nodes[proxy].object	= e.object;
+					leaves.push_back(proxy);
+				}
+				proxyCount	= (int)entries.size();
+				root		= BuildNode(leaves, 0, (int)leaves.size(), 0);
+				nodes[root].parent = NullNode;
+			}
+
+			void DestroyProxy(int proxy) {
+				if (nodes[proxy].moved) {
+					for (int& i : moveBuffer) {
+						if (i == proxy) {
+							i = NullNode;
+						}
+					}
+				}
+				RemoveLeaf(proxy);
+				FreeNode(proxy);
+				proxyCount--;
+			}
+
+			/*
+			Returns true if the proxy's fat box had to change, in which case any
+			pairs involving it need to be found again.
+			*/
+			bool MoveProxy(int proxy, const Vector3& pos, const Vector3& halfSize, const Vector3& displacement) {
+				Node& n = nodes[proxy];
+
+				Vector3 tightMin = pos - halfSize;
+				Vector3 tightMax = pos + halfSize;
+
+				if (Contains(n.min, n.max, tightMin, tightMax)) {
+					return false; //Still inside its fat box, nothing to do
+				}
+
+				Vector3 margin(fatMargin, fatMargin, fatMargin);
+				Vector3 fatMin = tightMin - margin;
+				Vector3 fatMax = tightMax + margin;
+
+				//Stretch the box in the direction of travel, so fast movers don't
+				//immediately escape again next step
+				Vector3 predicted = displacement * predictionScale;
+				for (int i = 0; i < 3; ++i) {
+					if (predicted[i] < 0.0f) {
+						fatMin[i] += predicted[i];
+					}
+					else {
+						fatMax[i] += predicted[i];
+					}
+				}
+
+				int parent = n.parent;
+				if (parent != NullNode && Contains(nodes[parent].min, nodes[parent].max, fatMin, fatMax)) {
+					n.min = fatMin; //Refit - the ancestors still enclose the new box
+					n.max = fatMax;
+				}
+				else {
+					RemoveLeaf(proxy);
+					nodes[proxy].min = fatMin;
+					nodes[proxy].max = fatMax;
+					InsertLeaf(proxy);
+				}
+				BufferMove(proxy);
+				return true;
+			}
+
+			bool IsValidProxy(int proxy) const {
+				return proxy >= 0 && proxy < (int)nodes.size() && nodes[proxy].height == 0;
+			}
+
+			T GetObject(int proxy) const {
+				return nodes[proxy].object;
+			}
+
+			void GetFatAABB(int proxy, Vector3& outMin, Vector3& outMax) const {
+				outMin = nodes[proxy].min;
+				outMax = nodes[proxy].max;
+			}
+
+			bool WasMoved(int proxy) const {
+				return nodes[proxy].moved;
+			}
+
+			//Flags a proxy as needing its pairs found again
+			void BufferMove(int proxy) {
+				if (!nodes[proxy].moved) {
+					nodes[proxy].moved = true;
+					moveBuffer.push_back(proxy);
+				}
+			}
+
+			const std::vector<int>& GetMoveBuffer() const {
+				return moveBuffer;
+			}
+
+			void ClearMoveBuffer() {
+				for (int i : moveBuffer) {
+					if (i != NullNode) {
+						nodes[i].moved = false;
+					}
+				}
+				moveBuffer.clear();
+			}
+
+			int GetProxyCount() const {
+				return proxyCount;
+			}
+
+			int GetHeight() const {
+				return root == NullNode ? 0 : nodes[root].height;
+			}
+
+			/*
+			Calls func(proxy) for every leaf whose fat box overlaps the given box.
+			Returning false from func stops the query early.
+			*/
+			template<class Func>
+			void Query(const Vector3& boxMin, const Vector3& boxMax, Func&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				int					fixedStack[MaxStackDepth];
+				std::vector<int>	grownStack;
+				int* stack = fixedStack;
+				if (GetHeight() >= MaxStackDepth) {
+					grownStack.resize(GetHeight() + 1);
+					stack = grownStack.data();
+				}
+				int stackSize = 0;
+				stack[stackSize++] = root;
+
+				while (stackSize > 0) {
+					int index = stack[--stackSize];
+					const Node& n = nodes[index];
+
+					if (!Overlaps(n.min, n.max, boxMin, boxMax)) {
+						continue;
+					}
+					if (n.IsLeaf()) {
+						if (!func(index)) {
+							return;
+						}
+					}
+					else {
+						stack[stackSize++] = n.left;
+						stack[stackSize++] = n.right;
+					}
+				}
+			}
+
+			/*
+			Calls func(proxy, maxDistance) for every leaf whose fat box the ray
+			passes through within maxDistance of its origin, visiting the nearer
+			child of each node first. func returns how far along the ray to keep
+			looking - the distance to whatever it hit, so that boxes beyond that
+			are skipped, or maxDistance to carry on as before. Returning a negative
+			distance stops the cast.
+			*/
+			template<class Func>
+			void RayCast(const Vector3& origin, const Vector3& direction, float maxDistance, Func&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				//Axes the ray runs parallel to get a huge inverse rather than a division by zero
+				Vector3 invDirection;
+				for (int i = 0; i < 3; ++i) {
+					invDirection[i] = direction[i] != 0.0f ? 1.0f / direction[i] : FLT_MAX;
+				}
+
+				float entry;
+				if (!RayHitsBox(nodes[root].min, nodes[root].max, origin, invDirection, maxDistance, entry)) {
+					return;
+				}
+				int					fixedStack[MaxStackDepth];
+				float				fixedEntries[MaxStackDepth];
+				std::vector<int>	grownStack;
+				std::vector<float>	grownEntries;
+				int*	stack			= fixedStack;
+				float*	stackEntries	= fixedEntries;
+				if (GetHeight() >= MaxStackDepth) {
+					grownStack.resize(GetHeight() + 1);
+					grownEntries.resize(GetHeight() + 1);
+					stack			= grownStack.data();
+					stackEntries	= grownEntries.data();
+				}
+				int		stackSize = 0;
+				stack[stackSize]		= root;
+				stackEntries[stackSize]	= entry;
+				stackSize++;
+
+				while (stackSize > 0) {
+					--stackSize;
+					int index = stack[stackSize];
+					if (stackEntries[stackSize] > maxDistance) {
+						continue; //Something nearer has been hit since this was pushed
+					}
+					const Node& n = nodes[index];
+					if (n.IsLeaf()) {
+						maxDistance = func(index, maxDistance);
+						if (maxDistance < 0.0f) {
+							return;
+						}
+						continue;
+					}
+					float leftEntry;
+					float rightEntry;
+					bool hitLeft	= RayHitsBox(nodes[n.left].min, nodes[n.left].max, origin, invDirection, maxDistance, leftEntry);
+					bool hitRight	= RayHitsBox(nodes[n.right].min, nodes[n.right].max, origin, invDirection, maxDistance, rightEntry);
+
+					//The nearer child goes on last, so it's looked at first
+					if (hitLeft && hitRight && leftEntry < rightEntry) {
+						stack[stackSize] = n.right;	stackEntries[stackSize] = rightEntry;	stackSize++;
+						stack[stackSize] = n.left;	stackEntries[stackSize] = leftEntry;	stackSize++;
+						continue;
+					}
+					if (hitLeft) {
+						stack[stackSize] = n.left;	stackEntries[stackSize] = leftEntry;	stackSize++;
+					}
+					if (hitRight) {
+						stack[stackSize] = n.right;	stackEntries[stackSize] = rightEntry;	stackSize++;
+					}
+				}
+			}
+
+			template<class Func>
+			void OperateOnProxies(Func&& func) const {
+				for (int i = 0; i < (int)nodes.size(); ++i) {
+					if (nodes[i].height == 0) {
+						func(i, nodes[i].object);
+					}
+				}
+			}
+
+		protected:
+			/*
+			Going depth first, a query never has more than one node per level of
+			the tree waiting on its stack. A balanced tree's height grows with
+			log(n), so this covers any sensible tree without touching the heap,
+			but a taller one gets a stack allocated to fit it rather than
+			running off the end.
+			*/
+			static const int MaxStackDepth = 128;
+
+			struct Node {
+				Vector3 min;
+				Vector3 max;
+				T		object;
+
+				int		parent;	//Doubles as the next link while on the free list
+				int		left;
+				int		right;
+				int		height;	//0 for leaves, -1 for free nodes
+				bool	moved;
+
+				bool IsLeaf() const {
+					return left == NullNode;
+				}
+			};
+
+			static bool Overlaps(const Vector3& minA, const Vector3& maxA, const Vector3& minB, const Vector3& maxB) {
+				return	minA.x <= maxB.x && maxA.x >= minB.x &&
+						minA.y <= maxB.y && maxA.y >= minB.y &&
+						minA.z <= maxB.z && maxA.z >= minB.z;
+			}
+
+			static bool Contains(const Vector3& outerMin, const Vector3& outerMax, const Vector3& innerMin, const Vector3& innerMax) {
+				return	outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z &&
+						innerMax.x <= outerMax.x && innerMax.y <= outerMax.y && innerMax.z <= outerMax.z;
+			}
+
+			//Slab test - where the ray enters the box, if it does so before maxDistance
+			static bool RayHitsBox(const Vector3& min, const Vector3& max, const Vector3& origin, const Vector3& invDirection, float maxDistance, float& entry) {
+				float tEnter	= 0.0f;
+				float tExit		= maxDistance;
+				for (int i = 0; i < 3; ++i) {
+					float t0 = (min[i] - origin[i]) * invDirection[i];
+					float t1 = (max[i] - origin[i]) * invDirection[i];
+					tEnter	= std::max(tEnter, std::min(t0, t1));
+					tExit	= std::min(tExit, std::max(t0, t1));
+				}
+				entry = tEnter;
+				return tEnter <= tExit;
+			}
+
+			static float SurfaceArea(const Vector3& min, const Vector3& max) {
+				Vector3 d = max - min;
+				return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+			}
+
+			static Vector3 Min(const Vector3& a, const Vector3& b) {
+				return Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+			}
+
+			static Vector3 Max(const Vector3& a, const Vector3& b) {
+				return Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+			}
+
+			int AllocateNode() {
+				if (freeList == NullNode) {
+					nodes.emplace_back();
+					nodes.back().height = -1;
+					nodes.back().parent = NullNode;
+					freeList = (int)nodes.size() - 1;
+				}
+				int index = freeList;
+				freeList = nodes[index].parent;
+
+				Node& n = nodes[index];
+				n.parent	= NullNode;
+				n.left		= NullNode;
+				n.right		= NullNode;
+				n.height	= 0;
+				n.moved		= false;
+				return index;
+			}
+
+			void FreeNode(int index) {
+				nodes[index].parent = freeList;
+				nodes[index].height = -1;
+				freeList = index;
+			}
+
+			void RefitNode(int index) {
+				Node& n = nodes[index];
+				const Node& l = nodes[n.left];
+				const Node& r = nodes[n.right];
+				n.min		= Min(l.min, r.min);
+				n.max		= Max(l.max, r.max);
+				n.height	= 1 + std::max(l.height, r.height);
+			}
+
+			void InsertLeaf(int leaf) {
+				if (root == NullNode) {
+					root = leaf;
+					nodes[root].parent = NullNode;
+					return;
+				}
+
+				//Walk down the tree, picking whichever child gives the cheapest
+				//increase in surface area, until inserting here is cheaper than descending
+				Vector3 leafMin = nodes[leaf].min;
+				Vector3 leafMax = nodes[leaf].max;
+				int index = root;
+				while (!nodes[index].IsLeaf()) {
+					const Node& n = nodes[index];
+
+					float area			= SurfaceArea(n.min, n.max);
+					float combinedArea	= SurfaceArea(Min(n.min, leafMin), Max(n.max, leafMax));
+
+					float cost			= 2.0f * combinedArea;
+					float inheritedCost	= 2.0f * (combinedArea - area);
+
+					float costLeft	= ChildInsertCost(n.left, leafMin, leafMax) + inheritedCost;
+					float costRight	= ChildInsertCost(n.right, leafMin, leafMax) + inheritedCost;
+
+					if (cost < costLeft && cost < costRight) {
+						break;
+					}
+					index = (costLeft < costRight) ? n.left : n.right;
+				}
+
+				int sibling		= index;
+				int oldParent	= nodes[sibling].parent;
+				int newParent	= AllocateNode();
+
+				nodes[newParent].parent	= oldParent;
+				nodes[newParent].left	= sibling;
+				nodes[newParent].right	= leaf;
+				nodes[sibling].parent	= newParent;
+				nodes[leaf].parent		= newParent;
+				RefitNode(newParent);
+
+				if (oldParent != NullNode) {
+					if (nodes[oldParent].left == sibling) {
+						nodes[oldParent].left = newParent;
+					}
+					else {
+						nodes[oldParent].right = newParent;
+					}
+				}
+				else {
+					root = newParent;
+				}
+				FixUpwards(nodes[leaf].parent);
+			}
+
+			float ChildInsertCost(int child, const Vector3& leafMin, const Vector3& leafMax) const {
+				const Node& c = nodes[child];
+				float newArea = SurfaceArea(Min(c.min, leafMin), Max(c.max, leafMax));
+				if (c.IsLeaf()) {
+					return newArea;
+				}
+				return newArea - SurfaceArea(c.min, c.max);
+			}
+
+			/*
+			Builds the subtree over leaves[begin, end), returning its root. The
+			leaves' centres are sorted into bins along each axis, and the split is
+			made between whichever two bins give the lowest cost - the surface
+			area of each side, times how many leaves it holds. If the centres are
+			all in the same place, there's nothing to choose between, so the
+			leaves are just halved.
+
+			Lopsided boxes can make the heuristic peel off one leaf at a time,
+			so past MaxSAHDepth the leaves are split at their median centre
+			along the widest axis instead, which keeps the rest of the tree
+			(and the recursion building it) to log(n) deep.
+			*/
+			int BuildNode(std::vector<int>& leaves, int begin, int end, int depth) {
+				if (end - begin == 1) {
+					return leaves[begin];
+				}
+				Vector3 centreMin = Centre(leaves[begin]);
+				Vector3 centreMax = centreMin;
+				for (int i = begin + 1; i < end; ++i) {
+					centreMin = Min(centreMin, Centre(leaves[i]));
+					centreMax = Max(centreMax, Centre(leaves[i]));
+				}
+
+				float	bestCost	= FLT_MAX;
+				int		bestAxis	= -1;
+				int		bestSplit	= 0;
+				for (int axis = 0; axis < 3 && depth < MaxSAHDepth; ++axis) {
+					float extent = centreMax[axis] - centreMin[axis];
+					if (extent <= 0.0f) {
+						continue;
+					}
+					Bin bins[BuildBins];
+					for (int i = begin; i < end; ++i) {
+						bins[BinIndex(leaves[i], axis, centreMin[axis], extent)].Add(nodes[leaves[i]]);
+					}
+					//Sweeps in from the right first, so the left sweep can price up every split as it goes
+					float rightCosts[BuildBins];
+					Bin right;
+					for (int i = BuildBins - 1; i > 0; --i) {
+						right.Add(bins[i]);
+						rightCosts[i] = right.Cost();
+					}
+					Bin left;
+					for (int i = 0; i < BuildBins - 1; ++i) {
+						left.Add(bins[i]);
+						float cost = left.Cost() + rightCosts[i + 1];
+						if (left.count > 0 && left.count < end - begin && cost < bestCost) {
+							bestCost	= cost;
+							bestAxis	= axis;
+							bestSplit	= i;
+						}
+					}
+				}
+
+				int mid = (begin + end) / 2;
+				if (bestAxis >= 0) {
+					float extent = centreMax[bestAxis] - centreMin[bestAxis];
+					auto split = std::partition(leaves.begin() + begin, leaves.begin() + end, [&](int leaf) {
+						return BinIndex(leaf, bestAxis, centreMin[bestAxis], extent) <= bestSplit;
+					});
+					mid = (int)(split - leaves.begin());
+				}
+				else if (depth >= MaxSAHDepth) {
+					Vector3 extents	= centreMax - centreMin;
+					int		axis	= 0;
+					for (int i = 1; i < 3; ++i) {
+						if (extents[i] > extents[axis]) {
+							axis = i;
+						}
+					}
+					std::nth_element(leaves.begin() + begin, leaves.begin() + mid, leaves.begin() + end, [&](int a, int b) {
+						return Centre(a)[axis] < Centre(b)[axis];
+					});
+				}
+
+				int leftChild	= BuildNode(leaves, begin, mid, depth + 1);
+				int rightChild	= BuildNode(leaves, mid, end, depth + 1);
+				int parent		= AllocateNode();
+				nodes[parent].left			= leftChild;
+				nodes[parent].right			= rightChild;
+				nodes[leftChild].parent		= parent;
+				nodes[rightChild].parent	= parent;
+				RefitNode(parent);
+				return parent;
+			}
+
+			static const int BuildBins		= 16;
+			static const int MaxSAHDepth	= 64;
+
+			struct Bin {
+				Vector3 min		= Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+				Vector3 max		= Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+				int		count	= 0;
+
+				void Add(const Node& n) {
+					min = Min(min, n.min);
+					max = Max(max, n.max);
+					count++;
+				}
+				void Add(const Bin& b) {
+					min = Min(min, b.min);
+					max = Max(max, b.max);
+					count += b.count;
+				}
+				float Cost() const {
+					return count > 0 ? SurfaceArea(min, max) * count : 0.0f;
+				}
+			};
+
+			Vector3 Centre(int leaf) const {
+				return (nodes[leaf].min + nodes[leaf].max) * 0.5f;
+			}
+
+			int BinIndex(int leaf, int axis, float centreMin, float extent) const {
+				int bin = (int)((Centre(leaf)[axis] - centreMin) / extent * BuildBins);
+				return std::min(std::max(bin, 0), BuildBins - 1);
+			}
+
+			void RemoveLeaf(int leaf) {
+				if (leaf == root) {
+					root = NullNode;
+					return;
+				}
+				int parent		= nodes[leaf].parent;
+				int grandParent = nodes[parent].parent;
+				int sibling		= (nodes[parent].left == leaf) ? nodes[parent].right : nodes[parent].left;
+
+				if (grandParent != NullNode) {
+					if (nodes[grandParent].left == parent) {
+						nodes[grandParent].left = sibling;
+					}
+					else {
+						nodes[grandParent].right = sibling;
+					}
+					nodes[sibling].parent = grandParent;
+					FreeNode(parent);
+					FixUpwards(grandParent);
+				}
+				else {
+					root = sibling;
+					nodes[sibling].parent = NullNode;
+					FreeNode(parent);
+				}
+				nodes[leaf].parent = NullNode;
+			}
+
+			void FixUpwards(int index) {
+				while (index != NullNode) {
+					index = Balance(index);
+					RefitNode(index);
+					index = nodes[index].parent;
+				}
+			}
+
+			/*
+			If one side of node a is more than one level taller than the other, rotate
+			the taller child up into a's place. Returns the index now sitting where a was.
+			*/
+			int Balance(int a) {
+				Node& A = nodes[a];
+				if (A.IsLeaf() || A.height < 2) {
+					return a;
+				}
+				int b = A.left;
+				int c = A.right;
+				int balance = nodes[c].height - nodes[b].height;
+
+				if (balance > 1) {
+					return Rotate(a, c, true);
+				}
+				if (balance < -1) {
+					return Rotate(a, b, false);
+				}
+				return a;
+			}
+
+			//Promotes child 'up' of node a into a's place in the tree
+			int Rotate(int a, int up, bool upWasRight) {
+				Node& A = nodes[a];
+				Node& U = nodes[up];
+				int f = U.left;
+				int g = U.right;
+
+				U.left		= a;
+				U.parent	= A.parent;
+				A.parent	= up;
+
+				if (U.parent != NullNode) {
+					if (nodes[U.parent].left == a) {
+						nodes[U.parent].left = up;
+					}
+					else {
+						nodes[U.parent].right = up;
+					}
+				}
+				else {
+					root = up;
+				}
+
+				//Keep the taller grandchild up beside a, and hand the other to a
+				int keep	= (nodes[f].height > nodes[g].height) ? f : g;
+				int give	= (keep == f) ? g : f;
+
+				U.right = keep;
+				if (upWasRight) {
+					A.right = give;
+				}
+				else {
+					A.left = give;
+				}
+				nodes[give].parent = a;
+
+				RefitNode(a);
+				RefitNode(up);
+				return up;
+			}
+
+			std::vector<Node>	nodes;
+			std::vector<int>	moveBuffer;
+
+			int		root;
+			int		freeList;
+			int		proxyCount;
+
+			float	fatMargin;
+			float	predictionScale;
+		};
+	}
+}
@@ -0,0 +1,91 @@
+#include "ExplosionSystem.h"
+#include "Constraint.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "Profiler.h"
+
+using namespace NCL;
+using namespace NCL::CSC8503;
+
+ExplosionSystem::ExplosionSystem(GameWorld& g) : world(g) {
+}
+
+ExplosionSystem::~ExplosionSystem() {
+}
+
+void ExplosionSystem::Detonate(const Vector3& position, float radius, float impulse, GameObject* spent) {
+	pending.push_back({ position, radius, impulse, spent });
+}
+
+void ExplosionSystem::Clear() {
+	pending.clear();
+}
+
+void ExplosionSystem::Update() {
+	PROFILE_SCOPE("ExplosionSystem::Update");
+	if (pending.empty()) {
+		return;
+	}
+	queries.clear();
+	for (const Explosion& e : pending) {
+		queries.push_back(SceneQuery::MakeOverlapSphere(e.position, e.radius, SceneQuery::AllLayers, e.spent));
+	}
+	caught.clear();
+	SceneQuery::RunQueries(world, queries, caught);
+
+	//Falls off linearly, from the full impulse at the centre to nothing at the edge
+	for (int i = 0; i < (int)pending.size(); ++i) {
+		const Explosion& e = pending[i];
+		for (int j = 0; j < queries[i].resultCount; ++j) {
+			GameObject*		o		= caught[queries[i].firstResult + j];
+			PhysicsObject*	physics	= o->GetPhysicsObject();
+			if (!physics || physics->GetInverseMass() == 0.0f) {
+				continue;
+			}
+			Vector3 offset		= o->GetTransform().GetPosition() - e.position;
+			float	distance	= offset.Length();
+			float	falloff		= 1.0f - std::min(distance / e.radius, 1.0f);
+			if (falloff <= 0.0f || distance == 0.0f) {
+				continue;
+			}
+			physics->ApplyLinearImpulse(offset * (e.impulse * falloff / distance));
+		}
+	}
+
+	//The same object might have set off more than one explosion, but can only be deleted once
+	spentObjects.clear();
+	for (const Explosion& e : pending) {
+		if (e.spent) {
+			spentObjects.push_back(e.spent);
+		}
+	}
+	std::sort(spentObjects.begin(), spentObjects.end());
+	spentObjects.erase(std::unique(spentObjects.begin(), spentObjects.end()), spentObjects.end());
+	for (GameObject* o : spentObjects) {
+		if (onRemove) {
+			onRemove(o);
+		}
+		RemoveConstraintsOf(o);
+		world.RemoveGameObject(o, true);
+	}
+	pending.clear();
+}
+
+void ExplosionSystem::RemoveConstraintsOf(GameObject* o) {
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	world.GetConstraintIterators(first, last);
+
+	spentConstraints.clear();
+	for (auto i = first; i != last; ++i) {
+		GameObject* a = nullptr;
+		GameObject* b = nullptr;
+		(*i)->GetObjects(a, b);
+		if (a == o || b == o) {
+			spentConstraints.push_back(*i);
+		}
+	}
+	for (Constraint* c : spentConstraints) {
+		world.RemoveConstraint(c, true);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "SceneQuery.h"
+
+#include <functional>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Pushes everything near an explosion away from it, harder the closer it
+		is to the centre, and takes whatever exploded (like a spent rocket) out
+		of the world.
+
+		Explosions usually start in an OnCollisionBegin, which the PhysicsSystem
+		calls part way through going over its collisions, so nothing can be
+		pushed or removed there and then - Detonate only remembers them. Update
+		then finds everything in range of all of that frame's explosions with
+		one batch of sphere overlap queries, so each explosion only costs as
+		much as what's near it, and hands out all of their impulses in one go.
+
+		Any constraint tied to a spent object is removed and deleted along with
+		it. Anything else still pointing at a spent object (a selection, a
+		camera target) has to let go of it in the removal callback.
+		*/
+		class ExplosionSystem {
+		public:
+			ExplosionSystem(GameWorld& world);
+			~ExplosionSystem();
+
+			//The spent object is removed from the world and deleted once the explosion has gone off
+			void Detonate(const Vector3& position, float radius, float impulse, GameObject* spent = nullptr);
+
+			//Call after the physics has updated, so its collision list isn't pointing at anything removed
+			void Update();
+
+			//Forgets any explosions that haven't gone off yet, for when the world is reset
+			void Clear();
+
+			//Called with each spent object just before it is deleted
+			void SetRemovalCallback(const std::function<void(GameObject*)>& callback) {
+				onRemove = callback;
+			}
+
+		protected:
+			struct Explosion {
+				Vector3		position;
+				float		radius;
+				float		impulse;
+				GameObject*	spent;
+			};
+
+			void RemoveConstraintsOf(GameObject* o);
+
+			GameWorld& world;
+
+			std::function<void(GameObject*)> onRemove;
+
+			std::vector<Explosion>			pending;
+			std::vector<SceneQuery::Query>	queries;
+			std::vector<GameObject*>		caught;
+			std::vector<GameObject*>		spentObjects;
+			std::vector<Constraint*>		spentConstraints;
+		};
+	}
+}
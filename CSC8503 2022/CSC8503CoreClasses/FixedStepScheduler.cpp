@@ -0,0 +1,76 @@
+#include "FixedStepScheduler.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+FixedStepScheduler::FixedStepScheduler(int idealHZ, int maxSubsteps) {
+	this->idealHZ		= std::max(1, idealHZ);
+	this->maxSubsteps	= std::max(1, maxSubsteps);
+	minHZ			= std::min(15, this->idealHZ);
+	costSmoothing	= 0.1f;
+	maxLoad			= 0.8f;
+	Reset();
+}
+
+FixedStepScheduler::~FixedStepScheduler() {
+}
+
+void FixedStepScheduler::Reset() {
+	SetStepHZ(idealHZ);
+	accumulator		= 0.0f;
+	averageStepCost	= 0.0f;
+}
+
+void FixedStepScheduler::SetIdealHZ(int hz) {
+	idealHZ	= std::max(1, hz);
+	minHZ	= std::min(minHZ, idealHZ);
+	SetStepHZ(std::min(stepHZ, idealHZ));
+}
+
+void FixedStepScheduler::SetStepHZ(int hz) {
+	stepHZ = hz;
+	stepDT = 1.0f / hz;
+}
+
+/*
+Time that won't fit into this frame's steps is thrown away, rather than
+being saved up for later frames, which would only be too busy too.
+*/
+int FixedStepScheduler::BeginFrame(float dt) {
+	accumulator += dt;
+
+	int steps = (int)(accumulator / stepDT);
+	if (steps > maxSubsteps) {
+		steps		= maxSubsteps;
+		accumulator = stepDT * steps;
+	}
+	accumulator -= stepDT * steps;
+	return steps;
+}
+
+/*
+The load is the fraction of real time that stepping is taking up. Halving
+the step rate halves it, and doubling the step rate doubles it, so the rate
+is only raised when the doubled load would still be comfortably under the
+limit - otherwise it would just be dropped again straight away.
+*/
+void FixedStepScheduler::EndFrame(float stepSeconds, int stepsTaken) {
+	if (stepsTaken <= 0) {
+		return;
+	}
+	float stepCost = stepSeconds / stepsTaken;
+	if (averageStepCost == 0.0f) {
+		averageStepCost = stepCost;
+	}
+	else {
+		averageStepCost += (stepCost - averageStepCost) * costSmoothing;
+	}
+
+	float load = averageStepCost / stepDT;
+	if (load > maxLoad && stepHZ > minHZ) {
+		SetStepHZ(std::max(stepHZ / 2, minHZ));
+	}
+	else if (load * 2.0f < maxLoad * 0.5f && stepHZ < idealHZ) {
+		SetStepHZ(std::min(stepHZ * 2, idealHZ));
+	}
+}
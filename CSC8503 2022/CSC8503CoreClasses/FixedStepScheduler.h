@@ -0,0 +1,95 @@
+#pragma once
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Decides how many fixed size steps the physics should take each frame.
+		Frame time is added to an accumulator, and a step is taken for each
+		whole step's worth of time in it - whatever's left over is how far
+		through the next step we are, which can be used to blend between the
+		last two steps when rendering.
+
+		If stepping is taking longer than the time it simulates, it would only
+		fall further and further behind, so the step rate is halved until it
+		can keep up, and doubled again (up to the ideal rate) once there's
+		plenty of time spare. Step times are smoothed out over several frames,
+		so one slow frame doesn't send the step rate up and down. There's also
+		a limit on how many steps a single frame can take - past that, the
+		simulation just runs slower than real time for a while.
+		*/
+		class FixedStepScheduler {
+		public:
+			FixedStepScheduler(int idealHZ = 120, int maxSubsteps = 8);
+			~FixedStepScheduler();
+
+			//Adds on this frame's time, and returns how many steps to take
+			int BeginFrame(float dt);
+			//Lets the step rate adapt to how long those steps actually took
+			void EndFrame(float stepSeconds, int stepsTaken);
+
+			void Reset();
+
+			float GetStepDT() const {
+				return stepDT;
+			}
+
+			int GetStepHZ() const {
+				return stepHZ;
+			}
+
+			//How far between the last step and the next one the current frame is, from 0 to 1
+			float GetInterpolationAlpha() const {
+				return std::min(accumulator / stepDT, 1.0f);
+			}
+
+			//Average time taken by a single step, in seconds
+			float GetAverageStepCost() const {
+				return averageStepCost;
+			}
+
+			void SetIdealHZ(int hz);
+
+			int GetIdealHZ() const {
+				return idealHZ;
+			}
+
+			//The step rate will never be dropped below this
+			void SetMinHZ(int hz) {
+				minHZ = std::max(1, std::min(hz, idealHZ));
+			}
+
+			void SetMaxSubsteps(int steps) {
+				maxSubsteps = std::max(1, steps);
+			}
+
+			int GetMaxSubsteps() const {
+				return maxSubsteps;
+			}
+
+			//The fraction of real time stepping may take up before the rate is dropped
+			void SetMaxLoad(float load) {
+				maxLoad = load;
+			}
+
+			//How much of each new step time goes into the average, from 0 to 1
+			void SetCostSmoothing(float smoothing) {
+				costSmoothing = smoothing;
+			}
+
+		protected:
+			void SetStepHZ(int hz);
+
+			int		idealHZ;
+			int		minHZ;
+			int		stepHZ;
+			int		maxSubsteps;
+			float	stepDT;
+
+			float	accumulator;
+
+			float	averageStepCost;
+			float	costSmoothing;
+			float	maxLoad;
+		};
+	}
+}
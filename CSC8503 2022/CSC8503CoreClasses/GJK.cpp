@@ -0,0 +1,529 @@
+#include "GJK.h"
+#include "CollisionVolume.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "CapsuleVolume.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const int	MaxIterations	= 32;
+	const float	Epsilon			= 0.0001f;
+
+	const int	MaxPolytopeVertices	= 64;
+	const int	MaxPolytopeFaces	= 128;
+}
+
+GJK::Shape GJK::MakeShape(const CollisionVolume& volume, const Transform& worldTransform) {
+	Shape s;
+	s.position		= worldTransform.GetPosition();
+	s.halfSizes		= Vector3();
+	s.halfLength	= 0.0f;
+	s.radius		= 0.0f;
+	s.type			= volume.type;
+
+	Matrix3 orientation = volume.type == VolumeType::AABB ? Matrix3() : Matrix3(worldTransform.GetOrientation());
+	for (int i = 0; i < 3; ++i) {
+		s.axes[i] = orientation.GetColumn(i);
+	}
+
+	switch (volume.type) {
+		case VolumeType::AABB: {
+			s.halfSizes = ((const AABBVolume&)volume).GetHalfDimensions();
+		}break;
+		case VolumeType::OBB: {
+			s.halfSizes = ((const OBBVolume&)volume).GetHalfDimensions();
+		}break;
+		case VolumeType::Sphere: {
+			s.radius = ((const SphereVolume&)volume).GetRadius();
+		}break;
+		case VolumeType::Capsule: {
+			const CapsuleVolume& capsule = (const CapsuleVolume&)volume;
+			//The half height reaches the tip of the end caps, not their centres
+			s.radius		= capsule.GetRadius();
+			s.halfLength	= std::max(capsule.GetHalfHeight() - capsule.GetRadius(), 0.0f);
+		}break;
+		default: break;
+	}
+	return s;
+}
+
+Vector3 GJK::Shape::CoreSupport(const Vector3& dir) const {
+	switch (type) {
+		case VolumeType::AABB:
+		case VolumeType::OBB: {
+			Vector3 point = position;
+			for (int i = 0; i < 3; ++i) {
+				point += axes[i] * (Vector3::Dot(axes[i], dir) >= 0.0f ? halfSizes[i] : -halfSizes[i]);
+			}
+			return point;
+		}
+		case VolumeType::Capsule: {
+			return position + axes[1] * (Vector3::Dot(axes[1], dir) >= 0.0f ? halfLength : -halfLength);
+		}
+		default: {
+			return position;
+		}
+	}
+}
+
+GJK::SimplexVertex GJK::Support(const Shape& a, const Shape& b, const Vector3& dir) {
+	SimplexVertex v;
+	v.pointA	= a.CoreSupport(dir);
+	v.pointB	= b.CoreSupport(-dir);
+	v.w			= v.pointA - v.pointB;
+	v.weight	= 1.0f;
+	return v;
+}
+
+Vector3 GJK::Simplex::ClosestPoint() const {
+	Vector3 point;
+	for (int i = 0; i < count; ++i) {
+		point += vertices[i].w * vertices[i].weight;
+	}
+	return point;
+}
+
+void GJK::Simplex::GetWitnessPoints(Vector3& onA, Vector3& onB) const {
+	onA = Vector3();
+	onB = Vector3();
+	for (int i = 0; i < count; ++i) {
+		onA += vertices[i].pointA * vertices[i].weight;
+		onB += vertices[i].pointB * vertices[i].weight;
+	}
+}
+
+void GJK::Simplex::SolveSegment() {
+	const Vector3& a = vertices[0].w;
+	const Vector3& b = vertices[1].w;
+	Vector3 ab = b - a;
+
+	float t = -Vector3::Dot(a, ab);
+	if (t <= 0.0f) {
+		vertices[0].weight = 1.0f;
+		count = 1;
+		return;
+	}
+	float lengthSquared = ab.LengthSquared();
+	if (t >= lengthSquared) {
+		vertices[0] = vertices[1];
+		vertices[0].weight = 1.0f;
+		count = 1;
+		return;
+	}
+	t /= lengthSquared;
+	vertices[0].weight = 1.0f - t;
+	vertices[1].weight = t;
+}
+
+/*
+Which of the triangle's vertices, edges or face the origin is closest to,
+worked out from the signs of a few dot products rather than by projecting
+onto each one - this is the version from Ericson's Real-Time Collision
+Detection.
+*/
+void GJK::Simplex::SolveTriangle() {
+	const Vector3 a = vertices[0].w;
+	const Vector3 b = vertices[1].w;
+	const Vector3 c = vertices[2].w;
+
+	Vector3 ab = b - a;
+	Vector3 ac = c - a;
+
+	float d1 = -Vector3::Dot(ab, a);
+	float d2 = -Vector3::Dot(ac, a);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		vertices[0].weight = 1.0f;
+		count = 1;
+		return;
+	}
+
+	float d3 = -Vector3::Dot(ab, b);
+	float d4 = -Vector3::Dot(ac, b);
+	if (d3 >= 0.0f && d4 <= d3) {
+		vertices[0] = vertices[1];
+		vertices[0].weight = 1.0f;
+		count = 1;
+		return;
+	}
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		float v = d1 / (d1 - d3);
+		vertices[0].weight = 1.0f - v;
+		vertices[1].weight = v;
+		count = 2;
+		return;
+	}
+
+	float d5 = -Vector3::Dot(ab, c);
+	float d6 = -Vector3::Dot(ac, c);
+	if (d6 >= 0.0f && d5 <= d6) {
+		vertices[0] = vertices[2];
+		vertices[0].weight = 1.0f;
+		count = 1;
+		return;
+	}
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		float w = d2 / (d2 - d6);
+		vertices[1] = vertices[2];
+		vertices[0].weight = 1.0f - w;
+		vertices[1].weight = w;
+		count = 2;
+		return;
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		vertices[0] = vertices[1];
+		vertices[1] = vertices[2];
+		vertices[0].weight = 1.0f - w;
+		vertices[1].weight = w;
+		count = 2;
+		return;
+	}
+
+	float denom = va + vb + vc;
+	if (denom <= 0.0f) { //Zero area - fall back to the longest edge
+		count = 2;
+		SolveSegment();
+		return;
+	}
+	float v = vb / denom;
+	float w = vc / denom;
+	vertices[0].weight = 1.0f - v - w;
+	vertices[1].weight = v;
+	vertices[2].weight = w;
+}
+
+/*
+The origin is inside the tetrahedron if it's on the same side of every face
+as the vertex opposite it. If it's outside of any, the closest point is on
+one of the faces it's outside of.
+*/
+bool GJK::Simplex::SolveTetrahedron() {
+	static const int faces[4][4] = {
+		{0, 1, 2, 3},
+		{0, 2, 3, 1},
+		{0, 3, 1, 2},
+		{1, 3, 2, 0}
+	};
+
+	Simplex best;
+	float	bestDistance	= FLT_MAX;
+	bool	outside			= false;
+
+	for (int i = 0; i < 4; ++i) {
+		const Vector3& a = vertices[faces[i][0]].w;
+		const Vector3& b = vertices[faces[i][1]].w;
+		const Vector3& c = vertices[faces[i][2]].w;
+		const Vector3& d = vertices[faces[i][3]].w;
+
+		Vector3 normal = Vector3::Cross(b - a, c - a);
+		float signOrigin	= -Vector3::Dot(a, normal);
+		float signOpposite	= Vector3::Dot(d - a, normal);
+
+		//A flat tetrahedron can't contain anything, so check all of its faces
+		if (signOrigin * signOpposite >= 0.0f && fabs(signOpposite) > Epsilon * Epsilon) {
+			continue;
+		}
+		outside = true;
+
+		Simplex face;
+		face.vertices[0] = vertices[faces[i][0]];
+		face.vertices[1] = vertices[faces[i][1]];
+		face.vertices[2] = vertices[faces[i][2]];
+		face.count = 3;
+		face.SolveTriangle();
+
+		float distance = face.ClosestPoint().LengthSquared();
+		if (distance < bestDistance) {
+			bestDistance	= distance;
+			best			= face;
+		}
+	}
+	if (!outside) {
+		return false;
+	}
+	*this = best;
+	return true;
+}
+
+bool GJK::Simplex::Solve() {
+	switch (count) {
+		case 1: vertices[0].weight = 1.0f; return true;
+		case 2: SolveSegment();		return true;
+		case 3: SolveTriangle();	return true;
+		case 4: return SolveTetrahedron();
+	}
+	return true;
+}
+
+bool GJK::Distance(const Shape& a, const Shape& b, Simplex& simplex, Vector3& searchDirection, Vector3& onA, Vector3& onB) {
+	Vector3 dir = searchDirection;
+	if (dir.LengthSquared() < Epsilon * Epsilon) {
+		dir = b.position - a.position; //Towards the origin from the middle of the Minkowski difference
+		if (dir.LengthSquared() < Epsilon * Epsilon) {
+			dir = Vector3(0, 1, 0);
+		}
+	}
+	simplex.vertices[0] = Support(a, b, dir);
+	simplex.count		= 1;
+
+	for (int i = 0; i < MaxIterations; ++i) {
+		if (!simplex.Solve()) {
+			return false;
+		}
+		Vector3 closest = simplex.ClosestPoint();
+		float	closestSquared = closest.LengthSquared();
+		if (closestSquared < Epsilon * Epsilon) {
+			return false; //Touching is as good as overlapping
+		}
+		dir = -closest;
+
+		SimplexVertex v = Support(a, b, dir);
+		//If the new vertex gets no nearer the origin than we already are, we're done
+		if (closestSquared - Vector3::Dot(v.w, closest) <= Epsilon * closestSquared) {
+			break;
+		}
+		bool duplicate = false;
+		for (int j = 0; j < simplex.count; ++j) {
+			if ((simplex.vertices[j].w - v.w).LengthSquared() < Epsilon * Epsilon) {
+				duplicate = true;
+			}
+		}
+		if (duplicate) {
+			break;
+		}
+		simplex.vertices[simplex.count++] = v;
+	}
+	searchDirection = dir;
+	simplex.GetWitnessPoints(onA, onB);
+	return true;
+}
+
+/*
+EPA - the Expanding Polytope Algorithm. GJK leaves behind a tetrahedron
+around the origin, inside the Minkowski difference. Its face nearest the
+origin is pushed outwards to the furthest support point in that direction,
+and this repeats until a face can't be pushed any further - that face is
+then on the surface of the Minkowski difference, and its distance from the
+origin is how far the shapes overlap.
+*/
+bool GJK::PenetrationDepth(const Shape& a, const Shape& b, const Simplex& simplex, Vector3& normal, float& depth, Vector3& onA, Vector3& onB) {
+	struct Face {
+		int		indices[3];
+		Vector3 normal;
+		float	distance;
+	};
+	struct Edge {
+		int indices[2];
+	};
+
+	SimplexVertex	vertices[MaxPolytopeVertices];
+	Face			faces[MaxPolytopeFaces];
+	Edge			edges[MaxPolytopeFaces];
+	int vertexCount = simplex.count;
+	int faceCount	= 0;
+
+	for (int i = 0; i < simplex.count; ++i) {
+		vertices[i] = simplex.vertices[i];
+	}
+
+	//If GJK stopped because the cores were just touching, the simplex might not be a tetrahedron yet
+	auto TryAddVertex = [&](const Vector3& dir) {
+		SimplexVertex v = Support(a, b, dir);
+		for (int i = 0; i < vertexCount; ++i) {
+			if ((vertices[i].w - v.w).LengthSquared() < Epsilon * Epsilon) {
+				return false;
+			}
+		}
+		if (vertexCount == 2) {
+			Vector3 line = vertices[1].w - vertices[0].w;
+			if (Vector3::Cross(line, v.w - vertices[0].w).LengthSquared() < Epsilon * Epsilon * line.LengthSquared()) {
+				return false;
+			}
+		}
+		if (vertexCount == 3) {
+			Vector3 n = Vector3::Cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w);
+			float offset = Vector3::Dot(v.w - vertices[0].w, n);
+			if (offset * offset < Epsilon * Epsilon * n.LengthSquared()) {
+				return false;
+			}
+		}
+		vertices[vertexCount++] = v;
+		return true;
+	};
+
+	static const Vector3 searchAxes[3] = { Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1) };
+	for (int i = 0; i < 3 && vertexCount == 1; ++i) {
+		TryAddVertex(searchAxes[i]) || TryAddVertex(-searchAxes[i]);
+	}
+	for (int i = 0; i < 3 && vertexCount == 2; ++i) {
+		Vector3 dir = Vector3::Cross(vertices[1].w - vertices[0].w, searchAxes[i]);
+		if (dir.LengthSquared() > Epsilon * Epsilon) {
+			TryAddVertex(dir) || TryAddVertex(-dir);
+		}
+	}
+	if (vertexCount == 3) {
+		Vector3 dir = Vector3::Cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w);
+		TryAddVertex(dir) || TryAddVertex(-dir);
+	}
+	if (vertexCount < 4) {
+		return false; //The Minkowski difference is flat, so there's no single way out of it
+	}
+
+	auto MakeFace = [&](int i0, int i1, int i2, Face& face) {
+		Vector3 n = Vector3::Cross(vertices[i1].w - vertices[i0].w, vertices[i2].w - vertices[i0].w);
+		float length = n.Length();
+		if (length < Epsilon * Epsilon) {
+			return false;
+		}
+		face.indices[0] = i0;
+		face.indices[1] = i1;
+		face.indices[2] = i2;
+		face.normal		= n / length;
+		face.distance	= Vector3::Dot(face.normal, vertices[i0].w);
+		return true;
+	};
+
+	Vector3 centre = (vertices[0].w + vertices[1].w + vertices[2].w + vertices[3].w) * 0.25f;
+	static const int tetrahedron[4][3] = { {0, 1, 2}, {0, 2, 3}, {0, 3, 1}, {1, 3, 2} };
+	for (int i = 0; i < 4; ++i) {
+		const int* t = tetrahedron[i];
+		//Wind every face so that its normal points outwards
+		bool outwards = Vector3::Dot(Vector3::Cross(vertices[t[1]].w - vertices[t[0]].w, vertices[t[2]].w - vertices[t[0]].w), vertices[t[0]].w - centre) >= 0.0f;
+		if (!MakeFace(t[0], outwards ? t[1] : t[2], outwards ? t[2] : t[1], faces[faceCount])) {
+			return false;
+		}
+		faceCount++;
+	}
+
+	Face closest = faces[0];
+	for (int iteration = 0; iteration < MaxIterations; ++iteration) {
+		closest = faces[0];
+		for (int i = 1; i < faceCount; ++i) {
+			if (faces[i].distance < closest.distance) {
+				closest = faces[i];
+			}
+		}
+		SimplexVertex v = Support(a, b, closest.normal);
+		if (Vector3::Dot(v.w, closest.normal) - closest.distance < Epsilon || vertexCount == MaxPolytopeVertices) {
+			break;
+		}
+		int newIndex = vertexCount;
+		vertices[vertexCount++] = v;
+
+		//Remove every face the new vertex can see, remembering the edges around the hole they leave
+		int edgeCount = 0;
+		for (int i = 0; i < faceCount; ) {
+			Face& f = faces[i];
+			if (Vector3::Dot(f.normal, v.w - vertices[f.indices[0]].w) <= 0.0f) {
+				++i;
+				continue;
+			}
+			for (int e = 0; e < 3; ++e) {
+				int from	= f.indices[e];
+				int to		= f.indices[(e + 1) % 3];
+				bool shared = false;
+				for (int j = 0; j < edgeCount; ++j) {
+					if (edges[j].indices[0] == to && edges[j].indices[1] == from) {
+						edges[j] = edges[--edgeCount];
+						shared = true;
+						break;
+					}
+				}
+				if (!shared && edgeCount < MaxPolytopeFaces) {
+					edges[edgeCount++] = { from, to };
+				}
+			}
+			faces[i] = faces[--faceCount];
+		}
+		for (int i = 0; i < edgeCount && faceCount < MaxPolytopeFaces; ++i) {
+			if (MakeFace(edges[i].indices[0], edges[i].indices[1], newIndex, faces[faceCount])) {
+				faceCount++;
+			}
+		}
+		if (faceCount == 0) {
+			return false;
+		}
+	}
+
+	normal	= closest.normal;
+	depth	= std::max(closest.distance, 0.0f);
+
+	//Where the origin projects onto the closest face, as a mix of its corners
+	const SimplexVertex& v0 = vertices[closest.indices[0]];
+	const SimplexVertex& v1 = vertices[closest.indices[1]];
+	const SimplexVertex& v2 = vertices[closest.indices[2]];
+
+	Vector3 e0 = v1.w - v0.w;
+	Vector3 e1 = v2.w - v0.w;
+	Vector3 p  = normal * closest.distance - v0.w;
+
+	float d00 = Vector3::Dot(e0, e0);
+	float d01 = Vector3::Dot(e0, e1);
+	float d11 = Vector3::Dot(e1, e1);
+	float d20 = Vector3::Dot(p, e0);
+	float d21 = Vector3::Dot(p, e1);
+	float denom = d00 * d11 - d01 * d01;
+
+	float u = 1.0f / 3.0f;
+	float w = 1.0f / 3.0f;
+	if (fabs(denom) > Epsilon * Epsilon) {
+		u = (d11 * d20 - d01 * d21) / denom;
+		w = (d00 * d21 - d01 * d20) / denom;
+	}
+	float t = 1.0f - u - w;
+
+	onA = v0.pointA * t + v1.pointA * u + v2.pointA * w;
+	onB = v0.pointB * t + v1.pointB * u + v2.pointB * w;
+	return true;
+}
+
+bool GJK::Intersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB,
+	CollisionDetection::CollisionInfo& collisionInfo, Vector3& searchDirection) {
+	Shape a = MakeShape(volumeA, worldTransformA);
+	Shape b = MakeShape(volumeB, worldTransformB);
+
+	float radii = a.radius + b.radius;
+
+	Simplex simplex;
+	Vector3 onA;
+	Vector3 onB;
+	Vector3 normal;
+	float	penetration;
+
+	if (Distance(a, b, simplex, searchDirection, onA, onB)) {
+		Vector3 between		= onB - onA;
+		float	distance	= between.Length();
+		if (distance >= radii) {
+			return false;
+		}
+		normal		= between / distance;
+		penetration = radii - distance;
+	}
+	else {
+		float depth = 0.0f;
+		if (!PenetrationDepth(a, b, simplex, normal, depth, onA, onB)) {
+			//Cores that line up exactly, like two parallel capsules - push them apart between their centres
+			onA		= a.position;
+			onB		= b.position;
+			normal	= b.position - a.position;
+			normal	= normal.LengthSquared() > Epsilon * Epsilon ? normal.Normalised() : Vector3(0, 1, 0);
+		}
+		penetration = depth + radii;
+	}
+
+	Vector3 pointA = onA + normal * a.radius;
+	Vector3 pointB = onB - normal * b.radius;
+
+	collisionInfo.AddContactPoint(pointA - a.position, pointB - b.position, normal, penetration);
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL {
+	/*
+	Collision between any two convex volumes, using nothing about them but
+	their support functions - the point of the shape furthest along a given
+	direction. A new shape only needs a support function in MakeShape to
+	collide against everything else.
+
+	Rounded shapes are split into a core and a radius around it - a sphere is
+	a point, and a capsule a line segment, with a radius. GJK finds how far
+	apart the two cores are, and if that's less than the two radii the shapes
+	are touching, with the normal running between the cores' closest points.
+	Only if the cores themselves overlap is EPA needed to find how far they
+	have to be pushed apart, which is both slower and less precise.
+
+	GJK starts searching in the direction it finished in last time for the
+	same pair, if it's given one - objects don't turn much between steps, so
+	it's usually close to the answer already, and few iterations are needed.
+	*/
+	class GJK {
+	public:
+		//searchDirection is where to start from, and is given back where it finished, for next time
+		static bool Intersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+			const CollisionVolume& volumeB, const Transform& worldTransformB,
+			CollisionDetection::CollisionInfo& collisionInfo, Vector3& searchDirection);
+
+		static constexpr bool HasSupportFunction(VolumeType type) {
+			switch (type) {
+				case VolumeType::AABB:
+				case VolumeType::OBB:
+				case VolumeType::Sphere:
+				case VolumeType::Capsule:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+	protected:
+		struct Shape {
+			Vector3		position;
+			Vector3		axes[3];	//World space directions of the volume's local axes
+			Vector3		halfSizes;	//For boxes
+			float		halfLength;	//For capsules, along local Y
+			float		radius;		//Added all the way around the core
+			VolumeType	type;
+
+			Vector3 CoreSupport(const Vector3& dir) const;
+		};
+
+		//One corner of the Minkowski difference, and the points on each shape it came from
+		struct SimplexVertex {
+			Vector3 pointA;
+			Vector3 pointB;
+			Vector3 w;		//pointA - pointB
+			float	weight = 0.0f;	//How much of the closest point it makes up
+		};
+
+		struct Simplex {
+			SimplexVertex	vertices[4];
+			int				count = 0;
+
+			Vector3 ClosestPoint() const;
+			void	GetWitnessPoints(Vector3& onA, Vector3& onB) const;
+
+			//Cuts the simplex down to the feature closest to the origin, returning false if it contains it
+			bool	Solve();
+
+		protected:
+			void	SolveSegment();
+			void	SolveTriangle();
+			bool	SolveTetrahedron();
+		};
+
+		static Shape MakeShape(const CollisionVolume& volume, const Transform& worldTransform);
+
+		static SimplexVertex Support(const Shape& a, const Shape& b, const Vector3& dir);
+
+		//Returns false if the cores overlap, otherwise fills in the closest points between them
+		static bool Distance(const Shape& a, const Shape& b, Simplex& simplex, Vector3& searchDirection, Vector3& onA, Vector3& onB);
+
+		//How far, and which way, cores that overlap have to move to stop overlapping
+		static bool PenetrationDepth(const Shape& a, const Shape& b, const Simplex& simplex, Vector3& normal, float& depth, Vector3& onA, Vector3& onB);
+
+	private:
+		GJK()	{}
+		~GJK()	{}
+	};
+}
@@ -1,4 +1,5 @@
 #include "GameClient.h"
+#include "Profiler.h"
 #include "./enet/enet.h"
 using namespace NCL;
 using namespace CSC8503;
@@ -22,6 +23,7 @@ bool GameClient::Connect(uint8_t a, uint8_t b, uint8_t c, uint8_t d, int portNum
 }
 
 void GameClient::UpdateClient() {
+	PROFILE_SCOPE("GameClient::UpdateClient");
 	if (netHandle == nullptr) {
 		return;
 	}
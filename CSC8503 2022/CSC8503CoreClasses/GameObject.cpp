@@ -9,6 +9,10 @@ using namespace NCL::CSC8503;
 GameObject::GameObject(string objectName)	{
 	name			= objectName;
 	worldID			= -1;
+	layers			= 1;
+	collisionMask	= AllLayers;
+	filterChanged	= false;
+	broadphaseProxy	= -1;
 	isActive		= true;
 	boundingVolume	= nullptr;
 	physicsObject	= nullptr;
@@ -35,17 +39,28 @@ void GameObject::UpdateBroadphaseAABB() {
 	if (!boundingVolume) {
 		return;
 	}
+	broadphaseAABB = CalculateBroadphaseAABB();
+}
+
+Vector3 GameObject::CalculateBroadphaseAABB() const {
 	if (boundingVolume->type == VolumeType::AABB) {
-		broadphaseAABB = ((AABBVolume&)*boundingVolume).GetHalfDimensions();
+		return ((AABBVolume&)*boundingVolume).GetHalfDimensions();
 	}
 	else if (boundingVolume->type == VolumeType::Sphere) {
 		float r = ((SphereVolume&)*boundingVolume).GetRadius();
-		broadphaseAABB = Vector3(r, r, r);
+		return Vector3(r, r, r);
 	}
 	else if (boundingVolume->type == VolumeType::OBB) {
 		Matrix3 mat = Matrix3(transform.GetOrientation());
 		mat = mat.Absolute();
 		Vector3 halfSizes = ((OBBVolume&)*boundingVolume).GetHalfDimensions();
-		broadphaseAABB = mat * halfSizes;
+		return mat * halfSizes;
+	}
+	else if (boundingVolume->type == VolumeType::Capsule) {
+		const CapsuleVolume& capsule = (CapsuleVolume&)*boundingVolume;
+		Matrix3 mat = Matrix3(transform.GetOrientation()).Absolute();
+		float r = capsule.GetRadius();
+		return mat * Vector3(0, std::max(capsule.GetHalfHeight() - r, 0.0f), 0) + Vector3(r, r, r);
 	}
+	return broadphaseAABB;
 }
\ No newline at end of file
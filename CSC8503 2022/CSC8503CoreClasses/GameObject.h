@@ -56,11 +56,11 @@ namespace NCL::CSC8503 {
 			return name;
 		}
 
-		virtual void OnCollisionBegin(GameObject* otherObject) {
+		virtual void OnCollisionBegin(GameObject*) {
 			//std::cout << "OnCollisionBegin event occured!\n";
 		}
 
-		virtual void OnCollisionEnd(GameObject* otherObject) {
+		virtual void OnCollisionEnd(GameObject*) {
 			//std::cout << "OnCollisionEnd event occured!\n";
 		}
 
@@ -68,6 +68,17 @@ namespace NCL::CSC8503 {
 
 		void UpdateBroadphaseAABB();
 
+		//The half sizes of a box around the bounding volume where it is right now - it must have one
+		Vector3 CalculateBroadphaseAABB() const;
+
+		void SetBroadphaseProxy(int proxy) {
+			broadphaseProxy = proxy;
+		}
+
+		int GetBroadphaseProxy() const {
+			return broadphaseProxy;
+		}
+
 		void SetWorldID(int newID) {
 			worldID = newID;
 		}
@@ -75,9 +86,49 @@ namespace NCL::CSC8503 {
 		int		GetWorldID() const {
 			return worldID;
 		}
+
+		static constexpr uint32_t AllLayers = 0xFFFFFFFF;
+
+		//Which layers this object is on, one bit each - scene queries only find objects on the layers they ask for
+		void SetLayers(uint32_t newLayers) {
+			filterChanged |= newLayers != layers;
+			layers = newLayers;
+		}
+
+		uint32_t GetLayers() const {
+			return layers;
+		}
+
+		//Which layers this object collides with - everything, unless told otherwise
+		void SetCollisionMask(uint32_t newMask) {
+			filterChanged |= newMask != collisionMask;
+			collisionMask = newMask;
+		}
+
+		uint32_t GetCollisionMask() const {
+			return collisionMask;
+		}
+
+		/*
+		Two objects only collide if each is on one of the layers the other
+		collides with, so either of them can opt out of the pair. The
+		broadphase checks this before a pair ever gets to the narrowphase.
+		*/
+		bool CanCollideWith(const GameObject* other) const {
+			return (layers & other->collisionMask) && (other->layers & collisionMask);
+		}
+
+		//Set when the layers or mask change, so the physics knows to find this object's pairs again
+		bool HasFilterChanged() const {
+			return filterChanged;
+		}
+
+		void ClearFilterChanged() {
+			filterChanged = false;
+		}
 	
 		int GetScore() { return score; }
-		void ResetScore() { score == 0; }
+		void ResetScore() { score = 0; }
 		void IncrementScore() { ++score; }
 
 	protected:
@@ -91,9 +142,13 @@ namespace NCL::CSC8503 {
 
 		bool		isActive;
 		int			worldID;
+		uint32_t	layers;
+		uint32_t	collisionMask;
+		bool		filterChanged;
 		std::string	name;
 
 		Vector3 broadphaseAABB;
+		int		broadphaseProxy;
 	};
 }
 
@@ -1,5 +1,6 @@
 #include "GameServer.h"
 #include "GameWorld.h"
+#include "Profiler.h"
 #include "./enet/enet.h"
 using namespace NCL;
 using namespace CSC8503;
@@ -50,6 +51,7 @@ bool GameServer::SendGlobalPacket(GamePacket& packet) {
 }
 
 void GameServer::UpdateServer() {
+	PROFILE_SCOPE("GameServer::UpdateServer");
 	if (!netHandle) { return; }
 	ENetEvent event;
 	while (enet_host_service(netHandle, &event, 0) > 0) {
@@ -3,6 +3,7 @@
 #include "Constraint.h"
 #include "CollisionDetection.h"
 #include "Camera.h"
+#include "Profiler.h"
 
 
 using namespace NCL;
@@ -15,6 +16,10 @@ GameWorld::GameWorld()	{
 	shuffleObjects		= false;
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
+
+	broadphaseTree			= nullptr;
+	staticBroadphaseTree	= nullptr;
+	broadphaseTreeState		= -1;
 }
 
 GameWorld::~GameWorld()	{
@@ -23,8 +28,10 @@ GameWorld::~GameWorld()	{
 void GameWorld::Clear() {
 	gameObjects.clear();
 	constraints.clear();
-	worldIDCounter		= 0;
-	worldStateCounter	= 0;
+	worldIDCounter			= 0;
+	worldStateCounter		= 0;
+	broadphaseTree			= nullptr;
+	staticBroadphaseTree	= nullptr;
 }
 
 void GameWorld::ClearAndErase() {
@@ -80,7 +87,73 @@ void GameWorld::UpdateWorld(float dt) {
 	}
 }
 
-bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignoreThis) const {
+bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignoreThis, uint32_t layerMask) const {
+	PROFILE_SCOPE("GameWorld::Raycast");
+	const DynamicAABBTree<GameObject*>* dynamicTree;
+	const DynamicAABBTree<GameObject*>* staticTree;
+	if (GetQueryTrees(dynamicTree, staticTree)) {
+		return RaycastTrees(dynamicTree, staticTree, r, closestCollision, closestObject, ignoreThis, layerMask);
+	}
+	return RaycastAll(r, closestCollision, closestObject, ignoreThis, layerMask);
+}
+
+/*
+Line of sight checks for lots of agents can be answered in one call. Each
+ray still walks the tree on its own - rays from agents all over the level
+have little in common for them to share.
+*/
+void GameWorld::Raycast(std::vector<RaycastQuery>& queries, bool closestObject) const {
+	PROFILE_SCOPE("GameWorld::Raycast (batch)");
+	const DynamicAABBTree<GameObject*>* dynamicTree;
+	const DynamicAABBTree<GameObject*>* staticTree;
+	bool useTrees = GetQueryTrees(dynamicTree, staticTree);
+	for (RaycastQuery& q : queries) {
+		q.collision = RayCollision();
+		if (useTrees) {
+			RaycastTrees(dynamicTree, staticTree, q.ray, q.collision, closestObject, q.ignore, q.layerMask);
+		}
+		else {
+			RaycastAll(q.ray, q.collision, closestObject, q.ignore, q.layerMask);
+		}
+	}
+}
+
+/*
+The ray walks down each tree through the boxes it passes through, nearest
+first, and each hit clips it short, so once the closest object is found
+only boxes in front of it are still looked at - including in the second
+tree, which starts off clipped to whatever the first one hit.
+*/
+bool GameWorld::RaycastTrees(const DynamicAABBTree<GameObject*>* dynamicTree, const DynamicAABBTree<GameObject*>* staticTree, const Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignoreThis, uint32_t layerMask) const {
+	RayCollision collision;
+
+	for (const DynamicAABBTree<GameObject*>* tree : { dynamicTree, staticTree }) {
+		if (!tree || (collision.node && !closestObject)) {
+			continue;
+		}
+		tree->RayCast(r.GetPosition(), r.GetDirection(), collision.rayDistance, [&](int proxy, float maxDistance) {
+			GameObject* i = tree->GetObject(proxy);
+			if (i == ignoreThis || !(i->GetLayers() & layerMask)) {
+				return maxDistance;
+			}
+			RayCollision thisCollision;
+			if (!CollisionDetection::RayIntersection(r, *i, thisCollision) || thisCollision.rayDistance >= collision.rayDistance) {
+				return maxDistance;
+			}
+			thisCollision.node	= i;
+			collision			= thisCollision;
+			return closestObject ? collision.rayDistance : -1.0f;
+		});
+	}
+
+	if (collision.node) {
+		closestCollision = collision;
+		return true;
+	}
+	return false;
+}
+
+bool GameWorld::RaycastAll(const Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignoreThis, uint32_t layerMask) const {
 	//The simplest raycast just goes through each object and sees if there's a collision
 	RayCollision collision;
 
@@ -88,14 +161,14 @@ bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObje
 		if (!i->GetBoundingVolume()) { //objects might not be collideable etc...
 			continue;
 		}
-		if (i == ignoreThis) {
+		if (i == ignoreThis || !(i->GetLayers() & layerMask)) {
 			continue;
 		}
 		RayCollision thisCollision;
 		if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
 				
 			if (!closestObject) {	
-				closestCollision		= collision;
+				closestCollision		= thisCollision;
 				closestCollision.node = i;
 				return true;
 			}
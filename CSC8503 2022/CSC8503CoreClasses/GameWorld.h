@@ -4,6 +4,7 @@
 #include "Ray.h"
 #include "CollisionDetection.h"
 #include "QuadTree.h"
+#include "DynamicAABBTree.h"
 namespace NCL {
 		class Camera;
 		using Maths::Ray;
@@ -16,6 +17,21 @@ namespace NCL {
 
 		class GameWorld	{
 		public:
+			//One of a batch of rays cast together, and the closest thing it hit
+			struct RaycastQuery {
+				Ray				ray;
+				GameObject*		ignore;
+				uint32_t		layerMask;
+				RayCollision	collision;
+
+				RaycastQuery(const Ray& r, GameObject* ignoreThis = nullptr, uint32_t layers = GameObject::AllLayers) : ray(r), ignore(ignoreThis), layerMask(layers) {
+				}
+
+				bool Hit() const {
+					return collision.node != nullptr;
+				}
+			};
+
 			GameWorld();
 			~GameWorld();
 
@@ -40,7 +56,39 @@ namespace NCL {
 				shuffleObjects = state;
 			}
 
-			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false, GameObject* ignore = nullptr) const;
+			//Only objects on one of the layers in layerMask can be hit
+			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false, GameObject* ignore = nullptr, uint32_t layerMask = GameObject::AllLayers) const;
+
+			//Casts every ray in one go, filling in each query's collision
+			void Raycast(std::vector<RaycastQuery>& queries, bool closestObject = true) const;
+
+			/*
+			While the PhysicsSystem is using its AABB trees as a broadphase, it
+			hands them over here, so that raycasts only test the objects whose
+			boxes they pass through. Between them they only hold the objects that
+			were here when they were handed over, so if any have been added or
+			removed since, raycasts go back to testing everything until they're
+			handed over again. Objects without a PhysicsObject aren't in either.
+			*/
+			void SetBroadphaseTrees(const DynamicAABBTree<GameObject*>* dynamicTree, const DynamicAABBTree<GameObject*>* staticTree) {
+				broadphaseTree			= dynamicTree;
+				staticBroadphaseTree	= staticTree;
+				broadphaseTreeState		= worldStateCounter;
+			}
+
+			const DynamicAABBTree<GameObject*>* GetBroadphaseTree() const {
+				return broadphaseTree;
+			}
+
+			//The broadphase trees, if they hold every object that's in the world now
+			bool GetQueryTrees(const DynamicAABBTree<GameObject*>*& dynamicTree, const DynamicAABBTree<GameObject*>*& staticTree) const {
+				if (!broadphaseTree || broadphaseTreeState != worldStateCounter) {
+					return false;
+				}
+				dynamicTree	= broadphaseTree;
+				staticTree	= staticBroadphaseTree;
+				return true;
+			}
 
 			virtual void UpdateWorld(float dt);
 
@@ -68,6 +116,13 @@ namespace NCL {
 			bool shuffleObjects;
 			int		worldIDCounter;
 			int		worldStateCounter;
+
+			bool RaycastTrees(const DynamicAABBTree<GameObject*>* dynamicTree, const DynamicAABBTree<GameObject*>* staticTree, const Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignore, uint32_t layerMask) const;
+			bool RaycastAll(const Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignore, uint32_t layerMask) const;
+
+			const DynamicAABBTree<GameObject*>*	broadphaseTree;
+			const DynamicAABBTree<GameObject*>*	staticBroadphaseTree;
+			int									broadphaseTreeState;
 		};
 	}
 }
@@ -0,0 +1,122 @@
+#include "GridBoxMerger.h"
+#include "MeshGeometry.h"
+
+using namespace NCL;
+using namespace NCL::CSC8503;
+
+void GridBoxMerger::MergeCells(const std::vector<bool>& filled, int gridWidth, int gridHeight, std::vector<CellBox>& boxes) {
+	std::vector<CellBox> byRow;
+	std::vector<CellBox> byColumn;
+	MergeGreedily(filled, gridWidth, gridHeight, false, byRow);
+	MergeGreedily(filled, gridWidth, gridHeight, true, byColumn);
+
+	const std::vector<CellBox>& fewest = byColumn.size() < byRow.size() ? byColumn : byRow;
+	boxes.insert(boxes.end(), fewest.begin(), fewest.end());
+}
+
+/*
+Scanning by column is the same as scanning by row with x and y swapped over,
+so 'along' is the direction a box first grows in, and 'across' the one it
+then grows whole lines at a time in.
+*/
+void GridBoxMerger::MergeGreedily(const std::vector<bool>& filled, int gridWidth, int gridHeight, bool byColumn, std::vector<CellBox>& boxes) {
+	int alongCount	= byColumn ? gridHeight : gridWidth;
+	int acrossCount	= byColumn ? gridWidth : gridHeight;
+
+	std::vector<bool> covered(filled.size(), false);
+	auto cellIndex = [&](int along, int across) {
+		return byColumn ? (along * gridWidth) + across : (across * gridWidth) + along;
+	};
+	auto isFree = [&](int along, int across) {
+		int index = cellIndex(along, across);
+		return filled[index] && !covered[index];
+	};
+
+	for (int across = 0; across < acrossCount; ++across) {
+		for (int along = 0; along < alongCount; ++along) {
+			if (!isFree(along, across)) {
+				continue;
+			}
+			int length = 1;
+			while (along + length < alongCount && isFree(along + length, across)) {
+				length++;
+			}
+			int lines = 1;
+			while (across + lines < acrossCount) {
+				bool lineFree = true;
+				for (int i = 0; i < length && lineFree; ++i) {
+					lineFree = isFree(along + i, across + lines);
+				}
+				if (!lineFree) {
+					break;
+				}
+				lines++;
+			}
+			for (int j = 0; j < lines; ++j) {
+				for (int i = 0; i < length; ++i) {
+					covered[cellIndex(along + i, across + j)] = true;
+				}
+			}
+			if (byColumn) {
+				boxes.push_back({ across, along, lines, length });
+			}
+			else {
+				boxes.push_back({ along, across, length, lines });
+			}
+		}
+	}
+}
+
+/*
+Each face gets its own four vertices, so that its normal is flat. Faces are
+described by their normal and two edge directions, u and v, with u x v = normal,
+so that going round the corners in order winds anticlockwise when seen from
+outside the box.
+*/
+void GridBoxMerger::BuildBoxMesh(MeshGeometry& mesh, const std::vector<Vector3>& centres, const std::vector<Vector3>& halfSizes, float textureSize) {
+	static const Vector3 faces[6][3] = {
+		{ Vector3( 1, 0, 0), Vector3(0, 0,-1), Vector3(0, 1, 0) },
+		{ Vector3(-1, 0, 0), Vector3(0, 0, 1), Vector3(0, 1, 0) },
+		{ Vector3( 0, 1, 0), Vector3(1, 0, 0), Vector3(0, 0,-1) },
+		{ Vector3( 0,-1, 0), Vector3(1, 0, 0), Vector3(0, 0, 1) },
+		{ Vector3( 0, 0, 1), Vector3(1, 0, 0), Vector3(0, 1, 0) },
+		{ Vector3( 0, 0,-1), Vector3(-1,0, 0), Vector3(0, 1, 0) }
+	};
+	static const float corners[4][2] = { {-1,-1}, {1,-1}, {1,1}, {-1,1} };
+
+	std::vector<Vector3>		positions;
+	std::vector<Vector3>		normals;
+	std::vector<Vector2>		texCoords;
+	std::vector<unsigned int>	indices;
+
+	for (size_t i = 0; i < centres.size(); ++i) {
+		const Vector3& halfSize = halfSizes[i];
+		for (const auto& face : faces) {
+			const Vector3& normal	= face[0];
+			const Vector3& u		= face[1];
+			const Vector3& v		= face[2];
+			float normalExtent	= std::abs(Vector3::Dot(normal, halfSize));
+			float uExtent		= std::abs(Vector3::Dot(u, halfSize));
+			float vExtent		= std::abs(Vector3::Dot(v, halfSize));
+
+			unsigned int first = (unsigned int)positions.size();
+			for (const auto& corner : corners) {
+				positions.push_back(centres[i] + normal * normalExtent + u * (uExtent * corner[0]) + v * (vExtent * corner[1]));
+				normals.push_back(normal);
+				texCoords.push_back(Vector2(
+					(corner[0] + 1.0f) * uExtent / textureSize,
+					(corner[1] + 1.0f) * vExtent / textureSize));
+			}
+			for (unsigned int index : { 0u, 1u, 2u, 2u, 3u, 0u }) {
+				indices.push_back(first + index);
+			}
+		}
+	}
+
+	mesh.SetPrimitiveType(GeometryPrimitive::Triangles);
+	mesh.SetVertexPositions(positions);
+	mesh.SetVertexNormals(normals);
+	mesh.SetVertexTextureCoords(texCoords);
+	mesh.SetVertexIndices(indices);
+	mesh.AddSubMesh(0, (int)indices.size(), 0);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Vector3.h"
+
+namespace NCL {
+	class MeshGeometry;
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Grid based levels like the maze describe their walls one cell at a time,
+		but a wall ten cells long doesn't need to be ten objects, with ten
+		colliders in the broadphase and ten draw calls. MergeCells covers the
+		filled cells of a grid with boxes instead - each box starts at the first
+		cell not yet covered, grows along its row for as long as it can, then
+		grows across whole rows at a time. That's done once row by row and once
+		column by column, and whichever gives fewer boxes is kept. It isn't
+		always the fewest boxes possible, but walls made of straight runs and
+		rectangles come out as one box each.
+
+		BuildBoxMesh then bakes a set of boxes into a single mesh, so that all of
+		a level's walls can be drawn at once.
+		*/
+		class GridBoxMerger {
+		public:
+			//A rectangle of cells, starting at (x, y)
+			struct CellBox {
+				int x;
+				int y;
+				int width;
+				int depth;
+			};
+
+			//Every filled cell ends up in exactly one box
+			static void MergeCells(const std::vector<bool>& filled, int gridWidth, int gridHeight, std::vector<CellBox>& boxes);
+
+			/*
+			Fills in the mesh's positions, normals, texture coordinates and indices
+			with a box for each centre and half size, as one submesh ready to be
+			uploaded. textureSize is how far apart the texture repeats.
+			*/
+			static void BuildBoxMesh(MeshGeometry& mesh, const std::vector<Vector3>& centres, const std::vector<Vector3>& halfSizes, float textureSize);
+
+		protected:
+			static void MergeGreedily(const std::vector<bool>& filled, int gridWidth, int gridHeight, bool byColumn, std::vector<CellBox>& boxes);
+
+		private:
+			GridBoxMerger()		{}
+			~GridBoxMerger()	{}
+		};
+	}
+}
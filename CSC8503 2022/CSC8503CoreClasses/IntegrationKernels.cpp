@@ -0,0 +1,388 @@
+#include "IntegrationKernels.h"
+#include "PhysicsBodyStore.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define USE_X86_KERNELS
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define KERNEL_TARGET(isa)
+#else
+//GCC and Clang only allow intrinsics in functions built for that instruction set
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+Scalar versions - these handle every body on CPUs without SSE or AVX, and
+whatever's left over at the end of the arrays when there is.
+*/
+static void LinearAccelScalar(int begin, PhysicsBodyStore& bodies, const Vector3& gravity, float dt) {
+	const float*	force[3]	= { bodies.forces.x.data(), bodies.forces.y.data(), bodies.forces.z.data() };
+	float*			vel[3]		= { bodies.linearVelocities.x.data(), bodies.linearVelocities.y.data(), bodies.linearVelocities.z.data() };
+	const float*	invMass		= bodies.inverseMasses.data();
+
+	for (int i = begin; i < bodies.GetAwakeCount(); ++i) {
+		for (int axis = 0; axis < 3; ++axis) {
+			float accel = force[axis][i] * invMass[i];
+			if (invMass[i] > 0) {
+				accel += gravity[axis];
+			}
+			vel[axis][i] += accel * dt;
+		}
+	}
+}
+
+static void LinearVelocityScalar(int begin, PhysicsBodyStore& bodies, float damping, float dt) {
+	float* pos[3] = { bodies.positions.x.data(), bodies.positions.y.data(), bodies.positions.z.data() };
+	float* vel[3] = { bodies.linearVelocities.x.data(), bodies.linearVelocities.y.data(), bodies.linearVelocities.z.data() };
+
+	for (int i = begin; i < bodies.GetAwakeCount(); ++i) {
+		for (int axis = 0; axis < 3; ++axis) {
+			pos[axis][i] += vel[axis][i] * dt;
+			vel[axis][i] *= damping;
+		}
+	}
+}
+
+static void AngularVelocityScalar(int begin, PhysicsBodyStore& bodies, float damping, float dt) {
+	PhysicsBodyStore::QuaternionArray&	q = bodies.orientations;
+	PhysicsBodyStore::Vector3Array&		w = bodies.angularVelocities;
+
+	for (int i = begin; i < bodies.GetAwakeCount(); ++i) {
+		float ax = (w.x[i] * dt) * 0.5f;
+		float ay = (w.y[i] * dt) * 0.5f;
+		float az = (w.z[i] * dt) * 0.5f;
+
+		//Quaternion(a, 0) * q, written out
+		float dx = ((ax * q.w[i]) + (ay * q.z[i])) - (az * q.y[i]);
+		float dy = ((ay * q.w[i]) + (az * q.x[i])) - (ax * q.z[i]);
+		float dz = ((az * q.w[i]) + (ax * q.y[i])) - (ay * q.x[i]);
+		float dw = ((0.0f - (ax * q.x[i])) - (ay * q.y[i])) - (az * q.z[i]);
+
+		float x = q.x[i] + dx;
+		float y = q.y[i] + dy;
+		float z = q.z[i] + dz;
+		float s = q.w[i] + dw;
+
+		float magnitude = sqrt((((x * x) + (y * y)) + (z * z)) + (s * s));
+		if (magnitude > 0.0f) {
+			float t = 1.0f / magnitude;
+			x *= t;
+			y *= t;
+			z *= t;
+			s *= t;
+		}
+		q.x[i] = x;
+		q.y[i] = y;
+		q.z[i] = z;
+		q.w[i] = s;
+
+		w.x[i] *= damping;
+		w.y[i] *= damping;
+		w.z[i] *= damping;
+	}
+}
+
+#ifdef USE_X86_KERNELS
+/*
+The SSE and AVX versions are the scalar ones above, a register's worth of
+bodies at a time. They return how many bodies they got through, which is
+always a whole number of registers - the scalar loops finish off the rest.
+*/
+KERNEL_TARGET("sse")
+static int LinearAccelSSE(PhysicsBodyStore& bodies, const Vector3& gravity, float dt) {
+	int count = bodies.GetAwakeCount() & ~3;
+
+	const float*	force[3]	= { bodies.forces.x.data(), bodies.forces.y.data(), bodies.forces.z.data() };
+	float*			vel[3]		= { bodies.linearVelocities.x.data(), bodies.linearVelocities.y.data(), bodies.linearVelocities.z.data() };
+	const float*	invMass		= bodies.inverseMasses.data();
+
+	__m128 grav[3]	= { _mm_set1_ps(gravity.x), _mm_set1_ps(gravity.y), _mm_set1_ps(gravity.z) };
+	__m128 step		= _mm_set1_ps(dt);
+	__m128 zero		= _mm_setzero_ps();
+
+	for (int i = 0; i < count; i += 4) {
+		__m128 im		= _mm_loadu_ps(invMass + i);
+		__m128 hasMass	= _mm_cmpgt_ps(im, zero);
+		for (int axis = 0; axis < 3; ++axis) {
+			__m128 accel = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(force[axis] + i), im), _mm_and_ps(hasMass, grav[axis]));
+			_mm_storeu_ps(vel[axis] + i, _mm_add_ps(_mm_loadu_ps(vel[axis] + i), _mm_mul_ps(accel, step)));
+		}
+	}
+	return count;
+}
+
+KERNEL_TARGET("sse")
+static int LinearVelocitySSE(PhysicsBodyStore& bodies, float damping, float dt) {
+	int count = bodies.GetAwakeCount() & ~3;
+
+	float* pos[3] = { bodies.positions.x.data(), bodies.positions.y.data(), bodies.positions.z.data() };
+	float* vel[3] = { bodies.linearVelocities.x.data(), bodies.linearVelocities.y.data(), bodies.linearVelocities.z.data() };
+
+	__m128 step	= _mm_set1_ps(dt);
+	__m128 damp	= _mm_set1_ps(damping);
+
+	for (int i = 0; i < count; i += 4) {
+		for (int axis = 0; axis < 3; ++axis) {
+			__m128 v = _mm_loadu_ps(vel[axis] + i);
+			_mm_storeu_ps(pos[axis] + i, _mm_add_ps(_mm_loadu_ps(pos[axis] + i), _mm_mul_ps(v, step)));
+			_mm_storeu_ps(vel[axis] + i, _mm_mul_ps(v, damp));
+		}
+	}
+	return count;
+}
+
+KERNEL_TARGET("sse")
+static int AngularVelocitySSE(PhysicsBodyStore& bodies, float damping, float dt) {
+	int count = bodies.GetAwakeCount() & ~3;
+
+	PhysicsBodyStore::QuaternionArray&	q = bodies.orientations;
+	PhysicsBodyStore::Vector3Array&		w = bodies.angularVelocities;
+
+	__m128 step	= _mm_set1_ps(dt);
+	__m128 half	= _mm_set1_ps(0.5f);
+	__m128 damp	= _mm_set1_ps(damping);
+	__m128 zero	= _mm_setzero_ps();
+	__m128 one	= _mm_set1_ps(1.0f);
+
+	for (int i = 0; i < count; i += 4) {
+		__m128 wx = _mm_loadu_ps(&w.x[i]);
+		__m128 wy = _mm_loadu_ps(&w.y[i]);
+		__m128 wz = _mm_loadu_ps(&w.z[i]);
+
+		__m128 qx = _mm_loadu_ps(&q.x[i]);
+		__m128 qy = _mm_loadu_ps(&q.y[i]);
+		__m128 qz = _mm_loadu_ps(&q.z[i]);
+		__m128 qw = _mm_loadu_ps(&q.w[i]);
+
+		__m128 ax = _mm_mul_ps(_mm_mul_ps(wx, step), half);
+		__m128 ay = _mm_mul_ps(_mm_mul_ps(wy, step), half);
+		__m128 az = _mm_mul_ps(_mm_mul_ps(wz, step), half);
+
+		__m128 dx = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ax, qw), _mm_mul_ps(ay, qz)), _mm_mul_ps(az, qy));
+		__m128 dy = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ay, qw), _mm_mul_ps(az, qx)), _mm_mul_ps(ax, qz));
+		__m128 dz = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(az, qw), _mm_mul_ps(ax, qy)), _mm_mul_ps(ay, qx));
+		__m128 dw = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(zero, _mm_mul_ps(ax, qx)), _mm_mul_ps(ay, qy)), _mm_mul_ps(az, qz));
+
+		qx = _mm_add_ps(qx, dx);
+		qy = _mm_add_ps(qy, dy);
+		qz = _mm_add_ps(qz, dz);
+		qw = _mm_add_ps(qw, dw);
+
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_mul_ps(qz, qz)), _mm_mul_ps(qw, qw));
+		__m128 magnitude	= _mm_sqrt_ps(lengthSq);
+		__m128 valid		= _mm_cmpgt_ps(magnitude, zero);
+		//Zero length quaternions are left alone, rather than filled with NaNs
+		__m128 t			= _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(one, magnitude)), _mm_andnot_ps(valid, one));
+
+		_mm_storeu_ps(&q.x[i], _mm_mul_ps(qx, t));
+		_mm_storeu_ps(&q.y[i], _mm_mul_ps(qy, t));
+		_mm_storeu_ps(&q.z[i], _mm_mul_ps(qz, t));
+		_mm_storeu_ps(&q.w[i], _mm_mul_ps(qw, t));
+
+		_mm_storeu_ps(&w.x[i], _mm_mul_ps(wx, damp));
+		_mm_storeu_ps(&w.y[i], _mm_mul_ps(wy, damp));
+		_mm_storeu_ps(&w.z[i], _mm_mul_ps(wz, damp));
+	}
+	return count;
+}
+
+KERNEL_TARGET("avx")
+static int LinearAccelAVX(PhysicsBodyStore& bodies, const Vector3& gravity, float dt) {
+	int count = bodies.GetAwakeCount() & ~7;
+
+	const float*	force[3]	= { bodies.forces.x.data(), bodies.forces.y.data(), bodies.forces.z.data() };
+	float*			vel[3]		= { bodies.linearVelocities.x.data(), bodies.linearVelocities.y.data(), bodies.linearVelocities.z.data() };
+	const float*	invMass		= bodies.inverseMasses.data();
+
+	__m256 grav[3]	= { _mm256_set1_ps(gravity.x), _mm256_set1_ps(gravity.y), _mm256_set1_ps(gravity.z) };
+	__m256 step		= _mm256_set1_ps(dt);
+	__m256 zero		= _mm256_setzero_ps();
+
+	for (int i = 0; i < count; i += 8) {
+		__m256 im		= _mm256_loadu_ps(invMass + i);
+		__m256 hasMass	= _mm256_cmp_ps(im, zero, _CMP_GT_OQ);
+		for (int axis = 0; axis < 3; ++axis) {
+			__m256 accel = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(force[axis] + i), im), _mm256_and_ps(hasMass, grav[axis]));
+			_mm256_storeu_ps(vel[axis] + i, _mm256_add_ps(_mm256_loadu_ps(vel[axis] + i), _mm256_mul_ps(accel, step)));
+		}
+	}
+	return count;
+}
+
+KERNEL_TARGET("avx")
+static int LinearVelocityAVX(PhysicsBodyStore& bodies, float damping, float dt) {
+	int count = bodies.GetAwakeCount() & ~7;
+
+	float* pos[3] = { bodies.positions.x.data(), bodies.positions.y.data(), bodies.positions.z.data() };
+	float* vel[3] = { bodies.linearVelocities.x.data(), bodies.linearVelocities.y.data(), bodies.linearVelocities.z.data() };
+
+	__m256 step	= _mm256_set1_ps(dt);
+	__m256 damp	= _mm256_set1_ps(damping);
+
+	for (int i = 0; i < count; i += 8) {
+		for (int axis = 0; axis < 3; ++axis) {
+			__m256 v = _mm256_loadu_ps(vel[axis] + i);
+			_mm256_storeu_ps(pos[axis] + i, _mm256_add_ps(_mm256_loadu_ps(pos[axis] + i), _mm256_mul_ps(v, step)));
+			_mm256_storeu_ps(vel[axis] + i, _mm256_mul_ps(v, damp));
+		}
+	}
+	return count;
+}
+
+KERNEL_TARGET("avx")
+static int AngularVelocityAVX(PhysicsBodyStore& bodies, float damping, float dt) {
+	int count = bodies.GetAwakeCount() & ~7;
+
+	PhysicsBodyStore::QuaternionArray&	q = bodies.orientations;
+	PhysicsBodyStore::Vector3Array&		w = bodies.angularVelocities;
+
+	__m256 step	= _mm256_set1_ps(dt);
+	__m256 half	= _mm256_set1_ps(0.5f);
+	__m256 damp	= _mm256_set1_ps(damping);
+	__m256 zero	= _mm256_setzero_ps();
+	__m256 one	= _mm256_set1_ps(1.0f);
+
+	for (int i = 0; i < count; i += 8) {
+		__m256 wx = _mm256_loadu_ps(&w.x[i]);
+		__m256 wy = _mm256_loadu_ps(&w.y[i]);
+		__m256 wz = _mm256_loadu_ps(&w.z[i]);
+
+		__m256 qx = _mm256_loadu_ps(&q.x[i]);
+		__m256 qy = _mm256_loadu_ps(&q.y[i]);
+		__m256 qz = _mm256_loadu_ps(&q.z[i]);
+		__m256 qw = _mm256_loadu_ps(&q.w[i]);
+
+		__m256 ax = _mm256_mul_ps(_mm256_mul_ps(wx, step), half);
+		__m256 ay = _mm256_mul_ps(_mm256_mul_ps(wy, step), half);
+		__m256 az = _mm256_mul_ps(_mm256_mul_ps(wz, step), half);
+
+		__m256 dx = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(ax, qw), _mm256_mul_ps(ay, qz)), _mm256_mul_ps(az, qy));
+		__m256 dy = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(ay, qw), _mm256_mul_ps(az, qx)), _mm256_mul_ps(ax, qz));
+		__m256 dz = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(az, qw), _mm256_mul_ps(ax, qy)), _mm256_mul_ps(ay, qx));
+		__m256 dw = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(zero, _mm256_mul_ps(ax, qx)), _mm256_mul_ps(ay, qy)), _mm256_mul_ps(az, qz));
+
+		qx = _mm256_add_ps(qx, dx);
+		qy = _mm256_add_ps(qy, dy);
+		qz = _mm256_add_ps(qz, dz);
+		qw = _mm256_add_ps(qw, dw);
+
+		__m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy)), _mm256_mul_ps(qz, qz)), _mm256_mul_ps(qw, qw));
+		__m256 magnitude	= _mm256_sqrt_ps(lengthSq);
+		__m256 valid		= _mm256_cmp_ps(magnitude, zero, _CMP_GT_OQ);
+		__m256 t			= _mm256_blendv_ps(one, _mm256_div_ps(one, magnitude), valid);
+
+		_mm256_storeu_ps(&q.x[i], _mm256_mul_ps(qx, t));
+		_mm256_storeu_ps(&q.y[i], _mm256_mul_ps(qy, t));
+		_mm256_storeu_ps(&q.z[i], _mm256_mul_ps(qz, t));
+		_mm256_storeu_ps(&q.w[i], _mm256_mul_ps(qw, t));
+
+		_mm256_storeu_ps(&w.x[i], _mm256_mul_ps(wx, damp));
+		_mm256_storeu_ps(&w.y[i], _mm256_mul_ps(wy, damp));
+		_mm256_storeu_ps(&w.z[i], _mm256_mul_ps(wz, damp));
+	}
+	return count;
+}
+#endif
+
+static bool CPUSupportsSSE() {
+#if !defined(USE_X86_KERNELS)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 25)) != 0;
+#else
+	return __builtin_cpu_supports("sse");
+#endif
+}
+
+/*
+As well as the CPU having AVX, the OS has to be saving the wider registers
+when it switches threads, or we'd have them trashed under us.
+*/
+static bool CPUSupportsAVX() {
+#if !defined(USE_X86_KERNELS)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool osSavesRegisters	= (info[2] & (1 << 27)) != 0;
+	bool hasAVX				= (info[2] & (1 << 28)) != 0;
+	return osSavesRegisters && hasAVX && (_xgetbv(0) & 6) == 6;
+#else
+	return __builtin_cpu_supports("avx");
+#endif
+}
+
+bool IntegrationKernels::IsSupported(InstructionSet set) {
+	static const bool hasSSE = CPUSupportsSSE();
+	static const bool hasAVX = CPUSupportsAVX();
+
+	switch (set) {
+		case InstructionSet::SSE:	return hasSSE;
+		case InstructionSet::AVX:	return hasAVX;
+		default:					return true;
+	}
+}
+
+IntegrationKernels::InstructionSet IntegrationKernels::GetBestSupported() {
+	if (IsSupported(InstructionSet::AVX)) {
+		return InstructionSet::AVX;
+	}
+	if (IsSupported(InstructionSet::SSE)) {
+		return InstructionSet::SSE;
+	}
+	return InstructionSet::Scalar;
+}
+
+const char* IntegrationKernels::GetName(InstructionSet set) {
+	switch (set) {
+		case InstructionSet::SSE:	return "SSE";
+		case InstructionSet::AVX:	return "AVX";
+		default:					return "Scalar";
+	}
+}
+
+void IntegrationKernels::IntegrateLinearAccel(InstructionSet set, PhysicsBodyStore& bodies, const Vector3& gravity, float dt) {
+	int done = 0;
+#ifdef USE_X86_KERNELS
+	if (set == InstructionSet::AVX) {
+		done = LinearAccelAVX(bodies, gravity, dt);
+	}
+	else if (set == InstructionSet::SSE) {
+		done = LinearAccelSSE(bodies, gravity, dt);
+	}
+#endif
+	LinearAccelScalar(done, bodies, gravity, dt);
+}
+
+void IntegrationKernels::IntegrateLinearVelocity(InstructionSet set, PhysicsBodyStore& bodies, float damping, float dt) {
+	int done = 0;
+#ifdef USE_X86_KERNELS
+	if (set == InstructionSet::AVX) {
+		done = LinearVelocityAVX(bodies, damping, dt);
+	}
+	else if (set == InstructionSet::SSE) {
+		done = LinearVelocitySSE(bodies, damping, dt);
+	}
+#endif
+	LinearVelocityScalar(done, bodies, damping, dt);
+}
+
+void IntegrationKernels::IntegrateAngularVelocity(InstructionSet set, PhysicsBodyStore& bodies, float damping, float dt) {
+	int done = 0;
+#ifdef USE_X86_KERNELS
+	if (set == InstructionSet::AVX) {
+		done = AngularVelocityAVX(bodies, damping, dt);
+	}
+	else if (set == InstructionSet::SSE) {
+		done = AngularVelocitySSE(bodies, damping, dt);
+	}
+#endif
+	AngularVelocityScalar(done, bodies, damping, dt);
+}
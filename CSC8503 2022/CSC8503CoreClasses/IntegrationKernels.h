@@ -0,0 +1,45 @@
+#pragma once
+using namespace NCL::Maths;
+
+namespace NCL {
+	namespace CSC8503 {
+		class PhysicsBodyStore;
+
+		/*
+		The integration steps of the PhysicsSystem do the same few sums for every
+		body, and the body store keeps each component in its own array, so they
+		can be done for 4 (SSE) or 8 (AVX) bodies at a time. Which of these the
+		CPU can actually run is checked at runtime, and the plain scalar loops
+		are always there to fall back on.
+
+		Every path does the same operations in the same order, so they all give
+		the same results as each other. Only the store's awake bodies are moved.
+		*/
+		class IntegrationKernels {
+		public:
+			enum class InstructionSet {
+				Scalar,
+				SSE,
+				AVX
+			};
+
+			//The widest instruction set this CPU (and OS) supports
+			static InstructionSet GetBestSupported();
+			static bool IsSupported(InstructionSet set);
+			static const char* GetName(InstructionSet set);
+
+			//v += (force * inverseMass + gravity) * dt, with no gravity for infinitely heavy bodies
+			static void IntegrateLinearAccel(InstructionSet set, PhysicsBodyStore& bodies, const Vector3& gravity, float dt);
+
+			//position += v * dt, then v is damped
+			static void IntegrateLinearVelocity(InstructionSet set, PhysicsBodyStore& bodies, float damping, float dt);
+
+			//orientation += 0.5 * (w * dt) * orientation, normalised, then w is damped
+			static void IntegrateAngularVelocity(InstructionSet set, PhysicsBodyStore& bodies, float damping, float dt);
+
+		private:
+			IntegrationKernels()	{}
+			~IntegrationKernels()	{}
+		};
+	}
+}
@@ -0,0 +1,251 @@
+#include "NarrowPhaseKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define USE_X86_KERNELS
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define KERNEL_TARGET(isa)
+#else
+//GCC and Clang only allow intrinsics in functions built for that instruction set
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+void NarrowPhaseKernels::SphereSpherePairs::Begin(int maxCount) {
+	count = 0;
+	if ((int)pairIndices.size() >= maxCount) {
+		return;
+	}
+	std::vector<float>* arrays[] = { &ax, &ay, &az, &radiusA, &bx, &by, &bz, &radiusB };
+	for (std::vector<float>* a : arrays) {
+		a->resize(maxCount);
+	}
+	pairIndices.resize(maxCount);
+	results.Resize(maxCount);
+}
+
+void NarrowPhaseKernels::AABBSpherePairs::Begin(int maxCount) {
+	count = 0;
+	if ((int)pairIndices.size() >= maxCount) {
+		return;
+	}
+	std::vector<float>* arrays[] = { &boxX, &boxY, &boxZ, &halfX, &halfY, &halfZ, &sphereX, &sphereY, &sphereZ, &radius };
+	for (std::vector<float>* a : arrays) {
+		a->resize(maxCount);
+	}
+	pairIndices.resize(maxCount);
+	results.Resize(maxCount);
+}
+
+/*
+Scalar versions - SphereIntersection and AABBSphereIntersection, written out
+over the arrays. These handle every pair on CPUs without SSE or AVX, and
+whatever's left over at the end of the arrays when there is.
+*/
+static void SphereSphereScalar(int begin, NarrowPhaseKernels::SphereSpherePairs& p) {
+	NarrowPhaseKernels::Results& r = p.results;
+	for (int i = begin; i < p.Count(); ++i) {
+		float dx = p.bx[i] - p.ax[i];
+		float dy = p.by[i] - p.ay[i];
+		float dz = p.bz[i] - p.az[i];
+
+		float radii		= p.radiusA[i] + p.radiusB[i];
+		float length	= sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+		r.penetration[i] = 0.0f;
+		if (length < radii) {
+			float t = length != 0.0f ? 1.0f / length : 0.0f;
+			r.normalX[i]		= dx * t;
+			r.normalY[i]		= dy * t;
+			r.normalZ[i]		= dz * t;
+			r.penetration[i]	= radii - length;
+		}
+	}
+}
+
+static void AABBSphereScalar(int begin, NarrowPhaseKernels::AABBSpherePairs& p) {
+	NarrowPhaseKernels::Results& r = p.results;
+	for (int i = begin; i < p.Count(); ++i) {
+		float dx = p.sphereX[i] - p.boxX[i];
+		float dy = p.sphereY[i] - p.boxY[i];
+		float dz = p.sphereZ[i] - p.boxZ[i];
+
+		//What's left over once the closest point on the box is taken away
+		float lx = dx - std::min(std::max(dx, -p.halfX[i]), p.halfX[i]);
+		float ly = dy - std::min(std::max(dy, -p.halfY[i]), p.halfY[i]);
+		float lz = dz - std::min(std::max(dz, -p.halfZ[i]), p.halfZ[i]);
+
+		float distance = sqrt((lx * lx) + (ly * ly) + (lz * lz));
+
+		r.penetration[i] = 0.0f;
+		if (distance < p.radius[i]) {
+			float t = distance != 0.0f ? 1.0f / distance : 0.0f;
+			r.normalX[i]		= lx * t;
+			r.normalY[i]		= ly * t;
+			r.normalZ[i]		= lz * t;
+			r.penetration[i]	= p.radius[i] - distance;
+		}
+	}
+}
+
+#ifdef USE_X86_KERNELS
+/*
+The SSE and AVX versions are the scalar ones above, a register's worth of
+pairs at a time. Pairs that aren't touching get a penetration of zero, and
+a zero length normal is left as zero, rather than filled with NaNs.
+*/
+KERNEL_TARGET("sse")
+static int SphereSphereSSE(NarrowPhaseKernels::SphereSpherePairs& p) {
+	int count = p.Count() & ~3;
+	NarrowPhaseKernels::Results& r = p.results;
+
+	__m128 zero	= _mm_setzero_ps();
+	__m128 one	= _mm_set1_ps(1.0f);
+
+	for (int i = 0; i < count; i += 4) {
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&p.bx[i]), _mm_loadu_ps(&p.ax[i]));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&p.by[i]), _mm_loadu_ps(&p.ay[i]));
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(&p.bz[i]), _mm_loadu_ps(&p.az[i]));
+
+		__m128 radii	= _mm_add_ps(_mm_loadu_ps(&p.radiusA[i]), _mm_loadu_ps(&p.radiusB[i]));
+		__m128 length	= _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+		__m128 touching	= _mm_cmplt_ps(length, radii);
+		__m128 t		= _mm_and_ps(_mm_cmpneq_ps(length, zero), _mm_div_ps(one, length));
+
+		_mm_storeu_ps(&r.normalX[i], _mm_mul_ps(dx, t));
+		_mm_storeu_ps(&r.normalY[i], _mm_mul_ps(dy, t));
+		_mm_storeu_ps(&r.normalZ[i], _mm_mul_ps(dz, t));
+		_mm_storeu_ps(&r.penetration[i], _mm_and_ps(touching, _mm_sub_ps(radii, length)));
+	}
+	return count;
+}
+
+KERNEL_TARGET("sse")
+static int AABBSphereSSE(NarrowPhaseKernels::AABBSpherePairs& p) {
+	int count = p.Count() & ~3;
+	NarrowPhaseKernels::Results& r = p.results;
+
+	__m128 zero	= _mm_setzero_ps();
+	__m128 one	= _mm_set1_ps(1.0f);
+	__m128 sign	= _mm_set1_ps(-0.0f); //Flips the sign bit, as -x does
+
+	for (int i = 0; i < count; i += 4) {
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&p.sphereX[i]), _mm_loadu_ps(&p.boxX[i]));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&p.sphereY[i]), _mm_loadu_ps(&p.boxY[i]));
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(&p.sphereZ[i]), _mm_loadu_ps(&p.boxZ[i]));
+
+		__m128 hx = _mm_loadu_ps(&p.halfX[i]);
+		__m128 hy = _mm_loadu_ps(&p.halfY[i]);
+		__m128 hz = _mm_loadu_ps(&p.halfZ[i]);
+
+		__m128 lx = _mm_sub_ps(dx, _mm_min_ps(_mm_max_ps(dx, _mm_xor_ps(hx, sign)), hx));
+		__m128 ly = _mm_sub_ps(dy, _mm_min_ps(_mm_max_ps(dy, _mm_xor_ps(hy, sign)), hy));
+		__m128 lz = _mm_sub_ps(dz, _mm_min_ps(_mm_max_ps(dz, _mm_xor_ps(hz, sign)), hz));
+
+		__m128 radius	= _mm_loadu_ps(&p.radius[i]);
+		__m128 distance	= _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz)));
+
+		__m128 touching	= _mm_cmplt_ps(distance, radius);
+		__m128 t		= _mm_and_ps(_mm_cmpneq_ps(distance, zero), _mm_div_ps(one, distance));
+
+		_mm_storeu_ps(&r.normalX[i], _mm_mul_ps(lx, t));
+		_mm_storeu_ps(&r.normalY[i], _mm_mul_ps(ly, t));
+		_mm_storeu_ps(&r.normalZ[i], _mm_mul_ps(lz, t));
+		_mm_storeu_ps(&r.penetration[i], _mm_and_ps(touching, _mm_sub_ps(radius, distance)));
+	}
+	return count;
+}
+
+KERNEL_TARGET("avx")
+static int SphereSphereAVX(NarrowPhaseKernels::SphereSpherePairs& p) {
+	int count = p.Count() & ~7;
+	NarrowPhaseKernels::Results& r = p.results;
+
+	__m256 zero	= _mm256_setzero_ps();
+	__m256 one	= _mm256_set1_ps(1.0f);
+
+	for (int i = 0; i < count; i += 8) {
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&p.bx[i]), _mm256_loadu_ps(&p.ax[i]));
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&p.by[i]), _mm256_loadu_ps(&p.ay[i]));
+		__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&p.bz[i]), _mm256_loadu_ps(&p.az[i]));
+
+		__m256 radii	= _mm256_add_ps(_mm256_loadu_ps(&p.radiusA[i]), _mm256_loadu_ps(&p.radiusB[i]));
+		__m256 length	= _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+
+		__m256 touching	= _mm256_cmp_ps(length, radii, _CMP_LT_OQ);
+		__m256 t		= _mm256_and_ps(_mm256_cmp_ps(length, zero, _CMP_NEQ_UQ), _mm256_div_ps(one, length));
+
+		_mm256_storeu_ps(&r.normalX[i], _mm256_mul_ps(dx, t));
+		_mm256_storeu_ps(&r.normalY[i], _mm256_mul_ps(dy, t));
+		_mm256_storeu_ps(&r.normalZ[i], _mm256_mul_ps(dz, t));
+		_mm256_storeu_ps(&r.penetration[i], _mm256_and_ps(touching, _mm256_sub_ps(radii, length)));
+	}
+	return count;
+}
+
+KERNEL_TARGET("avx")
+static int AABBSphereAVX(NarrowPhaseKernels::AABBSpherePairs& p) {
+	int count = p.Count() & ~7;
+	NarrowPhaseKernels::Results& r = p.results;
+
+	__m256 zero	= _mm256_setzero_ps();
+	__m256 one	= _mm256_set1_ps(1.0f);
+	__m256 sign	= _mm256_set1_ps(-0.0f);
+
+	for (int i = 0; i < count; i += 8) {
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&p.sphereX[i]), _mm256_loadu_ps(&p.boxX[i]));
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&p.sphereY[i]), _mm256_loadu_ps(&p.boxY[i]));
+		__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&p.sphereZ[i]), _mm256_loadu_ps(&p.boxZ[i]));
+
+		__m256 hx = _mm256_loadu_ps(&p.halfX[i]);
+		__m256 hy = _mm256_loadu_ps(&p.halfY[i]);
+		__m256 hz = _mm256_loadu_ps(&p.halfZ[i]);
+
+		__m256 lx = _mm256_sub_ps(dx, _mm256_min_ps(_mm256_max_ps(dx, _mm256_xor_ps(hx, sign)), hx));
+		__m256 ly = _mm256_sub_ps(dy, _mm256_min_ps(_mm256_max_ps(dy, _mm256_xor_ps(hy, sign)), hy));
+		__m256 lz = _mm256_sub_ps(dz, _mm256_min_ps(_mm256_max_ps(dz, _mm256_xor_ps(hz, sign)), hz));
+
+		__m256 radius	= _mm256_loadu_ps(&p.radius[i]);
+		__m256 distance	= _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz)));
+
+		__m256 touching	= _mm256_cmp_ps(distance, radius, _CMP_LT_OQ);
+		__m256 t		= _mm256_and_ps(_mm256_cmp_ps(distance, zero, _CMP_NEQ_UQ), _mm256_div_ps(one, distance));
+
+		_mm256_storeu_ps(&r.normalX[i], _mm256_mul_ps(lx, t));
+		_mm256_storeu_ps(&r.normalY[i], _mm256_mul_ps(ly, t));
+		_mm256_storeu_ps(&r.normalZ[i], _mm256_mul_ps(lz, t));
+		_mm256_storeu_ps(&r.penetration[i], _mm256_and_ps(touching, _mm256_sub_ps(radius, distance)));
+	}
+	return count;
+}
+#endif
+
+void NarrowPhaseKernels::SphereSphere(InstructionSet set, SphereSpherePairs& pairs) {
+	int done = 0;
+#ifdef USE_X86_KERNELS
+	if (set == InstructionSet::AVX) {
+		done = SphereSphereAVX(pairs);
+	}
+	else if (set == InstructionSet::SSE) {
+		done = SphereSphereSSE(pairs);
+	}
+#endif
+	SphereSphereScalar(done, pairs);
+}
+
+void NarrowPhaseKernels::AABBSphere(InstructionSet set, AABBSpherePairs& pairs) {
+	int done = 0;
+#ifdef USE_X86_KERNELS
+	if (set == InstructionSet::AVX) {
+		done = AABBSphereAVX(pairs);
+	}
+	else if (set == InstructionSet::SSE) {
+		done = AABBSphereSSE(pairs);
+	}
+#endif
+	AABBSphereScalar(done, pairs);
+}
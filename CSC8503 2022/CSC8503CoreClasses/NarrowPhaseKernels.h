@@ -0,0 +1,106 @@
+#pragma once
+#include "IntegrationKernels.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Sphere/sphere and AABB/sphere pairs make up most of the pairs in the
+		ball pit scenes, and testing one only takes a handful of numbers from
+		each object. The narrowphase gathers those numbers for each of these
+		pairs into arrays, one per component, and these test 4 (SSE) or 8 (AVX)
+		pairs at a time, using the same instruction set checks as the
+		integrators.
+
+		Every path gives exactly the same results as SphereIntersection and
+		AABBSphereIntersection, which are still used for everything the
+		narrowphase doesn't batch up, and can be switched back to for all of it
+		to check against.
+		*/
+		class NarrowPhaseKernels {
+		public:
+			using InstructionSet = IntegrationKernels::InstructionSet;
+
+			//What the kernels give back for each pair - a penetration above zero means it's touching
+			struct Results {
+				std::vector<float> normalX;
+				std::vector<float> normalY;
+				std::vector<float> normalZ;
+				std::vector<float> penetration;
+
+				void Resize(int count) {
+					normalX.resize(count);
+					normalY.resize(count);
+					normalZ.resize(count);
+					penetration.resize(count);
+				}
+			};
+
+			/*
+			Gathering a pair's numbers costs about as much as testing it does, so
+			the arrays are sized for the most pairs a batch could hold up front,
+			and Add just writes into the next slot, rather than growing every
+			array one at a time.
+			*/
+			struct SphereSpherePairs {
+				std::vector<int>	pairIndices; //Which broadphase pair each one came from
+				std::vector<float>	ax, ay, az, radiusA;
+				std::vector<float>	bx, by, bz, radiusB;
+				Results				results;
+				int					count = 0;
+
+				int Count() const {
+					return count;
+				}
+				void Begin(int maxCount);
+
+				void Add(int pairIndex, const Vector3& positionA, float rA, const Vector3& positionB, float rB) {
+					int i = count++;
+					pairIndices[i]	= pairIndex;
+					ax[i]			= positionA.x;
+					ay[i]			= positionA.y;
+					az[i]			= positionA.z;
+					radiusA[i]		= rA;
+					bx[i]			= positionB.x;
+					by[i]			= positionB.y;
+					bz[i]			= positionB.z;
+					radiusB[i]		= rB;
+				}
+			};
+
+			struct AABBSpherePairs {
+				std::vector<int>	pairIndices;
+				std::vector<float>	boxX, boxY, boxZ, halfX, halfY, halfZ;
+				std::vector<float>	sphereX, sphereY, sphereZ, radius;
+				Results				results;
+				int					count = 0;
+
+				int Count() const {
+					return count;
+				}
+				void Begin(int maxCount);
+
+				void Add(int pairIndex, const Vector3& boxPosition, const Vector3& halfSizes, const Vector3& spherePosition, float r) {
+					int i = count++;
+					pairIndices[i]	= pairIndex;
+					boxX[i]			= boxPosition.x;
+					boxY[i]			= boxPosition.y;
+					boxZ[i]			= boxPosition.z;
+					halfX[i]		= halfSizes.x;
+					halfY[i]		= halfSizes.y;
+					halfZ[i]		= halfSizes.z;
+					sphereX[i]		= spherePosition.x;
+					sphereY[i]		= spherePosition.y;
+					sphereZ[i]		= spherePosition.z;
+					radius[i]		= r;
+				}
+			};
+
+			static void SphereSphere(InstructionSet set, SphereSpherePairs& pairs);
+			static void AABBSphere(InstructionSet set, AABBSpherePairs& pairs);
+
+		private:
+			NarrowPhaseKernels()	{}
+			~NarrowPhaseKernels()	{}
+		};
+	}
+}
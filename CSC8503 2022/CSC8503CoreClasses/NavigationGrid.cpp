@@ -1,5 +1,6 @@
 #include "NavigationGrid.h"
 #include "Assets.h"
+#include "Profiler.h"
 
 #include <fstream>
 
@@ -76,6 +77,7 @@ NavigationGrid::~NavigationGrid()	{
 }
 
 bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+	PROFILE_SCOPE("NavigationGrid::FindPath");
 	//need to work out which node 'from' sits in, and 'to' sits in
 	int fromX = ((int)from.x - 200 / nodeSize);
 	int fromZ = ((int)from.z - 180 / nodeSize);
@@ -1,6 +1,7 @@
 #include "NavigationMesh.h"
 #include "Assets.h"
 #include "Maths.h"
+#include "Profiler.h"
 #include <fstream>
 using namespace NCL;
 using namespace CSC8503;
@@ -66,6 +67,7 @@ NavigationMesh::~NavigationMesh()
 }
 
 bool NavigationMesh::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+	PROFILE_SCOPE("NavigationMesh::FindPath");
 	const NavTri* start	= GetTriForPosition(from);
 	const NavTri* end	= GetTriForPosition(to);
 
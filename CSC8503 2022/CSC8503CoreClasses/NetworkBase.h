@@ -1,4 +1,5 @@
 #pragma once
+#include <cstring>
 //#include "./enet/enet.h"
 struct _ENetHost;
 struct _ENetPeer;
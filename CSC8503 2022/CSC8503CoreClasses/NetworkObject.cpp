@@ -1,5 +1,4 @@
 #include "NetworkObject.h"
-#include "./enet/enet.h"
 using namespace NCL;
 using namespace CSC8503;
 
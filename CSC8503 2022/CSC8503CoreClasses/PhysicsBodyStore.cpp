@@ -0,0 +1,219 @@
+#include "PhysicsBodyStore.h"
+#include "PhysicsObject.h"
+#include "Transform.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+PhysicsBodyStore::PhysicsBodyStore() {
+	awakeCount = 0;
+}
+
+PhysicsBodyStore::~PhysicsBodyStore() {
+	Clear();
+}
+
+template<class Func>
+void PhysicsBodyStore::OperateOnArrays(Func&& func) {
+	Vector3Array* vectorArrays[] = { &positions, &previousPositions, &linearVelocities, &angularVelocities, &forces, &torques, &inverseInertias };
+	for (Vector3Array* a : vectorArrays) {
+		func(a->x);
+		func(a->y);
+		func(a->z);
+	}
+	QuaternionArray* quaternionArrays[] = { &orientations, &previousOrientations };
+	for (QuaternionArray* a : quaternionArrays) {
+		func(a->x);
+		func(a->y);
+		func(a->z);
+		func(a->w);
+	}
+	func(inverseMasses);
+	func(sleepTimers);
+}
+
+void PhysicsBodyStore::Clear() {
+	while (!owners.empty()) {
+		RemoveBody((int)owners.size() - 1);
+	}
+}
+
+/*
+New bodies always start off awake, so they're moved down to the end of
+the awake bodies.
+*/
+void PhysicsBodyStore::AddBody(PhysicsObject* object, Transform* transform) {
+	int index = (int)owners.size();
+
+	owners.push_back(object);
+	transforms.push_back(transform);
+	OperateOnArrays([](std::vector<float>& a) {
+		a.push_back(0.0f);
+	});
+	inverseInertiaTensors.push_back(object->inverseInteriaTensor);
+
+	positions.Set(index, transform->GetPosition());
+	orientations.Set(index, transform->GetOrientation());
+	previousPositions.Set(index, transform->GetPosition());
+	previousOrientations.Set(index, transform->GetOrientation());
+
+	linearVelocities.Set(index, object->linearVelocity);
+	angularVelocities.Set(index, object->angularVelocity);
+	forces.Set(index, object->force);
+	torques.Set(index, object->torque);
+	inverseMasses[index] = object->inverseMass;
+	inverseInertias.Set(index, object->inverseInertia);
+
+	object->bodyStore = this;
+	object->bodyIndex = index;
+
+	SwapBodies(index, awakeCount);
+	awakeCount++;
+}
+
+/*
+The body's state is copied back into its PhysicsObject, so it carries on
+where it left off if it's added to a store again later. The gap it leaves
+is filled from the end of its own half of the arrays, and that gap from
+the end of the arrays, so the awake and sleeping bodies stay packed.
+*/
+void PhysicsBodyStore::RemoveBody(int index) {
+	PhysicsObject* object = owners[index];
+
+	object->linearVelocity			= linearVelocities.Get(index);
+	object->angularVelocity			= angularVelocities.Get(index);
+	object->force					= forces.Get(index);
+	object->torque					= torques.Get(index);
+	object->inverseMass				= inverseMasses[index];
+	object->inverseInertia			= inverseInertias.Get(index);
+	object->inverseInteriaTensor	= inverseInertiaTensors[index];
+
+	if (index < awakeCount) {
+		SwapBodies(index, awakeCount - 1);
+		index = awakeCount - 1;
+		awakeCount--;
+	}
+	int last = (int)owners.size() - 1;
+	SwapBodies(index, last);
+
+	owners.pop_back();
+	transforms.pop_back();
+	inverseInertiaTensors.pop_back();
+	OperateOnArrays([](std::vector<float>& a) {
+		a.pop_back();
+	});
+
+	object->bodyStore = nullptr;
+	object->bodyIndex = -1;
+}
+
+void PhysicsBodyStore::SwapBodies(int a, int b) {
+	if (a == b) {
+		return;
+	}
+	std::swap(owners[a], owners[b]);
+	std::swap(transforms[a], transforms[b]);
+	std::swap(inverseInertiaTensors[a], inverseInertiaTensors[b]);
+	OperateOnArrays([&](std::vector<float>& array) {
+		std::swap(array[a], array[b]);
+	});
+	owners[a]->bodyIndex = a;
+	owners[b]->bodyIndex = b;
+}
+
+/*
+Putting a body to sleep swaps it with the last awake body, and waking one
+swaps it with the first sleeping body, so either way it just moves across
+the boundary between the two. A sleeping body's pose might be out of date,
+so it's read back in from its Transform as it wakes.
+*/
+int PhysicsBodyStore::SetAwake(int index, bool awake) {
+	if (awake == IsAwake(index)) {
+		return index;
+	}
+	sleepTimers[index] = 0.0f;
+	if (awake) {
+		positions.Set(index, transforms[index]->GetPosition());
+		orientations.Set(index, transforms[index]->GetOrientation());
+		previousPositions.Set(index, positions.Get(index));
+		previousOrientations.Set(index, orientations.Get(index));
+		SwapBodies(index, awakeCount);
+		return awakeCount++;
+	}
+	linearVelocities.Set(index, Vector3());
+	angularVelocities.Set(index, Vector3());
+	awakeCount--;
+	SwapBodies(index, awakeCount);
+	return awakeCount;
+}
+
+//Something else has moved a sleeping body, so it had better check where it is now
+void PhysicsBodyStore::WakeMovedBodies() {
+	for (int i = awakeCount; i < (int)owners.size(); ++i) {
+		if (transforms[i]->GetPosition() != positions.Get(i) ||
+			transforms[i]->GetOrientation() != orientations.Get(i)) {
+			SetAwake(i, true); //An unchecked sleeper might have been swapped into i
+			i = std::max(i, awakeCount) - 1;
+		}
+	}
+}
+
+//Anything that's been moved since it was scattered has been teleported, so there's nothing to blend from
+void PhysicsBodyStore::GatherPoses() {
+	for (int i = 0; i < awakeCount; ++i) {
+		Vector3		position	= transforms[i]->GetPosition();
+		Quaternion	orientation	= transforms[i]->GetOrientation();
+		if (position != positions.Get(i) || orientation != orientations.Get(i)) {
+			previousPositions.Set(i, position);
+			previousOrientations.Set(i, orientation);
+		}
+		positions.Set(i, position);
+		orientations.Set(i, orientation);
+	}
+}
+
+void PhysicsBodyStore::ScatterPoses() {
+	for (int i = 0; i < awakeCount; ++i) {
+		transforms[i]->SetPosition(positions.Get(i));
+		transforms[i]->SetOrientation(orientations.Get(i));
+	}
+}
+
+void PhysicsBodyStore::GatherPositions() {
+	for (int i = 0; i < awakeCount; ++i) {
+		positions.Set(i, transforms[i]->GetPosition());
+	}
+}
+
+void PhysicsBodyStore::StorePreviousPoses() {
+	std::copy(positions.x.begin(), positions.x.begin() + awakeCount, previousPositions.x.begin());
+	std::copy(positions.y.begin(), positions.y.begin() + awakeCount, previousPositions.y.begin());
+	std::copy(positions.z.begin(), positions.z.begin() + awakeCount, previousPositions.z.begin());
+	std::copy(orientations.x.begin(), orientations.x.begin() + awakeCount, previousOrientations.x.begin());
+	std::copy(orientations.y.begin(), orientations.y.begin() + awakeCount, previousOrientations.y.begin());
+	std::copy(orientations.z.begin(), orientations.z.begin() + awakeCount, previousOrientations.z.begin());
+	std::copy(orientations.w.begin(), orientations.w.begin() + awakeCount, previousOrientations.w.begin());
+}
+
+/*
+The orientations are blended with a normalised lerp - over a single step
+they won't have turned far enough for it to look any different to a slerp.
+*/
+void PhysicsBodyStore::InterpolatePoses(float alpha) {
+	for (int i = 0; i < awakeCount; ++i) {
+		Vector3		previous	= previousPositions.Get(i);
+		Vector3		position	= previous + (positions.Get(i) - previous) * alpha;
+		Quaternion	orientation	= Quaternion::Lerp(previousOrientations.Get(i), orientations.Get(i), alpha);
+		orientation.Normalise();
+		transforms[i]->SetRenderPose(position, orientation);
+	}
+}
+
+void PhysicsBodyStore::ClearForces() {
+	Vector3Array* vectorArrays[] = { &forces, &torques };
+	for (Vector3Array* a : vectorArrays) {
+		std::fill(a->x.begin(), a->x.end(), 0.0f);
+		std::fill(a->y.begin(), a->y.end(), 0.0f);
+		std::fill(a->z.begin(), a->z.end(), 0.0f);
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+using namespace NCL::Maths;
+
+namespace NCL {
+	namespace CSC8503 {
+		class PhysicsObject;
+		class Transform;
+
+		/*
+		Holds the state of every body the PhysicsSystem integrates, with each
+		component of each property in its own tightly packed array, rather than
+		spread out across lots of separately allocated PhysicsObjects. The
+		integrators can then walk straight down these arrays, rather than chasing
+		pointers from GameObject to PhysicsObject to Transform for every body.
+
+		Once a PhysicsObject has been added, its getters and setters read and
+		write its slot in here instead of its own members, so gameplay code
+		doesn't need to know whether its object is in a store or not.
+
+		The awake bodies are all kept at the front of the arrays, and the
+		sleeping ones after them, so the integrators only need to run over
+		the first GetAwakeCount() bodies.
+		*/
+		class PhysicsBodyStore {
+		public:
+			struct Vector3Array {
+				std::vector<float> x;
+				std::vector<float> y;
+				std::vector<float> z;
+
+				Vector3 Get(int i) const {
+					return Vector3(x[i], y[i], z[i]);
+				}
+				void Set(int i, const Vector3& v) {
+					x[i] = v.x;
+					y[i] = v.y;
+					z[i] = v.z;
+				}
+			};
+
+			struct QuaternionArray {
+				std::vector<float> x;
+				std::vector<float> y;
+				std::vector<float> z;
+				std::vector<float> w;
+
+				Quaternion Get(int i) const {
+					return Quaternion(x[i], y[i], z[i], w[i]);
+				}
+				void Set(int i, const Quaternion& q) {
+					x[i] = q.x;
+					y[i] = q.y;
+					z[i] = q.z;
+					w[i] = q.w;
+				}
+			};
+
+			PhysicsBodyStore();
+			~PhysicsBodyStore();
+
+			//Hands every body's state back to its PhysicsObject
+			void Clear();
+
+			void AddBody(PhysicsObject* object, Transform* transform);
+			void RemoveBody(int index);
+
+			int GetBodyCount() const {
+				return (int)owners.size();
+			}
+
+			int GetAwakeCount() const {
+				return awakeCount;
+			}
+
+			bool IsAwake(int index) const {
+				return index < awakeCount;
+			}
+
+			//Moves the body to the other side of the awake / asleep boundary, returning its new index
+			int SetAwake(int index, bool awake);
+			void WakeMovedBodies();
+
+			PhysicsObject* GetOwner(int index) const {
+				return owners[index];
+			}
+
+			//Copies the position and orientation of every body in from its Transform
+			void GatherPoses();
+			//...and back out again, once they've been integrated
+			void ScatterPoses();
+			//Only the positions - collisions and constraints move objects, but don't turn them
+			void GatherPositions();
+
+			//Remembers where the awake bodies are before they're stepped...
+			void StorePreviousPoses();
+			//...so that their Transforms can be drawn somewhere between there and where they are now
+			void InterpolatePoses(float alpha);
+
+			void ClearForces();
+
+			Vector3Array	positions;
+			QuaternionArray	orientations;
+
+			Vector3Array	previousPositions;
+			QuaternionArray	previousOrientations;
+
+			Vector3Array	linearVelocities;
+			Vector3Array	angularVelocities;
+			Vector3Array	forces;
+			Vector3Array	torques;
+
+			std::vector<float>		inverseMasses;
+			Vector3Array			inverseInertias;
+			std::vector<Matrix3>	inverseInertiaTensors;
+
+			//How long each body has been moving slowly enough to sleep
+			std::vector<float>		sleepTimers;
+
+		protected:
+			template<class Func>
+			void OperateOnArrays(Func&& func);
+
+			void SwapBodies(int a, int b);
+
+			std::vector<PhysicsObject*>	owners;
+			std::vector<Transform*>		transforms;
+			int							awakeCount;
+		};
+	}
+}
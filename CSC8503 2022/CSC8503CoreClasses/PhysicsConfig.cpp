@@ -0,0 +1,103 @@
+#include "PhysicsConfig.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace NCL;
+using namespace CSC8503;
+
+const char* PhysicsConfig::GetBroadPhaseName(BroadPhaseType type) {
+	switch (type) {
+		case BroadPhaseType::AABBTree:		return "tree";
+		case BroadPhaseType::SweepAndPrune:	return "sap";
+		default:							return "none";
+	}
+}
+
+bool PhysicsConfig::GetBroadPhaseFromName(const std::string& name, BroadPhaseType& type) {
+	for (BroadPhaseType t : { BroadPhaseType::None, BroadPhaseType::AABBTree, BroadPhaseType::SweepAndPrune }) {
+		if (name == GetBroadPhaseName(t)) {
+			type = t;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool PhysicsConfig::ReadSetting(const std::string& name, std::istream& values) {
+	if (name == "broadphase") {
+		std::string type;
+		values >> type;
+		return GetBroadPhaseFromName(type, broadPhase);
+	}
+	if (name == "gravity") {
+		return (bool)(values >> useGravity);
+	}
+	if (name == "gravityvector") {
+		return (bool)(values >> gravity.x >> gravity.y >> gravity.z);
+	}
+	if (name == "damping") {
+		return (bool)(values >> linearDamping >> angularDamping);
+	}
+	if (name == "iterations") {
+		return (bool)(values >> constraintIterations);
+	}
+	if (name == "stephz") {
+		return (bool)(values >> stepHZ);
+	}
+	if (name == "maxsubsteps") {
+		return (bool)(values >> maxSubsteps);
+	}
+	if (name == "interpolation") {
+		return (bool)(values >> interpolation);
+	}
+	if (name == "sleeping") {
+		return (bool)(values >> sleeping);
+	}
+	if (name == "sleeptolerances") {
+		return (bool)(values >> linearSleepTolerance >> angularSleepTolerance);
+	}
+	if (name == "timetosleep") {
+		return (bool)(values >> timeToSleep);
+	}
+	return false;
+}
+
+bool PhysicsConfig::LoadFromFile(const std::string& filename) {
+	std::ifstream infile(filename);
+	if (!infile) {
+		std::cout << "PhysicsConfig: can't open " << filename << std::endl;
+		return false;
+	}
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(infile, text)) {
+		++lineNumber;
+		text = text.substr(0, text.find('#'));
+
+		std::istringstream line(text);
+		std::string name;
+		if (!(line >> name)) {
+			continue;
+		}
+		if (!ReadSetting(name, line)) {
+			std::cout << "PhysicsConfig: " << filename << " line " << lineNumber << ": can't read '" << name << "'" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void PhysicsConfig::Write(std::ostream& out) const {
+	out << "broadphase\t\t"		<< GetBroadPhaseName(broadPhase) << "\n";
+	out << "gravity\t\t\t"		<< useGravity << "\n";
+	out << "gravityvector\t\t"	<< gravity.x << " " << gravity.y << " " << gravity.z << "\n";
+	out << "damping\t\t\t"		<< linearDamping << " " << angularDamping << "\n";
+	out << "iterations\t\t"		<< constraintIterations << "\n";
+	out << "stephz\t\t\t"		<< stepHZ << "\n";
+	out << "maxsubsteps\t\t"	<< maxSubsteps << "\n";
+	out << "interpolation\t\t"	<< interpolation << "\n";
+	out << "sleeping\t\t"		<< sleeping << "\n";
+	out << "sleeptolerances\t\t"<< linearSleepTolerance << " " << angularSleepTolerance << "\n";
+	out << "timetosleep\t\t"	<< timeToSleep << "\n";
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <istream>
+#include <ostream>
+#include "Vector3.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		using Maths::Vector3;
+
+		/*
+		Every setting that changes how a PhysicsSystem simulates, gathered up
+		so that they can be handed over in one go - by the game, a server, or
+		a benchmark - and saved to or loaded from a file, without the physics
+		having to know where they came from.
+
+		Settings files have one setting per line, as the setting's name then
+		its values, and anything after a # is ignored:
+
+			broadphase			none|tree|sap
+			gravity				<0|1>
+			gravityvector		<x> <y> <z>
+			damping				<linear> <angular>
+			iterations			<count>
+			stephz				<rate>
+			maxsubsteps			<count>
+			interpolation		<0|1>
+			sleeping			<0|1>
+			sleeptolerances		<linear> <angular>
+			timetosleep			<seconds>
+		*/
+		struct PhysicsConfig {
+			enum class BroadPhaseType {
+				None,			//Every pair is tested, via BasicCollisionDetection
+				AABBTree,		//Persistent dynamic AABB tree, via BroadPhase
+				SweepAndPrune	//Sorted endpoint arrays, via SortAndSweep
+			};
+
+			BroadPhaseType broadPhase = BroadPhaseType::None;
+
+			bool	useGravity		= false;
+			Vector3	gravity			= Vector3(0.0f, -9.8f, 0.0f);
+
+			//How much velocity is lost per second
+			float	linearDamping	= 0.4f;
+			float	angularDamping	= 0.4f;
+
+			//How many times the constraints and contacts are solved each step
+			int		constraintIterations = 10;
+
+			int		stepHZ			= 120;
+			int		maxSubsteps		= 8;
+			bool	interpolation	= true;
+
+			bool	sleeping				= true;
+			float	linearSleepTolerance	= 0.1f;	//units per second
+			float	angularSleepTolerance	= 0.1f;	//radians per second
+			float	timeToSleep				= 0.5f;
+
+			//Reads the values of the named setting from the rest of a line, returning false if it's not one
+			bool ReadSetting(const std::string& name, std::istream& values);
+
+			//Settings the file doesn't mention are left as they are
+			bool LoadFromFile(const std::string& filename);
+			void Write(std::ostream& out) const;
+
+			static const char*	GetBroadPhaseName(BroadPhaseType type);
+			static bool			GetBroadPhaseFromName(const std::string& name, BroadPhaseType& type);
+		};
+	}
+}
@@ -0,0 +1,189 @@
+#include "PhysicsIslands.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+PhysicsIslands::PhysicsIslands() {
+}
+
+PhysicsIslands::~PhysicsIslands() {
+}
+
+void PhysicsIslands::Reset(int bodyCount) {
+	parents.resize(bodyCount);
+	sizes.assign(bodyCount, 1);
+	for (int i = 0; i < bodyCount; ++i) {
+		parents[i] = i;
+	}
+	contacts.clear();
+	constraints.clear();
+	islands.clear();
+}
+
+void PhysicsIslands::AddContact(int contact, int bodyA, int bodyB) {
+	if (bodyA < 0 && bodyB < 0) {
+		return;
+	}
+	contacts.push_back({ contact, bodyA, bodyB });
+	Join(bodyA, bodyB);
+}
+
+void PhysicsIslands::AddConstraint(int constraint, int bodyA, int bodyB) {
+	if (bodyA < 0 && bodyB < 0) {
+		return;
+	}
+	constraints.push_back({ constraint, bodyA, bodyB });
+	Join(bodyA, bodyB);
+}
+
+//Each step up the tree points a body at its grandparent, so the paths stay short
+int PhysicsIslands::FindRoot(int body) {
+	while (parents[body] != body) {
+		parents[body] = parents[parents[body]];
+		body = parents[body];
+	}
+	return body;
+}
+
+//The smaller tree is hung off the bigger one, again to keep the paths short
+void PhysicsIslands::Join(int bodyA, int bodyB) {
+	if (bodyA < 0 || bodyB < 0) {
+		return;
+	}
+	int rootA = FindRoot(bodyA);
+	int rootB = FindRoot(bodyB);
+	if (rootA == rootB) {
+		return;
+	}
+	if (sizes[rootA] < sizes[rootB]) {
+		std::swap(rootA, rootB);
+	}
+	parents[rootB] = rootA;
+	sizes[rootA] += sizes[rootB];
+}
+
+/*
+Every body's root is given an island number the first time it's seen, and
+then a counting sort puts each island's bodies, contacts and constraints
+next to each other. Islands come out in the order of their lowest body,
+so the same scene always gives the same islands.
+*/
+void PhysicsIslands::Build() {
+	int bodyCount = (int)parents.size();
+
+	islands.clear();
+	islandOfBody.assign(bodyCount, -1);
+	for (int i = 0; i < bodyCount; ++i) {
+		int root = FindRoot(i);
+		if (islandOfBody[root] < 0) {
+			islandOfBody[root] = (int)islands.size();
+			islands.push_back({ 0, 0, 0, 0, 0, 0 });
+		}
+		islandOfBody[i] = islandOfBody[root];
+		islands[islandOfBody[i]].bodyCount++;
+	}
+
+	int next = 0;
+	for (Island& island : islands) {
+		island.firstBody	= next;
+		next				+= island.bodyCount;
+		island.bodyCount	= 0;
+	}
+	islandBodies.resize(bodyCount);
+	for (int i = 0; i < bodyCount; ++i) {
+		Island& island = islands[islandOfBody[i]];
+		islandBodies[island.firstBody + island.bodyCount++] = i;
+	}
+
+	GroupLinks(contacts, groupedContacts, islandContacts, islandStarts);
+	for (int i = 0; i < (int)islands.size(); ++i) {
+		islands[i].firstContact	= islandStarts[i];
+		islands[i].contactCount	= islandStarts[i + 1] - islandStarts[i];
+	}
+	GroupLinks(constraints, groupedConstraints, islandConstraints, islandStarts);
+	for (int i = 0; i < (int)islands.size(); ++i) {
+		islands[i].firstConstraint	= islandStarts[i];
+		islands[i].constraintCount	= islandStarts[i + 1] - islandStarts[i];
+	}
+}
+
+void PhysicsIslands::GroupLinks(const std::vector<Link>& links, std::vector<Link>& grouped, std::vector<int>& output, std::vector<int>& starts) {
+	starts.assign(islands.size() + 1, 0);
+	for (const Link& l : links) {
+		starts[islandOfBody[l.bodyA >= 0 ? l.bodyA : l.bodyB] + 1]++;
+	}
+	for (int i = 1; i < (int)starts.size(); ++i) {
+		starts[i] += starts[i - 1];
+	}
+	std::vector<int> filled(starts.begin(), starts.end() - 1);
+	grouped.resize(links.size());
+	output.resize(links.size());
+	for (const Link& l : links) {
+		int island	= islandOfBody[l.bodyA >= 0 ? l.bodyA : l.bodyB];
+		int slot	= filled[island]++;
+		grouped[slot]	= l;
+		output[slot]	= l.index;
+	}
+}
+
+/*
+A greedy colouring, working through the constraints and then the contacts,
+in the order they're added. Both share the same colour masks, so a constraint and a contact of the same
+colour never touch the same body either.
+*/
+void PhysicsIslands::ColourIsland(int index, Colouring& colouring) {
+	const Island& island = islands[index];
+
+	bodyColours.resize(parents.size());
+	for (int i = 0; i < island.bodyCount; ++i) {
+		bodyColours[islandBodies[island.firstBody + i]] = 0;
+	}
+	ColourLinks(groupedConstraints.data() + island.firstConstraint, island.constraintCount, colouring.constraintStarts, colouring.constraints);
+	ColourLinks(groupedContacts.data() + island.firstContact, island.contactCount, colouring.contactStarts, colouring.contacts);
+
+	bool constraintsOverflowed	= colouring.constraintStarts[MAX_COLOURS] > colouring.constraintStarts[MAX_COLOURS - 1];
+	bool contactsOverflowed		= colouring.contactStarts[MAX_COLOURS] > colouring.contactStarts[MAX_COLOURS - 1];
+
+	colouring.overflowed	= constraintsOverflowed || contactsOverflowed;
+	colouring.colourCount	= 0;
+	for (int i = 0; i < MAX_COLOURS; ++i) {
+		if (colouring.constraintStarts[i + 1] > colouring.constraintStarts[i] ||
+			colouring.contactStarts[i + 1] > colouring.contactStarts[i]) {
+			colouring.colourCount = i + 1;
+		}
+	}
+}
+
+void PhysicsIslands::ColourLinks(const Link* links, int count, std::vector<int>& starts, std::vector<int>& output) {
+	const int overflowColour = MAX_COLOURS - 1;
+
+	linkColours.resize(count);
+	starts.assign(MAX_COLOURS + 1, 0);
+	for (int i = 0; i < count; ++i) {
+		const Link& l = links[i];
+		uint32_t used = (l.bodyA >= 0 ? bodyColours[l.bodyA] : 0) | (l.bodyB >= 0 ? bodyColours[l.bodyB] : 0);
+
+		int colour = 0;
+		while (colour < overflowColour && (used & (1u << colour))) {
+			colour++;
+		}
+		if (colour < overflowColour) {
+			if (l.bodyA >= 0) {
+				bodyColours[l.bodyA] |= 1u << colour;
+			}
+			if (l.bodyB >= 0) {
+				bodyColours[l.bodyB] |= 1u << colour;
+			}
+		}
+		linkColours[i] = colour;
+		starts[colour + 1]++;
+	}
+	for (int i = 1; i <= MAX_COLOURS; ++i) {
+		starts[i] += starts[i - 1];
+	}
+	std::vector<int> filled(starts.begin(), starts.end() - 1);
+	output.resize(count);
+	for (int i = 0; i < count; ++i) {
+		output[filled[linkColours[i]]++] = links[i].index;
+	}
+}
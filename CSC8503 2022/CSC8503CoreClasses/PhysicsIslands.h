@@ -0,0 +1,117 @@
+#pragma once
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Splits the awake bodies up into islands - groups of bodies that are
+		touching, or constrained to each other, either directly or through
+		other bodies in the group. Nothing that happens in one island can
+		affect another, so each can be put to sleep (or solved) on its own.
+
+		Bodies are linked up with a union-find, and then each island's bodies,
+		contacts and constraints are packed together, so that an island's are
+		all in one run of each array. Static bodies (those with an inverse mass
+		of zero) never link islands together - a pile of boxes on one side of
+		the floor has nothing to do with a pile on the other side.
+		*/
+		class PhysicsIslands {
+		public:
+			struct Island {
+				int firstBody;
+				int bodyCount;
+				int firstContact;
+				int contactCount;
+				int firstConstraint;
+				int constraintCount;
+			};
+
+			/*
+			An island's constraints and contacts split up into colours, where
+			nothing in a colour shares a dynamic body with anything else in it,
+			so a whole colour can be solved at once. Anything that wouldn't fit
+			into the colours available ends up in the last one, which has to be
+			solved on one thread if overflowed is set.
+			*/
+			struct Colouring {
+				int					colourCount;
+				bool				overflowed;
+				std::vector<int>	constraintStarts;
+				std::vector<int>	constraints;
+				std::vector<int>	contactStarts;
+				std::vector<int>	contacts;
+			};
+
+			static const int MAX_COLOURS = 32;
+
+			PhysicsIslands();
+			~PhysicsIslands();
+
+			//Starts again with every one of bodyCount bodies in an island of its own
+			void Reset(int bodyCount);
+
+			//Body indices of -1 are for static bodies, which don't join anything
+			void AddContact(int contact, int bodyA, int bodyB);
+			void AddConstraint(int constraint, int bodyA, int bodyB);
+
+			void Build();
+
+			int GetIslandCount() const {
+				return (int)islands.size();
+			}
+
+			const Island& GetIsland(int index) const {
+				return islands[index];
+			}
+
+			//These hold the indices given above, island by island
+			const std::vector<int>& GetBodies() const {
+				return islandBodies;
+			}
+
+			const std::vector<int>& GetContacts() const {
+				return islandContacts;
+			}
+
+			const std::vector<int>& GetConstraints() const {
+				return islandConstraints;
+			}
+
+			void ColourIsland(int island, Colouring& colouring);
+
+		protected:
+			struct Link {
+				int index;
+				int bodyA;
+				int bodyB;
+			};
+
+			int  FindRoot(int body);
+			void Join(int bodyA, int bodyB);
+
+			//Sorts the links into island order, noting where each island's run starts
+			void GroupLinks(const std::vector<Link>& links, std::vector<Link>& grouped, std::vector<int>& output, std::vector<int>& islandStarts);
+
+			//Gives each link the lowest colour neither of its bodies is in yet
+			void ColourLinks(const Link* links, int count, std::vector<int>& starts, std::vector<int>& output);
+
+			std::vector<int>	parents;
+			std::vector<int>	sizes;
+
+			std::vector<Link>	contacts;
+			std::vector<Link>	constraints;
+			std::vector<Link>	groupedContacts;
+			std::vector<Link>	groupedConstraints;
+
+			std::vector<int>	islandOfBody;
+			std::vector<int>	islandStarts;
+
+			std::vector<Island>	islands;
+			std::vector<int>	islandBodies;
+			std::vector<int>	islandContacts;
+			std::vector<int>	islandConstraints;
+
+			std::vector<uint32_t>	bodyColours;
+			std::vector<int>		linkColours;
+		};
+	}
+}
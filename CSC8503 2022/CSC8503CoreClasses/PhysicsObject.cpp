@@ -1,5 +1,6 @@
 #include "PhysicsObject.h"
 #include "PhysicsSystem.h"
+#include "PhysicsBodyStore.h"
 #include "Transform.h"
 using namespace NCL;
 using namespace CSC8503;
@@ -8,39 +9,121 @@ PhysicsObject::PhysicsObject(Transform* parentTransform, const CollisionVolume*
 	transform	= parentTransform;
 	volume		= parentVolume;
 
+	bodyStore	= nullptr;
+	bodyIndex	= -1;
+
 	inverseMass = 1.0f;
 	elasticity	= 0.8f;
 	friction	= 0.8f;
+
+	continuousCollision = false;
 }
 
 PhysicsObject::~PhysicsObject()	{
+	if (bodyStore) {
+		bodyStore->RemoveBody(bodyIndex);
+	}
+}
+
+Vector3 PhysicsObject::GetLinearVelocity() const {
+	return bodyStore ? bodyStore->linearVelocities.Get(bodyIndex) : linearVelocity;
+}
+
+Vector3 PhysicsObject::GetAngularVelocity() const {
+	return bodyStore ? bodyStore->angularVelocities.Get(bodyIndex) : angularVelocity;
+}
+
+Vector3 PhysicsObject::GetTorque() const {
+	return bodyStore ? bodyStore->torques.Get(bodyIndex) : torque;
+}
+
+Vector3 PhysicsObject::GetForce() const {
+	return bodyStore ? bodyStore->forces.Get(bodyIndex) : force;
+}
+
+void PhysicsObject::SetInverseMass(float invMass) {
+	if (bodyStore) {
+		Wake();
+		bodyStore->inverseMasses[bodyIndex] = invMass;
+	}
+	inverseMass = invMass;
+}
+
+float PhysicsObject::GetInverseMass() const {
+	return bodyStore ? bodyStore->inverseMasses[bodyIndex] : inverseMass;
+}
 
+void PhysicsObject::SetLinearVelocity(const Vector3& v) {
+	if (bodyStore) {
+		Wake();
+		bodyStore->linearVelocities.Set(bodyIndex, v);
+		return;
+	}
+	linearVelocity = v;
+}
+
+void PhysicsObject::SetAngularVelocity(const Vector3& v) {
+	if (bodyStore) {
+		Wake();
+		bodyStore->angularVelocities.Set(bodyIndex, v);
+		return;
+	}
+	angularVelocity = v;
+}
+
+Matrix3 PhysicsObject::GetInertiaTensor() const {
+	return bodyStore ? bodyStore->inverseInertiaTensors[bodyIndex] : inverseInteriaTensor;
+}
+
+bool PhysicsObject::IsAsleep() const {
+	return bodyStore && !bodyStore->IsAwake(bodyIndex);
+}
+
+void PhysicsObject::Wake() {
+	if (bodyStore) {
+		bodyStore->SetAwake(bodyIndex, true);
+	}
 }
 
 void PhysicsObject::ApplyAngularImpulse(const Vector3& force) {
-	angularVelocity += inverseInteriaTensor * force;
+	SetAngularVelocity(GetAngularVelocity() + GetInertiaTensor() * force);
 }
 
 void PhysicsObject::ApplyLinearImpulse(const Vector3& force) {
-	linearVelocity += force * inverseMass;
+	SetLinearVelocity(GetLinearVelocity() + force * GetInverseMass());
 }
 
 void PhysicsObject::AddForce(const Vector3& addedForce) {
+	if (bodyStore) {
+		Wake();
+		bodyStore->forces.Set(bodyIndex, bodyStore->forces.Get(bodyIndex) + addedForce);
+		return;
+	}
 	force += addedForce;
 }
 
 void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3& position) {
 	Vector3 localPos = position - transform->GetPosition();
 
-	force  += addedForce;
-	torque += Vector3::Cross(localPos, addedForce);
+	AddForce(addedForce);
+	AddTorque(Vector3::Cross(localPos, addedForce));
 }
 
 void PhysicsObject::AddTorque(const Vector3& addedTorque) {
+	if (bodyStore) {
+		Wake();
+		bodyStore->torques.Set(bodyIndex, bodyStore->torques.Get(bodyIndex) + addedTorque);
+		return;
+	}
 	torque += addedTorque;
 }
 
 void PhysicsObject::ClearForces() {
+	if (bodyStore) {
+		bodyStore->forces.Set(bodyIndex, Vector3());
+		bodyStore->torques.Set(bodyIndex, Vector3());
+		return;
+	}
 	force				= Vector3();
 	torque				= Vector3();
 }
@@ -52,23 +135,40 @@ void PhysicsObject::InitCubeInertia() {
 
 	Vector3 dimsSqr		= fullWidth * fullWidth;
 
-	inverseInertia.x = (12.0f * inverseMass) / (dimsSqr.y + dimsSqr.z);
-	inverseInertia.y = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.z);
-	inverseInertia.z = (12.0f * inverseMass) / (dimsSqr.x + dimsSqr.y);
+	float invMass = GetInverseMass();
+
+	inverseInertia.x = (12.0f * invMass) / (dimsSqr.y + dimsSqr.z);
+	inverseInertia.y = (12.0f * invMass) / (dimsSqr.x + dimsSqr.z);
+	inverseInertia.z = (12.0f * invMass) / (dimsSqr.x + dimsSqr.y);
+
+	if (bodyStore) {
+		bodyStore->inverseInertias.Set(bodyIndex, inverseInertia);
+	}
 }
 
 void PhysicsObject::InitSphereInertia() {
 	float radius	= transform->GetScale().GetMaxElement();
-	float i			= 2.5f * inverseMass / (radius*radius);
+	float i			= 2.5f * GetInverseMass() / (radius*radius);
 
 	inverseInertia	= Vector3(i, i, i);
+
+	if (bodyStore) {
+		bodyStore->inverseInertias.Set(bodyIndex, inverseInertia);
+	}
 }
 
 void PhysicsObject::UpdateInertiaTensor() {
 	Quaternion q = transform->GetOrientation();
-	
+
 	Matrix3 invOrientation	= Matrix3(q.Conjugate());
 	Matrix3 orientation		= Matrix3(q);
 
-	inverseInteriaTensor = orientation * Matrix3::Scale(inverseInertia) *invOrientation;
-}
\ No newline at end of file
+	Vector3 invInertia = bodyStore ? bodyStore->inverseInertias.Get(bodyIndex) : inverseInertia;
+
+	Matrix3 tensor = orientation * Matrix3::Scale(invInertia) *invOrientation;
+	if (bodyStore) {
+		bodyStore->inverseInertiaTensors[bodyIndex] = tensor;
+		return;
+	}
+	inverseInteriaTensor = tensor;
+}
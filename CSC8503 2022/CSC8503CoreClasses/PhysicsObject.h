@@ -6,34 +6,37 @@ namespace NCL {
 	
 	namespace CSC8503 {
 		class Transform;
+		class PhysicsBodyStore;
 
 		class PhysicsObject	{
+			friend class PhysicsBodyStore;
 		public:
 			PhysicsObject(Transform* parentTransform, const CollisionVolume* parentVolume);
 			~PhysicsObject();
 
-			Vector3 GetLinearVelocity() const {
-				return linearVelocity;
-			}
+			Vector3 GetLinearVelocity() const;
+			Vector3 GetAngularVelocity() const;
 
-			Vector3 GetAngularVelocity() const {
-				return angularVelocity;
-			}
+			Vector3 GetTorque() const;
+			Vector3 GetForce() const;
 
-			Vector3 GetTorque() const {
-				return torque;
+			void SetInverseMass(float invMass);
+			float GetInverseMass() const;
+
+			void SetElasticity(float e) {
+				elasticity = e;
 			}
 
-			Vector3 GetForce() const {
-				return force;
+			float GetElasticity() const {
+				return elasticity;
 			}
 
-			void SetInverseMass(float invMass) {
-				inverseMass = invMass;
+			void SetFriction(float f) {
+				friction = f;
 			}
 
-			float GetInverseMass() const {
-				return inverseMass;
+			float GetFriction() const {
+				return friction;
 			}
 
 			void ApplyAngularImpulse(const Vector3& force);
@@ -48,31 +51,59 @@ namespace NCL {
 
 			void ClearForces();
 
-			void SetLinearVelocity(const Vector3& v) {
-				linearVelocity = v;
-			}
-
-			void SetAngularVelocity(const Vector3& v) {
-				angularVelocity = v;
-			}
+			//Changing the velocity (or applying an impulse) wakes the object up
+			void SetLinearVelocity(const Vector3& v);
+			void SetAngularVelocity(const Vector3& v);
 
 			void InitCubeInertia();
 			void InitSphereInertia();
 
 			void UpdateInertiaTensor();
 
-			Matrix3 GetInertiaTensor() const {
-				return inverseInteriaTensor;
+			Matrix3 GetInertiaTensor() const;
+
+			//The store this object's state currently lives in, if any
+			PhysicsBodyStore* GetBodyStore() const {
+				return bodyStore;
+			}
+
+			int GetBodyIndex() const {
+				return bodyIndex;
+			}
+
+			//Sleeping objects aren't moved by the PhysicsSystem until something wakes them
+			bool IsAsleep() const;
+			void Wake();
+
+			/*
+			Objects fast enough to pass straight through something thin in a
+			single step (like rockets) can be swept from where they start each
+			step to where they end up, stopping at the first thing in the way.
+			The PhysicsSystem looks for these when objects are added to or removed
+			from the world, so set it before adding the object.
+			*/
+			void SetContinuousCollision(bool state) {
+				continuousCollision = state;
+			}
+
+			bool UsesContinuousCollision() const {
+				return continuousCollision;
 			}
 
 		protected:
 			const CollisionVolume* volume;
 			Transform*		transform;
 
+			//While in a store, the members below are out of date - it holds the real values
+			PhysicsBodyStore*	bodyStore;
+			int					bodyIndex;
+
 			float inverseMass;
 			float elasticity;
 			float friction;
 
+			bool continuousCollision;
+
 			//linear stuff
 			Vector3 linearVelocity;
 			Vector3 force;
@@ -7,24 +7,122 @@
 #include "Constraint.h"
 
 #include "Debug.h"
-#include "Window.h"
+#include "Profiler.h"
 #include <functional>
 using namespace NCL;
 using namespace CSC8503;
 
 PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g)	{
-	applyGravity	= false;
-	useBroadPhase	= false;	
-	dTOffset		= 0.0f;
-	globalDamping	= 0.995f;
-	SetGravity(Vector3(0.0f, -9.8f, 0.0f));
+	integrationPath	= IntegrationKernels::GetBestSupported();
+	narrowPhasePath	= integrationPath;
+	SetConfig(config);
 }
 
 PhysicsSystem::~PhysicsSystem()	{
+	if (gameWorld.GetBroadphaseTree() == &broadphaseTree) {
+		gameWorld.SetBroadphaseTrees(nullptr, nullptr);
+	}
+}
+
+void PhysicsSystem::UseGravity(bool state) {
+	if (config.useGravity != state) {
+		WakeAllBodies();
+	}
+	config.useGravity = state;
 }
 
 void PhysicsSystem::SetGravity(const Vector3& g) {
-	gravity = g;
+	if (config.gravity != g) {
+		WakeAllBodies();
+	}
+	config.gravity = g;
+}
+
+/*
+Settings that need more than a value changing (like throwing away the old
+broadphase, or waking everything up) only do so if they've actually changed.
+*/
+void PhysicsSystem::SetConfig(const PhysicsConfig& newConfig) {
+	BroadPhaseType	oldBroadPhase		= config.broadPhase;
+	bool			oldSleeping			= config.sleeping;
+	bool			oldInterpolation	= config.interpolation;
+	bool			oldUseGravity		= config.useGravity;
+	Vector3			oldGravity			= config.gravity;
+
+	config = newConfig;
+	config.constraintIterations = std::max(1, config.constraintIterations);
+
+	stepScheduler.SetIdealHZ(config.stepHZ);
+	stepScheduler.SetMaxSubsteps(config.maxSubsteps);
+
+	if (config.broadPhase != oldBroadPhase) {
+		SetBroadPhase(config.broadPhase);
+	}
+	if (config.sleeping != oldSleeping) {
+		SetSleeping(config.sleeping);
+	}
+	if (config.interpolation != oldInterpolation) {
+		SetInterpolation(config.interpolation);
+	}
+	if (config.useGravity != oldUseGravity || config.gravity != oldGravity) {
+		WakeAllBodies();
+	}
+}
+
+//The step scheduler can be changed directly too, so its settings are read back from it
+PhysicsConfig PhysicsSystem::GetConfig() const {
+	PhysicsConfig current = config;
+	current.stepHZ		= stepScheduler.GetIdealHZ();
+	current.maxSubsteps	= stepScheduler.GetMaxSubsteps();
+	return current;
+}
+
+void PhysicsSystem::SetIntegrationPath(IntegrationKernels::InstructionSet set) {
+	integrationPath = IntegrationKernels::IsSupported(set) ? set : IntegrationKernels::InstructionSet::Scalar;
+}
+
+void PhysicsSystem::SetNarrowPhasePath(IntegrationKernels::InstructionSet set) {
+	narrowPhasePath = IntegrationKernels::IsSupported(set) ? set : IntegrationKernels::InstructionSet::Scalar;
+}
+
+void PhysicsSystem::SetConstraintIterationCount(int count) {
+	config.constraintIterations = std::max(1, count);
+}
+
+//Without interpolation, everything is drawn exactly where the last step left it
+void PhysicsSystem::SetInterpolation(bool state) {
+	config.interpolation = state;
+	if (!config.interpolation) {
+		bodies.InterpolatePoses(1.0f);
+	}
+}
+
+void PhysicsSystem::SetSleeping(bool state) {
+	config.sleeping = state;
+	if (!config.sleeping) {
+		WakeAllBodies();
+	}
+}
+
+void PhysicsSystem::WakeAllBodies() {
+	while (bodies.GetAwakeCount() < bodies.GetBodyCount()) {
+		bodies.SetAwake(bodies.GetAwakeCount(), true);
+	}
+}
+
+/*
+Each broadphase keeps its own persistent proxies, so changing over means
+throwing the old ones away - they'll all be rebuilt on the next update.
+*/
+void PhysicsSystem::SetBroadPhase(BroadPhaseType type) {
+	config.broadPhase = type;
+	gameWorld.SetBroadphaseTrees(nullptr, nullptr);
+	broadphaseCollisionsVec.clear();
+	broadphaseTree.Clear();
+	sweepAndPrune.Clear();
+	staticTree.Clear();
+	staticObjects.clear();
+	broadphaseWorldState = -1;
 }
 
 /*
@@ -38,135 +136,148 @@ any collisions they are in.
 
 */
 void PhysicsSystem::Clear() {
-	allCollisions.clear();
+	stepScheduler.Reset();
+	contactSolver.Clear();
+	bodies.Clear();
+	bodyStoreWorldState = -1;
+	allCollisions.Clear();
+	pairCacheWorldState = -1;
+	broadphaseCollisionsVec.clear();
+	gameWorld.SetBroadphaseTrees(nullptr, nullptr);
+	broadphaseTree.Clear();
+	sweepAndPrune.Clear();
+	staticTree.Clear();
+	staticObjects.clear();
+	broadphaseWorldState = -1;
+	continuousObjects.clear();
 }
 
 /*
 
 This is the core of the physics engine update
 
+The step scheduler decides how many fixed size steps this frame gets, and
+watches how long they take - if physics takes too long it starts to kill
+the framerate, so it'll drop the step rate down until it can keep up.
 */
-
-bool useSimpleContainer = false;
-
-int constraintIterationCount = 10;
-
-//This is the fixed timestep we'd LIKE to have
-const int   idealHZ = 120;
-const float idealDT = 1.0f / idealHZ;
-
-/*
-This is the fixed update we actually have...
-If physics takes too long it starts to kill the framerate, it'll drop the 
-iteration count down until the FPS stabilises, even if that ends up
-being at a low rate. 
-*/
-int realHZ		= idealHZ;
-float realDT	= idealDT;
-
 void PhysicsSystem::Update(float dt) {	
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::B)) {
-		useBroadPhase = !useBroadPhase;
-		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::N)) {
-		useSimpleContainer = !useSimpleContainer;
-		std::cout << "Setting broad container to " << useSimpleContainer << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::I)) {
-		constraintIterationCount--;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::O)) {
-		constraintIterationCount++;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-
-	dTOffset += dt; //We accumulate time delta here - there might be remainders from previous frame!
+	PROFILE_SCOPE("PhysicsSystem::Update");
+	int stepCount = stepScheduler.BeginFrame(dt);
+	float stepDT = stepScheduler.GetStepDT();
 
 	GameTimer t;
 	t.GetTimeDeltaSeconds();
+	phaseTimer.Tick();
 
-	if (useBroadPhase) {
+	SyncBodyStore();
+	RemoveStalePairs();
+	bodies.WakeMovedBodies();
+	bodies.GatherPoses(); //Gameplay code might have moved things since last frame
+	EndPhase(phaseTimings.integrate);
+
+	if (config.broadPhase != BroadPhaseType::None) {
 		UpdateObjectAABBs();
 	}
-	int iteratorCount = 0;
-	while(dTOffset > realDT) {
-		IntegrateAccel(realDT); //Update accelerations from external forces
-		if (useBroadPhase) {
-			BroadPhase();
-			NarrowPhase();
-		}
-		else {
-			BasicCollisionDetection();
+	RefreshChangedFilters();
+	EndPhase(phaseTimings.broadPhase);
+	for (int step = 0; step < stepCount; ++step) {
+		bodies.StorePreviousPoses();
+		IntegrateAccel(stepDT); //Update accelerations from external forces
+		contactSolver.Clear();
+		EndPhase(phaseTimings.integrate);
+		switch (config.broadPhase) {
+			case BroadPhaseType::AABBTree: {
+				BroadPhase();
+				EndPhase(phaseTimings.broadPhase);
+				NarrowPhase();
+			}break;
+			case BroadPhaseType::SweepAndPrune: {
+				SortAndSweep();
+				EndPhase(phaseTimings.broadPhase);
+				NarrowPhase();
+			}break;
+			default: {
+				BasicCollisionDetection();
+			}break;
 		}
+		EndPhase(phaseTimings.narrowPhase);
 
-		//This is our simple iterative solver - 
-		//we just run things multiple times, slowly moving things forward
-		//and then rechecking that the constraints have been met		
-		float constraintDt = realDT /  (float)constraintIterationCount;
-		for (int i = 0; i < constraintIterationCount; ++i) {
-			UpdateConstraints(constraintDt);	
-		}
-		IntegrateVelocity(realDT); //update positions from new velocity changes
+		PROFILE_COUNTER("Broadphase pairs", broadphaseCollisionsVec.size());
+		PROFILE_COUNTER("Contacts", contactSolver.GetContactCount());
+
+		BuildIslands();
+		PROFILE_COUNTER("Islands", islands.GetIslandCount());
+
+		contactSolver.PrepareContacts(allCollisions, stepDT);
+		SolveIslands(stepDT, config.constraintIterations);
+		contactSolver.StoreImpulses(allCollisions);
+		EndPhase(phaseTimings.constraints);
+		IntegrateVelocity(stepDT); //update positions from new velocity changes
+		EndPhase(phaseTimings.integrate);
+	}
 
-		dTOffset -= realDT;
-		iteratorCount++;
+	if (config.sleeping && stepCount > 0) {
+		UpdateSleeping(stepDT * stepCount);
+		EndPhase(phaseTimings.constraints);
 	}
 
 	ClearForces();	//Once we've finished with the forces, reset them to zero
 
 	UpdateCollisionList(); //Remove any old collisions
+	EndPhase(phaseTimings.collisionList);
 
-	t.Tick();
-	float updateTime = t.GetTimeDeltaSeconds();
-
-	//Uh oh, physics is taking too long...
-	if (updateTime > realDT) {
-		realHZ /= 2;
-		realDT *= 2;
-		std::cout << "Dropping iteration count due to long physics time...(now " << realHZ << ")\n";
+	if (config.interpolation) {
+		bodies.InterpolatePoses(stepScheduler.GetInterpolationAlpha());
+		EndPhase(phaseTimings.integrate);
 	}
-	else if(dt*2 < realDT) { //we have plenty of room to increase iteration count!
-		int temp = realHZ;
-		realHZ *= 2;
-		realDT /= 2;
+	phaseTimings.steps += stepCount;
+	phaseTimings.frames++;
 
-		if (realHZ > idealHZ) {
-			realHZ = idealHZ;
-			realDT = idealDT;
-		}
-		if (temp != realHZ) {
-			std::cout << "Raising iteration count due to short physics time...(now " << realHZ << ")\n";
-		}
-	}
+	t.Tick();
+	stepScheduler.EndFrame(t.GetTimeDeltaSeconds(), stepCount);
 }
 
 /*
 Later on we're going to need to keep track of collisions
-across multiple frames, so we store them in a set.
+across multiple frames, so we store them in a pair cache.
 
 The first time they are added, we tell the objects they are colliding.
-The frame they are to be removed, we tell them they're no longer colliding.
+Each step they are still found to be touching refreshes how many frames
+they have left, and once that runs out we tell them they're no longer colliding.
 
 From this simple mechanism, we we build up gameplay interactions inside the
 OnCollisionBegin / OnCollisionEnd functions (removing health when hit by a 
 rocket launcher, gaining a point when the player hits the gold coin, and so on).
 */
 void PhysicsSystem::UpdateCollisionList() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = allCollisions.begin(); i != allCollisions.end(); ) {
-		if ((*i).framesLeft == numCollisionFrames) {
-			i->a->OnCollisionBegin(i->b);
-			i->b->OnCollisionBegin(i->a);
+	PROFILE_SCOPE("PhysicsSystem::UpdateCollisionList");
+	for (int i = 0; i < allCollisions.GetPairCount(); ) {
+		CollisionPairCache::CollisionPair& pair = allCollisions.GetPair(i);
+		CollisionDetection::CollisionInfo& in = pair.info;
+
+		if (!pair.begun) {
+			in.a->OnCollisionBegin(in.b);
+			in.b->OnCollisionBegin(in.a);
+			pair.begun = true;
+		}
+
+		//Sleeping objects are still touching, they're just not being checked
+		if (in.a->GetPhysicsObject()->IsAsleep() && in.b->GetPhysicsObject()->IsAsleep()) {
+			++i;
+			continue;
 		}
 
-		CollisionDetection::CollisionInfo& in = const_cast<CollisionDetection::CollisionInfo&>(*i);
 		in.framesLeft--;
 
-		if ((*i).framesLeft < 0) {
-			i->a->OnCollisionEnd(i->b);
-			i->b->OnCollisionEnd(i->a);
-			i = allCollisions.erase(i);
+		//Not touching this frame, so its impulses are no good for warm starting any more
+		if (in.framesLeft < numCollisionFrames - 1) {
+			pair.ClearImpulses();
+		}
+
+		if (in.framesLeft < 0) {
+			in.a->OnCollisionEnd(in.b);
+			in.b->OnCollisionEnd(in.a);
+			allCollisions.RemoveAt(i); //The last pair is moved into this slot, so don't advance
 		}
 		else {
 			++i;
@@ -175,12 +286,357 @@ void PhysicsSystem::UpdateCollisionList() {
 }
 
 void PhysicsSystem::UpdateObjectAABBs() {
+	PROFILE_SCOPE("PhysicsSystem::UpdateObjectAABBs");
 	std::vector <GameObject*>::const_iterator first;
 	std::vector <GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
 	for (auto i = first; i != last; ++i) {
 		(*i)->UpdateBroadphaseAABB();
 	}
+	SyncBroadphaseProxies();
+	ReleaseMovedStatics();
+}
+
+/*
+Both broadphases persist between frames, so whenever objects are added to
+or removed from the world, they need bringing back in line with the world's
+contents. Objects that are new get a proxy, and proxies whose object has left
+the world are destroyed. The object pointers in stale proxies might already be
+deleted, so they're only ever compared against, never dereferenced.
+*/
+template<class BroadPhaseStructure>
+static void SyncProxies(BroadPhaseStructure& broadphase, const std::set<GameObject*>& liveObjects) {
+	std::vector<int> staleProxies;
+	broadphase.OperateOnProxies([&](int proxy, GameObject* o) {
+		if (liveObjects.find(o) == liveObjects.end() || o->GetBroadphaseProxy() != proxy) {
+			staleProxies.push_back(proxy);
+		}
+	});
+	for (int proxy : staleProxies) {
+		broadphase.DestroyProxy(proxy);
+	}
+
+	for (GameObject* o : liveObjects) {
+		int proxy = o->GetBroadphaseProxy();
+		if (broadphase.IsValidProxy(proxy) && broadphase.GetObject(proxy) == o) {
+			continue;
+		}
+		Vector3 halfSizes;
+		o->GetBroadphaseAABB(halfSizes);
+		o->SetBroadphaseProxy(broadphase.CreateProxy(o->GetTransform().GetPosition(), halfSizes, o));
+	}
+}
+
+/*
+Objects the physics can't move (an inverse mass of 0, like the maze's walls)
+are kept out of the broadphase, in a tree of their own that's built in one go
+when the level loads. None of them move, so there's never any point in pairing
+them up with each other - only the moving objects ever look for pairs, in both
+trees. The static tree is only built again if the static objects themselves
+change, not whenever anything else comes or goes, and an object that has been
+moved by gameplay code is a moving object from then on.
+*/
+void PhysicsSystem::SyncBroadphaseProxies() {
+	if (gameWorld.GetWorldStateID() == broadphaseWorldState) {
+		return;
+	}
+	broadphaseWorldState = gameWorld.GetWorldStateID();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	std::set<GameObject*> liveObjects;
+	std::vector<GameObject*> statics;
+	for (auto i = first; i != last; ++i) {
+		GameObject* o = *i;
+		if (!o->GetBoundingVolume() || !o->GetPhysicsObject()) {
+			continue;
+		}
+		int proxy = o->GetBroadphaseProxy();
+		bool isMoving = config.broadPhase == BroadPhaseType::SweepAndPrune ?
+			sweepAndPrune.IsValidProxy(proxy) && sweepAndPrune.GetObject(proxy) == o :
+			broadphaseTree.IsValidProxy(proxy) && broadphaseTree.GetObject(proxy) == o;
+
+		if (o->GetPhysicsObject()->GetInverseMass() == 0.0f && !isMoving) {
+			statics.push_back(o);
+		}
+		else {
+			liveObjects.insert(o);
+		}
+	}
+	std::sort(statics.begin(), statics.end());
+	if (statics != staticObjects) {
+		BuildStaticTree(statics);
+	}
+
+	if (config.broadPhase == BroadPhaseType::SweepAndPrune) {
+		SyncProxies(sweepAndPrune, liveObjects);
+		return;
+	}
+	SyncProxies(broadphaseTree, liveObjects);
+
+	//Pairs might refer to objects that have gone, so find them all again
+	broadphaseCollisionsVec.clear();
+	for (GameObject* o : liveObjects) {
+		broadphaseTree.BufferMove(o->GetBroadphaseProxy());
+	}
+	gameWorld.SetBroadphaseTrees(&broadphaseTree, &staticTree); //Raycasts can use them again, now they're up to date
+}
+
+void PhysicsSystem::BuildStaticTree(const std::vector<GameObject*>& objects) {
+	PROFILE_SCOPE("PhysicsSystem::BuildStaticTree");
+	std::vector<DynamicAABBTree<GameObject*>::BuildEntry> entries;
+	for (GameObject* o : objects) {
+		Vector3 halfSizes;
+		o->GetBroadphaseAABB(halfSizes);
+		Vector3 position = o->GetTransform().GetPosition();
+		entries.push_back({ position - halfSizes, position + halfSizes, o });
+	}
+	staticTree.Build(entries);
+	for (int i = 0; i < (int)objects.size(); ++i) {
+		objects[i]->SetBroadphaseProxy(i);
+	}
+	staticObjects = objects;
+}
+
+/*
+Static objects can still be moved by gameplay code, like a platform going back
+and forth, and their box in the static tree is then out of date. They're moved
+over to the broadphase, where their pairs get found like any other moving
+object's, and where they'll stay.
+*/
+void PhysicsSystem::ReleaseMovedStatics() {
+	for (int i = 0; i < (int)staticObjects.size(); ) {
+		GameObject* o = staticObjects[i];
+		Vector3 halfSizes;
+		o->GetBroadphaseAABB(halfSizes);
+		Vector3 position = o->GetTransform().GetPosition();
+
+		Vector3 builtMin;
+		Vector3 builtMax;
+		staticTree.GetFatAABB(o->GetBroadphaseProxy(), builtMin, builtMax);
+		if (builtMin == position - halfSizes && builtMax == position + halfSizes) {
+			++i;
+			continue;
+		}
+		staticTree.DestroyProxy(o->GetBroadphaseProxy());
+		staticObjects.erase(staticObjects.begin() + i);
+
+		if (config.broadPhase == BroadPhaseType::SweepAndPrune) {
+			o->SetBroadphaseProxy(sweepAndPrune.CreateProxy(position, halfSizes, o));
+		}
+		else {
+			o->SetBroadphaseProxy(broadphaseTree.CreateProxy(position, halfSizes, o));
+		}
+	}
+}
+
+bool PhysicsSystem::IsInStaticTree(const GameObject* o) const {
+	int proxy = o->GetBroadphaseProxy();
+	return staticTree.IsValidProxy(proxy) && staticTree.GetObject(proxy) == o;
+}
+
+/*
+An object whose layers or mask have changed might now collide with things it
+used to ignore, or ignore things it's touching. The tree broadphase only
+looks for new pairs around objects that have left their fat box, so it's
+told the object has moved, and a static object has everything near it
+marked instead, as static objects never look for pairs themselves. The
+object is woken as well, even a static one, as a pair is never checked
+while both sides are asleep - the sort and sweep, and the brute force
+check, need nothing else, as they find every pair from scratch each step.
+*/
+void PhysicsSystem::RefreshChangedFilters() {
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+	for (auto i = first; i != last; ++i) {
+		GameObject* o = *i;
+		if (!o->HasFilterChanged()) {
+			continue;
+		}
+		o->ClearFilterChanged();
+		PhysicsObject* physics = o->GetPhysicsObject();
+		if (!physics) {
+			continue;
+		}
+		physics->Wake();
+		if (config.broadPhase != BroadPhaseType::AABBTree) {
+			continue;
+		}
+		int proxy = o->GetBroadphaseProxy();
+		if (broadphaseTree.IsValidProxy(proxy) && broadphaseTree.GetObject(proxy) == o) {
+			broadphaseTree.BufferMove(proxy);
+		}
+		else if (IsInStaticTree(o)) {
+			Vector3 boxMin;
+			Vector3 boxMax;
+			staticTree.GetFatAABB(proxy, boxMin, boxMax);
+			broadphaseTree.Query(boxMin, boxMax, [&](int other) {
+				broadphaseTree.BufferMove(other);
+				return true;
+			});
+		}
+	}
+}
+
+/*
+Every PhysicsObject in the world has its state moved into the body store,
+so that the integrators can run through it all in one go. Objects that have
+left the world without being deleted are handed their state back - deleted
+ones will already have removed themselves.
+*/
+void PhysicsSystem::SyncBodyStore() {
+	if (gameWorld.GetWorldStateID() == bodyStoreWorldState) {
+		return;
+	}
+	bodyStoreWorldState = gameWorld.GetWorldStateID();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	std::set<PhysicsObject*> liveObjects;
+	continuousObjects.clear();
+	for (auto i = first; i != last; ++i) {
+		PhysicsObject* object = (*i)->GetPhysicsObject();
+		if (object == nullptr) {
+			continue;
+		}
+		liveObjects.insert(object);
+		if (object->UsesContinuousCollision() && (*i)->GetBoundingVolume()) {
+			continuousObjects.push_back(*i);
+		}
+		if (object->GetBodyStore() != &bodies) {
+			bodies.AddBody(object, &(*i)->GetTransform());
+		}
+	}
+	for (int i = bodies.GetBodyCount() - 1; i >= 0; --i) {
+		if (liveObjects.find(bodies.GetOwner(i)) == liveObjects.end()) {
+			bodies.RemoveBody(i);
+		}
+	}
+}
+
+/*
+Gameplay code can take objects out of the world (and delete them) between
+updates, like a rocket that's gone off, so any pairs they were in need
+throwing away before anything tries to use them. The objects might already
+be gone, so they're only compared against, and there's no OnCollisionEnd
+for these pairs.
+*/
+void PhysicsSystem::RemoveStalePairs() {
+	if (gameWorld.GetWorldStateID() == pairCacheWorldState) {
+		return;
+	}
+	pairCacheWorldState = gameWorld.GetWorldStateID();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+	std::set<GameObject*> liveObjects(first, last);
+
+	for (int i = 0; i < allCollisions.GetPairCount(); ) {
+		const CollisionDetection::CollisionInfo& info = allCollisions.GetPair(i).info;
+		if (liveObjects.find(info.a) == liveObjects.end() || liveObjects.find(info.b) == liveObjects.end()) {
+			allCollisions.RemoveAt(i); //The last pair is moved into this slot, so don't advance
+		}
+		else {
+			++i;
+		}
+	}
+}
+
+//Static and sleeping objects don't join islands together
+static int IslandBody(GameObject* o) {
+	PhysicsObject* object = o ? o->GetPhysicsObject() : nullptr;
+	if (object == nullptr || object->GetBodyStore() == nullptr || object->IsAsleep() || object->GetInverseMass() == 0.0f) {
+		return -1;
+	}
+	return object->GetBodyIndex();
+}
+
+/*
+Splits this step's contacts and constraints up into islands of objects that
+affect each other. A constraint attached to a sleeping object wakes it first,
+as it's about to be pulled about by whatever's on the other end.
+*/
+void PhysicsSystem::BuildIslands() {
+	PROFILE_SCOPE("PhysicsSystem::BuildIslands");
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	gameWorld.GetConstraintIterators(first, last);
+	worldConstraints.assign(first, last);
+
+	for (Constraint* c : worldConstraints) {
+		GameObject* a;
+		GameObject* b;
+		c->GetObjects(a, b);
+		if (a && b && a->GetPhysicsObject() && b->GetPhysicsObject() &&
+			a->GetPhysicsObject()->IsAsleep() != b->GetPhysicsObject()->IsAsleep()) {
+			a->GetPhysicsObject()->Wake();
+			b->GetPhysicsObject()->Wake();
+		}
+	}
+
+	islands.Reset(bodies.GetAwakeCount());
+	for (int i = 0; i < contactSolver.GetContactCount(); ++i) {
+		const CollisionDetection::CollisionInfo& info = allCollisions.GetPair(contactSolver.GetContactPairIndex(i)).info;
+		islands.AddContact(i, IslandBody(info.a), IslandBody(info.b));
+	}
+	for (int i = 0; i < (int)worldConstraints.size(); ++i) {
+		GameObject* a;
+		GameObject* b;
+		worldConstraints[i]->GetObjects(a, b);
+		islands.AddConstraint(i, IslandBody(a), IslandBody(b));
+	}
+	islands.Build();
+}
+
+/*
+Objects that have been moving slowly for long enough are put to sleep - but
+only when everything in their island has been too, or an object at the
+bottom of a stack could fall asleep while the ones on top are still sliding
+about. Sleeping objects aren't integrated or collided against each other
+until something wakes them.
+*/
+void PhysicsSystem::UpdateSleeping(float dt) {
+	PROFILE_SCOPE("PhysicsSystem::UpdateSleeping");
+	float linearToleranceSq		= config.linearSleepTolerance * config.linearSleepTolerance;
+	float angularToleranceSq	= config.angularSleepTolerance * config.angularSleepTolerance;
+
+	for (int i = 0; i < bodies.GetAwakeCount(); ++i) {
+		if (bodies.linearVelocities.Get(i).LengthSquared() > linearToleranceSq ||
+			bodies.angularVelocities.Get(i).LengthSquared() > angularToleranceSq) {
+			bodies.sleepTimers[i] = 0.0f;
+		}
+		else {
+			bodies.sleepTimers[i] += dt;
+		}
+	}
+
+	newSleepers.clear();
+	const std::vector<int>& islandBodies = islands.GetBodies();
+	for (int i = 0; i < islands.GetIslandCount(); ++i) {
+		const PhysicsIslands::Island& island = islands.GetIsland(i);
+
+		float minSleepTime = FLT_MAX;
+		for (int j = 0; j < island.bodyCount; ++j) {
+			minSleepTime = std::min(minSleepTime, bodies.sleepTimers[islandBodies[island.firstBody + j]]);
+		}
+		if (minSleepTime < config.timeToSleep) {
+			continue;
+		}
+		for (int j = 0; j < island.bodyCount; ++j) {
+			newSleepers.push_back(bodies.GetOwner(islandBodies[island.firstBody + j]));
+		}
+	}
+
+	//Putting a body to sleep moves it in the store, so they're found by their objects
+	for (PhysicsObject* object : newSleepers) {
+		bodies.SetAwake(object->GetBodyIndex(), false);
+	}
 }
 
 /*
@@ -193,6 +649,7 @@ a particular pair will only be added once, so objects colliding for
 multiple frames won't flood the set with duplicates.
 */
 void PhysicsSystem::BasicCollisionDetection() {
+	PROFILE_SCOPE("PhysicsSystem::BasicCollisionDetection");
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
@@ -206,12 +663,19 @@ void PhysicsSystem::BasicCollisionDetection() {
 			if ((*j)->GetPhysicsObject() == nullptr) {
 				continue;
 			}
+			if ((*i)->GetPhysicsObject()->IsAsleep() && (*j)->GetPhysicsObject()->IsAsleep()) {
+				continue;
+			}
+			if ((*i)->GetPhysicsObject()->GetInverseMass() == 0.0f && (*j)->GetPhysicsObject()->GetInverseMass() == 0.0f) {
+				continue; //Neither can move, so there's nothing to resolve
+			}
+			if (!(*i)->CanCollideWith(*j)) {
+				continue;
+			}
 			CollisionDetection::CollisionInfo info;
 
 			if (CollisionDetection::ObjectIntersection(*i, *j, info)) {
-				ImpulseResolveCollision(*info.a, *info.b, info.point);
-				info.framesLeft = numCollisionFrames;
-				allCollisions.insert(info);
+				AddContact(info);
 			}
 		}
 	}
@@ -222,118 +686,302 @@ void PhysicsSystem::BasicCollisionDetection() {
 In tutorial 5, we start determining the correct response to a collision,
 so that objects separate back out. 
 
-*/
-void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, CollisionDetection::ContactPoint& p) const {
-	PhysicsObject* physA = a.GetPhysicsObject();
-	PhysicsObject* physB = b.GetPhysicsObject();
-
-	Transform& transformA = a.GetTransform();
-	Transform& transformB = b.GetTransform();
-
-	float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+Rather than resolving each collision straight away, it's added to the pair
+cache and handed to the contact solver, which resolves every contact found
+this step together, alongside the world's other constraints.
 
-	if (totalMass == 0) {
-		return; //Occurs if there is 2 static objects
+*/
+void PhysicsSystem::AddContact(CollisionDetection::CollisionInfo& info) {
+	//Something has bumped into a sleeping object, so wake it up - static objects can stay asleep
+	PhysicsObject* physA = info.a->GetPhysicsObject();
+	PhysicsObject* physB = info.b->GetPhysicsObject();
+	if (physA->IsAsleep() && physA->GetInverseMass() > 0.0f) {
+		physA->Wake();
+	}
+	if (physB->IsAsleep() && physB->GetInverseMass() > 0.0f) {
+		physB->Wake();
 	}
 
-	//Seperate out objects by projection
-	transformA.SetPosition(transformA.GetPosition() - (p.normal * p.penetration * (physA->GetInverseMass() / totalMass)));
-	transformB.SetPosition(transformB.GetPosition() + (p.normal * p.penetration * (physB->GetInverseMass() / totalMass)));
-
-	Vector3 relativeA = p.localA;
-	Vector3 relativeB = p.localB;
-
-	Vector3 angVelocityA = Vector3::Cross(physA->GetAngularVelocity(), relativeA);
-	Vector3 angVelocityB = Vector3::Cross(physB->GetAngularVelocity(), relativeB);
-
-	Vector3 fullVelocityA = physA->GetLinearVelocity() + angVelocityA;
-	Vector3 fullVelocityB = physB->GetLinearVelocity() + angVelocityB;
-
-	Vector3 contactVelocity = fullVelocityB - fullVelocityA;
+	info.framesLeft = numCollisionFrames;
+	CollisionPairCache::CollisionPair& pair = allCollisions.Insert(info);
+	contactSolver.AddContact(allCollisions.GetPairIndex(pair));
+}
 
-	float impulseForce = Vector3::Dot(contactVelocity, p.normal);
+/*
 
-	//Impulse calculation
-	impulseForce = Vector3::Dot(contactVelocity, p.normal);
-	Vector3 inertiaA = Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, p.normal), relativeA);
-	Vector3 inertiaB = Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, p.normal), relativeB);
-	float angularEffect = Vector3::Dot(inertiaA + inertiaB, p.normal);
-	float cRestitution = 0.66f;
-	float j = (-(1.0f + cRestitution) * impulseForce) / (totalMass + angularEffect);
+Later, we replace the BasicCollisionDetection method with a broadphase
+and a narrowphase collision detection method. In the broad phase, we
+split the world up using an acceleration structure, so that we can only
+compare the collisions that we absolutely need to. 
 
-	Vector3 fullImpulse = p.normal * j;
+The acceleration structure is a dynamic AABB tree that lives as long as
+the PhysicsSystem does. Each step, every object tells the tree where it
+is now - for most objects that's a single box-in-box test, as they're still
+inside the fattened box they were given last time. Only objects that escape
+their fat box move in the tree, and only their pairs need to be found again;
+every other pair from the last step is still valid, as the fat boxes it was
+found from haven't changed.
 
-	physA->ApplyLinearImpulse(-fullImpulse);
-	physB->ApplyLinearImpulse(fullImpulse);
+Objects that escape also look through the static tree for the static objects
+near them. Static objects never move, so they never go looking themselves,
+and pairs of two static objects are never found at all. Nor are pairs whose
+layers say they don't collide, like a coin and anything that isn't the player.
 
-	physA->ApplyAngularImpulse(Vector3::Cross(relativeA, -fullImpulse));
-	physB->ApplyAngularImpulse(Vector3::Cross(relativeB, fullImpulse));
+*/
+void PhysicsSystem::BroadPhase() {
+	PROFILE_SCOPE("PhysicsSystem::BroadPhase");
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+	for (auto i = first; i != last; ++i) {
+		int proxy = (*i)->GetBroadphaseProxy();
+		if (!broadphaseTree.IsValidProxy(proxy) || broadphaseTree.GetObject(proxy) != *i) {
+			continue;
+		}
+		if ((*i)->GetPhysicsObject()->IsAsleep()) {
+			continue; //Hasn't moved, so its fat box is still good
+		}
+		Vector3 halfSizes;
+		(*i)->GetBroadphaseAABB(halfSizes);
+		Vector3 displacement = (*i)->GetPhysicsObject()->GetLinearVelocity() * stepScheduler.GetStepDT();
+		broadphaseTree.MoveProxy(proxy, (*i)->GetTransform().GetPosition(), halfSizes, displacement);
+	}
 
-	//Friction Impulse calculation
-	Vector3 tangent = contactVelocity - (p.normal * Vector3::Dot(contactVelocity, p.normal));
-	impulseForce = Vector3::Dot(contactVelocity, tangent);
-	inertiaA = Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, tangent), relativeA);
-	inertiaB = Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, tangent), relativeB);
-	float angularEffectFriction = Vector3::Dot(inertiaA + inertiaB, tangent);
-	float frictionCoefficent = 0.3f;
-	float jFriction = (-(frictionCoefficent * Vector3::Dot(contactVelocity, tangent)) / (totalMass + angularEffectFriction));
+	const std::vector<int>& moved = broadphaseTree.GetMoveBuffer();
+	if (moved.empty()) {
+		return;
+	}
 
-	Vector3 frictionImpulse = tangent * jFriction;
+	//Any pair with a moved object in it is thrown away, and found again below
+	auto wasMoved = [&](const GameObject* o) {
+		return !IsInStaticTree(o) && broadphaseTree.WasMoved(o->GetBroadphaseProxy());
+	};
+	std::erase_if(broadphaseCollisionsVec, [&](const CollisionDetection::CollisionInfo& pair) {
+		return wasMoved(pair.a) || wasMoved(pair.b);
+	});
 
-	physA->ApplyLinearImpulse(-frictionImpulse);
-	physB->ApplyLinearImpulse(frictionImpulse);
+	for (int proxy : moved) {
+		if (proxy == DynamicAABBTree<GameObject*>::NullNode) {
+			continue;
+		}
+		Vector3 fatMin;
+		Vector3 fatMax;
+		broadphaseTree.GetFatAABB(proxy, fatMin, fatMax);
+
+		broadphaseTree.Query(fatMin, fatMax, [&](int other) {
+			//if both moved, only the lower proxy adds the pair, so it's added once
+			if (other == proxy || (other < proxy && broadphaseTree.WasMoved(other))) {
+				return true;
+			}
+			GameObject* objA = broadphaseTree.GetObject(proxy);
+			GameObject* objB = broadphaseTree.GetObject(other);
+			if (!objA->CanCollideWith(objB)) {
+				return true;
+			}
+			CollisionDetection::CollisionInfo info;
+			info.a = std::min(objA, objB);
+			info.b = std::max(objA, objB);
+			broadphaseCollisionsVec.push_back(info);
+			return true;
+		});
+		staticTree.Query(fatMin, fatMax, [&](int other) {
+			GameObject* objA = broadphaseTree.GetObject(proxy);
+			GameObject* objB = staticTree.GetObject(other);
+			if (!objA->CanCollideWith(objB)) {
+				return true;
+			}
+			CollisionDetection::CollisionInfo info;
+			info.a = std::min(objA, objB);
+			info.b = std::max(objA, objB);
+			broadphaseCollisionsVec.push_back(info);
+			return true;
+		});
+	}
+	broadphaseTree.ClearMoveBuffer();
 }
 
 /*
 
-Later, we replace the BasicCollisionDetection method with a broadphase
-and a narrowphase collision detection method. In the broad phase, we
-split the world up using an acceleration structure, so that we can only
-compare the collisions that we absolutely need to. 
+Sort and sweep is an alternative broadphase, which suits levels where objects
+are spread out along one axis, like a long corridor. It finds every pair
+from scratch each step, but as the endpoint arrays it sorts persist between
+steps and are nearly in order already, that sort is cheap. Static objects
+aren't in it - each object in it looks for them in the static tree instead.
 
 */
-void PhysicsSystem::BroadPhase() {
-	broadphaseCollisions.clear();
-	QuadTree<GameObject*> tree(Vector2(1024, 1024), 7, 6);
-
+void PhysicsSystem::SortAndSweep() {
+	PROFILE_SCOPE("PhysicsSystem::SortAndSweep");
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
+	sweepAndPruneObjects.clear();
 	for (auto i = first; i != last; ++i) {
-		Vector3 halfSizes;
-		if (!(*i)->GetBroadphaseAABB(halfSizes)) {
+		int proxy = (*i)->GetBroadphaseProxy();
+		if (!sweepAndPrune.IsValidProxy(proxy) || sweepAndPrune.GetObject(proxy) != *i) {
 			continue;
 		}
-		Vector3 pos = (*i)->GetTransform().GetPosition();
-		tree.Insert(*i, pos, halfSizes);
+		sweepAndPruneObjects.push_back(*i);
+		if ((*i)->GetPhysicsObject()->IsAsleep()) {
+			continue;
+		}
+		Vector3 halfSizes;
+		(*i)->GetBroadphaseAABB(halfSizes);
+		sweepAndPrune.MoveProxy(proxy, (*i)->GetTransform().GetPosition(), halfSizes);
 	}
-	tree.OperateOnContents(
-		[&](std::list<QuadTreeEntry<GameObject*>>& data) {
-		CollisionDetection::CollisionInfo info;
-		for (auto i = data.begin(); i != data.end(); ++i) {
-			for (auto j = std::next(i); j != data.end(); ++j) {
-				//is this pair of items already in the collision set if the same pair is in another quadtree node together etc
-				info.a = std::min((*i).object, (*j).object);
-				info.b = std::max((*i).object, (*j).object);
-				broadphaseCollisions.insert(info);
-			}
+
+	broadphaseCollisionsVec.clear();
+	sweepAndPrune.FindPairs([&](GameObject* objA, GameObject* objB) {
+		if (!objA->CanCollideWith(objB)) {
+			return;
 		}
+		CollisionDetection::CollisionInfo info;
+		info.a = std::min(objA, objB);
+		info.b = std::max(objA, objB);
+		broadphaseCollisionsVec.push_back(info);
 	});
+
+	for (GameObject* o : sweepAndPruneObjects) {
+		Vector3 boxMin;
+		Vector3 boxMax;
+		sweepAndPrune.GetAABB(o->GetBroadphaseProxy(), boxMin, boxMax);
+		staticTree.Query(boxMin, boxMax, [&](int other) {
+			GameObject* objB = staticTree.GetObject(other);
+			if (!o->CanCollideWith(objB)) {
+				return true;
+			}
+			CollisionDetection::CollisionInfo info;
+			info.a = std::min(o, objB);
+			info.b = std::max(o, objB);
+			broadphaseCollisionsVec.push_back(info);
+			return true;
+		});
+	}
 }
 
 /*
 
 The broadphase will now only give us likely collisions, so we can now go through them,
 and work out if they are truly colliding, and if so, add them into the main collision list
+
+Testing a pair only reads the two objects, so the pairs are shared out between
+the task scheduler's threads, each writing what it finds into its own contact
+buffer. Resolving a collision moves the objects though, so that part stays on
+one thread. The buffers are merged back into the same order as the pairs came
+out of the broadphase, so the simulation comes out the same however many
+threads there are, and however the batches were shared out between them.
+
+Each task puts its sphere/sphere and AABB/sphere pairs to one side, and tests
+them together at the end with the NarrowPhaseKernels - their contacts are the
+same as ObjectIntersection would have made, just found a few at a time.
 */
 void PhysicsSystem::NarrowPhase() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ++i) {
-		CollisionDetection::CollisionInfo info = *i;
-		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
-			info.framesLeft = numCollisionFrames;
-			ImpulseResolveCollision(*info.a, *info.b, info.point);
-			allCollisions.insert(info); // insert into our main set
+	PROFILE_SCOPE("PhysicsSystem::NarrowPhase");
+	threadContacts.resize(taskScheduler.GetThreadCount());
+	for (auto& contacts : threadContacts) {
+		contacts.clear();
+	}
+	threadBatches.resize(taskScheduler.GetThreadCount());
+
+	taskScheduler.ParallelFor((int)broadphaseCollisionsVec.size(), narrowPhaseBatchSize,
+		[&](int begin, int end, int thread) {
+			std::vector<NarrowPhaseContact>& contacts = threadContacts[thread];
+			NarrowPhaseBatch& batch = threadBatches[thread];
+			batch.sphereSpheres.Begin(end - begin);
+			batch.aabbSpheres.Begin(end - begin);
+
+			for (int i = begin; i < end; ++i) {
+				const CollisionDetection::CollisionInfo& pair = broadphaseCollisionsVec[i];
+				if (pair.a->GetPhysicsObject()->IsAsleep() && pair.b->GetPhysicsObject()->IsAsleep()) {
+					continue; //Nothing's going to change between these two
+				}
+				if (!pair.a->CanCollideWith(pair.b)) {
+					continue; //Found before one of them changed its layers
+				}
+				if (batchNarrowPhase && AddToNarrowPhaseBatch(i, pair, batch)) {
+					continue;
+				}
+				CollisionDetection::CollisionInfo info = pair;
+				bool touching = CollisionDetection::ObjectIntersection(info.a, info.b, info);
+				//Only this task touches this pair, so the axis can be kept for next time
+				broadphaseCollisionsVec[i].separatingAxis	= info.separatingAxis;
+				broadphaseCollisionsVec[i].searchDirection	= info.searchDirection;
+				if (touching) {
+					contacts.push_back({ i, info });
+				}
+			}
+			TestNarrowPhaseBatch(batch, contacts);
+		}
+	);
+
+	//The contacts themselves are big, so only pointers to them are sorted
+	mergedContacts.clear();
+	for (auto& contacts : threadContacts) {
+		for (NarrowPhaseContact& contact : contacts) {
+			mergedContacts.push_back(&contact);
+		}
+	}
+	std::sort(mergedContacts.begin(), mergedContacts.end(),
+		[](const NarrowPhaseContact* a, const NarrowPhaseContact* b) {
+			return a->pairIndex < b->pairIndex;
 		}
+	);
+
+	for (NarrowPhaseContact* contact : mergedContacts) {
+		AddContact(contact->info); // insert into our main pair cache
+	}
+}
+
+bool PhysicsSystem::AddToNarrowPhaseBatch(int pairIndex, const CollisionDetection::CollisionInfo& pair, NarrowPhaseBatch& batch) const {
+	const CollisionVolume* volA = pair.a->GetBoundingVolume();
+	const CollisionVolume* volB = pair.b->GetBoundingVolume();
+	if (!volA || !volB) {
+		return false;
+	}
+	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Sphere) {
+		batch.sphereSpheres.Add(pairIndex,
+			pair.a->GetTransform().GetPosition(), ((const SphereVolume&)*volA).GetRadius(),
+			pair.b->GetTransform().GetPosition(), ((const SphereVolume&)*volB).GetRadius());
+		return true;
+	}
+	//The box always goes first, as ObjectIntersection would swap them round to
+	GameObject* box		= volA->type == VolumeType::AABB ? pair.a : pair.b;
+	GameObject* sphere	= volA->type == VolumeType::AABB ? pair.b : pair.a;
+	if (box->GetBoundingVolume()->type == VolumeType::AABB && sphere->GetBoundingVolume()->type == VolumeType::Sphere) {
+		batch.aabbSpheres.Add(pairIndex,
+			box->GetTransform().GetPosition(), ((const AABBVolume&)*box->GetBoundingVolume()).GetHalfDimensions(),
+			sphere->GetTransform().GetPosition(), ((const SphereVolume&)*sphere->GetBoundingVolume()).GetRadius());
+		return true;
+	}
+	return false;
+}
+
+void PhysicsSystem::TestNarrowPhaseBatch(NarrowPhaseBatch& batch, std::vector<NarrowPhaseContact>& contacts) const {
+	NarrowPhaseKernels::SphereSpherePairs& spheres = batch.sphereSpheres;
+	NarrowPhaseKernels::SphereSphere(narrowPhasePath, spheres);
+	for (int i = 0; i < spheres.Count(); ++i) {
+		const NarrowPhaseKernels::Results& r = spheres.results;
+		if (r.penetration[i] <= 0.0f) {
+			continue;
+		}
+		contacts.push_back({ spheres.pairIndices[i], broadphaseCollisionsVec[spheres.pairIndices[i]] });
+		Vector3 normal = Vector3(r.normalX[i], r.normalY[i], r.normalZ[i]);
+		contacts.back().info.AddContactPoint(normal * spheres.radiusA[i], -normal * spheres.radiusB[i], normal, r.penetration[i]);
+	}
+
+	NarrowPhaseKernels::AABBSpherePairs& boxSpheres = batch.aabbSpheres;
+	NarrowPhaseKernels::AABBSphere(narrowPhasePath, boxSpheres);
+	for (int i = 0; i < boxSpheres.Count(); ++i) {
+		const NarrowPhaseKernels::Results& r = boxSpheres.results;
+		if (r.penetration[i] <= 0.0f) {
+			continue;
+		}
+		contacts.push_back({ boxSpheres.pairIndices[i], broadphaseCollisionsVec[boxSpheres.pairIndices[i]] });
+		CollisionDetection::CollisionInfo& info = contacts.back().info;
+		if (info.a->GetBoundingVolume()->type != VolumeType::AABB) {
+			std::swap(info.a, info.b);
+		}
+		Vector3 normal = Vector3(r.normalX[i], r.normalY[i], r.normalZ[i]);
+		info.AddContactPoint(Vector3(), -normal * boxSpheres.radius[i], normal, r.penetration[i]);
 	}
 }
 
@@ -347,38 +995,26 @@ based on any forces that have been accumulated in the objects during
 the course of the previous game frame.
 */
 void PhysicsSystem::IntegrateAccel(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-
-	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
-			continue; // checks for no physics object on the game object
-		}
-		float inverseMass = object->GetInverseMass();
-
-		Vector3 linearVel = object->GetLinearVelocity();
-		Vector3 force = object->GetForce();
-		Vector3 accel = force * inverseMass;
+	PROFILE_SCOPE("PhysicsSystem::IntegrateAccel");
+	//stops infinitely heavy objects from being moved(static walls etc)
+	Vector3 bodyGravity = config.useGravity ? config.gravity : Vector3();
+	IntegrationKernels::IntegrateLinearAccel(integrationPath, bodies, bodyGravity, dt);
 
-		if (applyGravity && inverseMass > 0) {
-			accel += gravity; // stops infinitely heavy objects from being moved(static walls etc)
-		}
+	int bodyCount = bodies.GetBodyCount();
 
-		linearVel += accel * dt; //integrate acceleration
-		object->SetLinearVelocity(linearVel);
+	//Angular velocity
+	for (int i = 0; i < bodyCount; ++i) {
+		Quaternion q = bodies.orientations.Get(i);
 
-		//Angular velocity
-		Vector3 torque = object->GetTorque();
-		Vector3 angVel = object->GetAngularVelocity();
+		Matrix3 invOrientation	= Matrix3(q.Conjugate());
+		Matrix3 orientation		= Matrix3(q);
 
-		object->UpdateInertiaTensor();
+		Matrix3& tensor = bodies.inverseInertiaTensors[i];
+		tensor = orientation * Matrix3::Scale(bodies.inverseInertias.Get(i)) * invOrientation;
 
-		Vector3 angAccel = object->GetInertiaTensor() * torque;
+		Vector3 angAccel = tensor * bodies.torques.Get(i);
 
-		angVel += angAccel * dt;
-		object->SetAngularVelocity(angVel);
+		bodies.angularVelocities.Set(i, bodies.angularVelocities.Get(i) + angAccel * dt);
 	}
 }
 
@@ -387,43 +1023,151 @@ This function integrates linear and angular velocity into
 position and orientation. It may be called multiple times
 throughout a physics update, to slowly move the objects through
 the world, looking for collisions.
+
+Collision resolution and constraints push objects around through
+their Transforms, so the positions are brought back in first, and
+the results written back out once they've all been moved.
 */
 void PhysicsSystem::IntegrateVelocity(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-	float frameLinearDamping = 1.0f - (0.4f * dt);
+	PROFILE_SCOPE("PhysicsSystem::IntegrateVelocity");
+	float frameLinearDamping	= 1.0f - (config.linearDamping * dt);
+	float frameAngularDamping	= 1.0f - (config.angularDamping * dt);
 
-	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
-			continue;
-		}
+	bodies.GatherPositions();
+
+	continuousStarts.clear();
+	for (GameObject* o : continuousObjects) {
+		continuousStarts.push_back(o->GetTransform().GetPosition());
+	}
 
-		Transform& transform = (*i)->GetTransform();
+	IntegrationKernels::IntegrateLinearVelocity(integrationPath, bodies, frameLinearDamping, dt);
 
-		Vector3 position = transform.GetPosition();
-		Vector3 linearVel = object->GetLinearVelocity();
-		position += linearVel * dt;
-		transform.SetPosition(position);
+	//Orientation stuff, and dampen the angular velocity too
+	IntegrationKernels::IntegrateAngularVelocity(integrationPath, bodies, frameAngularDamping, dt);
+
+	bodies.ScatterPoses();
+
+	SweepContinuousObjects();
+}
+
+/*
+A step only checks for collisions where objects are, not the path they took
+to get there, so anything moving further than its own size in one step can
+pass straight through a thin wall without ever touching it. Rather than
+taking more steps for everything, the few objects flagged for continuous
+collision are swept along the path they took this step instead.
+
+Everything the broadphase finds along the way is gathered up, and the object
+is moved along its path in sub-steps no longer than its own half size, so
+that nothing can fit between two of them. At the first sub-step that touches
+something, the time of impact is narrowed down by bisection, and the object
+is left there - just touching, so the next step's narrowphase finds the
+contact and the solver handles it like any other. Anything it was touching
+before it moved is left to the narrowphase, or it could never slide along
+the floor.
+*/
+void PhysicsSystem::SweepContinuousObjects() {
+	PROFILE_SCOPE("PhysicsSystem::SweepContinuousObjects");
+	for (int i = 0; i < (int)continuousObjects.size(); ++i) {
+		GameObject* object = continuousObjects[i];
+		if (object->GetPhysicsObject()->GetBodyStore() != &bodies || object->GetPhysicsObject()->IsAsleep()) {
+			continue;
+		}
+		Vector3 start	= continuousStarts[i];
+		Vector3 end		= object->GetTransform().GetPosition();
+		Vector3 motion	= end - start;
 
-		linearVel = linearVel * frameLinearDamping;
-		object->SetLinearVelocity(linearVel);
+		object->UpdateBroadphaseAABB();
+		Vector3 halfSizes;
+		object->GetBroadphaseAABB(halfSizes);
 
-		//Orientation stuff
-		Quaternion orientation = transform.GetOrientation();
-		Vector3 angVel = object->GetAngularVelocity();
+		float subStepLength = std::min(halfSizes.x, std::min(halfSizes.y, halfSizes.z));
+		float distance		= motion.Length();
+		if (distance <= subStepLength || subStepLength <= 0.0f) {
+			continue; //Can't have missed anything
+		}
 
-		orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
-		orientation.Normalise();
+		Vector3 sweepMin = Vector3(std::min(start.x, end.x), std::min(start.y, end.y), std::min(start.z, end.z)) - halfSizes;
+		Vector3 sweepMax = Vector3(std::max(start.x, end.x), std::max(start.y, end.y), std::max(start.z, end.z)) + halfSizes;
+
+		sweepCandidates.clear();
+		if (config.broadPhase == BroadPhaseType::AABBTree) {
+			broadphaseTree.Query(sweepMin, sweepMax, [&](int proxy) {
+				sweepCandidates.push_back(broadphaseTree.GetObject(proxy));
+				return true;
+			});
+			staticTree.Query(sweepMin, sweepMax, [&](int proxy) {
+				sweepCandidates.push_back(staticTree.GetObject(proxy));
+				return true;
+			});
+		}
+		else {
+			std::vector<GameObject*>::const_iterator first;
+			std::vector<GameObject*>::const_iterator last;
+			gameWorld.GetObjectIterators(first, last);
+			for (auto j = first; j != last; ++j) {
+				if (!(*j)->GetPhysicsObject() || !(*j)->GetBoundingVolume()) {
+					continue;
+				}
+				Vector3 otherHalfSizes;
+				(*j)->GetBroadphaseAABB(otherHalfSizes);
+				Vector3 otherPos = (*j)->GetTransform().GetPosition();
+				//Without a broadphase, the boxes aren't kept up to date, so everything is a candidate
+				if (config.broadPhase != BroadPhaseType::None &&
+					(otherPos.x + otherHalfSizes.x < sweepMin.x || otherPos.x - otherHalfSizes.x > sweepMax.x ||
+					 otherPos.y + otherHalfSizes.y < sweepMin.y || otherPos.y - otherHalfSizes.y > sweepMax.y ||
+					 otherPos.z + otherHalfSizes.z < sweepMin.z || otherPos.z - otherHalfSizes.z > sweepMax.z)) {
+					continue;
+				}
+				sweepCandidates.push_back(*j);
+			}
+		}
 
-		transform.SetOrientation(orientation);
+		object->GetTransform().SetPosition(start);
+		std::erase_if(sweepCandidates, [&](GameObject* other) {
+			CollisionDetection::CollisionInfo info;
+			return other == object || !object->CanCollideWith(other) || CollisionDetection::ObjectIntersection(object, other, info);
+		});
+
+		int		subSteps	= (int)std::ceil(distance / subStepLength);
+		float	clear		= 0.0f;
+		float	hit			= -1.0f;
+		for (int j = 1; j <= subSteps && !sweepCandidates.empty(); ++j) {
+			float t = j / (float)subSteps;
+			if (TouchesAnyCandidate(object, start + motion * t)) {
+				hit = t;
+				break;
+			}
+			clear = t;
+		}
+		if (hit < 0.0f) {
+			object->GetTransform().SetPosition(end);
+			continue;
+		}
+		for (int j = 0; j < continuousBisections; ++j) {
+			float t = (clear + hit) * 0.5f;
+			if (TouchesAnyCandidate(object, start + motion * t)) {
+				hit = t;
+			}
+			else {
+				clear = t;
+			}
+		}
+		Vector3 impact = start + motion * hit;
+		object->GetTransform().SetPosition(impact);
+		bodies.positions.Set(object->GetPhysicsObject()->GetBodyIndex(), impact);
+	}
+}
 
-		//Dampen the angular velocity too
-		float frameAngularDamping = 1.0f - (0.4f * dt);
-		angVel = angVel * frameAngularDamping;
-		object->SetAngularVelocity(angVel);
+bool PhysicsSystem::TouchesAnyCandidate(GameObject* object, const Vector3& position) {
+	object->GetTransform().SetPosition(position);
+	for (GameObject* other : sweepCandidates) {
+		CollisionDetection::CollisionInfo info;
+		if (CollisionDetection::ObjectIntersection(object, other, info)) {
+			return true;
+		}
 	}
+	return false;
 }
 
 /*
@@ -432,11 +1176,7 @@ clear out any accumulated forces, ready to receive new
 ones in the next 'game' frame.
 */
 void PhysicsSystem::ClearForces() {
-	gameWorld.OperateOnContents(
-		[](GameObject* o) {
-			o->GetPhysicsObject()->ClearForces();
-		}
-	);
+	bodies.ClearForces();
 }
 
 
@@ -446,13 +1186,94 @@ As part of the final physics tutorials, we add in the ability
 to constrain objects based on some extra calculation, allowing
 us to model springs and ropes etc. 
 
+Each island's constraints and contacts are solved together, a little at a
+time - running them all multiple times, slowly moving things forward and
+then rechecking that the constraints have been met.
+
+Nothing in one island can affect another, so each island is a task of its
+own, handed to the task scheduler biggest first, and the workers steal
+from each other to even out the load. An island that's too big to leave
+to one thread (like one huge pile of boxes) is split up by colouring
+instead, and each colour is spread across every thread in turn.
+
 */
-void PhysicsSystem::UpdateConstraints(float dt) {
-	std::vector<Constraint*>::const_iterator first;
-	std::vector<Constraint*>::const_iterator last;
-	gameWorld.GetConstraintIterators(first, last);
+void PhysicsSystem::SolveIslands(float dt, int iterations) {
+	PROFILE_SCOPE("PhysicsSystem::SolveIslands");
+	float constraintDt = dt / (float)iterations;
+
+	islandOrder.clear();
+	for (int i = 0; i < islands.GetIslandCount(); ++i) {
+		const PhysicsIslands::Island& island = islands.GetIsland(i);
+		int cost = island.contactCount + island.constraintCount;
+		if (cost == 0) {
+			continue;
+		}
+		if (cost >= islandSplitSize && taskScheduler.GetThreadCount() > 1) {
+			SolveSplitIsland(i, constraintDt, iterations);
+		}
+		else {
+			islandOrder.push_back(i);
+		}
+	}
+	std::stable_sort(islandOrder.begin(), islandOrder.end(), [&](int a, int b) {
+		const PhysicsIslands::Island& islandA = islands.GetIsland(a);
+		const PhysicsIslands::Island& islandB = islands.GetIsland(b);
+		return islandA.contactCount + islandA.constraintCount > islandB.contactCount + islandB.constraintCount;
+	});
+	taskScheduler.RunTasks((int)islandOrder.size(),
+		[&](int task, int) {
+			SolveIsland(islandOrder[task], constraintDt, iterations);
+		}
+	);
+}
 
-	for (auto i = first; i != last; ++i) {
-		(*i)->UpdateConstraint(dt);
+void PhysicsSystem::SolveIsland(int index, float dt, int iterations) {
+	PROFILE_SCOPE("PhysicsSystem::SolveIsland");
+	const PhysicsIslands::Island& island = islands.GetIsland(index);
+	const int* constraintIndices	= islands.GetConstraints().data() + island.firstConstraint;
+	const int* contactIndices		= islands.GetContacts().data() + island.firstContact;
+
+	for (int i = 0; i < iterations; ++i) {
+		for (int j = 0; j < island.constraintCount; ++j) {
+			worldConstraints[constraintIndices[j]]->UpdateConstraint(dt);
+		}
+		contactSolver.SolveContacts(contactIndices, island.contactCount);
+	}
+}
+
+/*
+Nothing in a colour shares a body, so a colour's constraints and contacts
+can all be solved at once - but each colour has to wait for the one before
+it, as they do share bodies with each other.
+*/
+void PhysicsSystem::SolveSplitIsland(int index, float dt, int iterations) {
+	PROFILE_SCOPE("PhysicsSystem::SolveSplitIsland");
+	islands.ColourIsland(index, islandColouring);
+	const PhysicsIslands::Colouring& colouring = islandColouring;
+
+	for (int i = 0; i < iterations; ++i) {
+		for (int colour = 0; colour < colouring.colourCount; ++colour) {
+			int firstConstraint	= colouring.constraintStarts[colour];
+			int constraintCount	= colouring.constraintStarts[colour + 1] - firstConstraint;
+			int firstContact	= colouring.contactStarts[colour];
+			int contactCount	= colouring.contactStarts[colour + 1] - firstContact;
+
+			auto solveRange = [&](int begin, int end, int) {
+				for (int j = begin; j < end; ++j) {
+					if (j < constraintCount) {
+						worldConstraints[colouring.constraints[firstConstraint + j]]->UpdateConstraint(dt);
+					}
+					else {
+						contactSolver.SolveContacts(&colouring.contacts[firstContact + j - constraintCount], 1);
+					}
+				}
+			};
+			if (colouring.overflowed && colour == PhysicsIslands::MAX_COLOURS - 1) {
+				solveRange(0, constraintCount + contactCount, 0); //These might share bodies, so one at a time
+			}
+			else {
+				taskScheduler.ParallelFor(constraintCount + contactCount, islandBatchSize, solveRange);
+			}
+		}
 	}
 }
\ No newline at end of file
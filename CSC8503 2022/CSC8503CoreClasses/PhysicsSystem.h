@@ -1,10 +1,35 @@
 #pragma once
 #include "GameWorld.h"
+#include "DynamicAABBTree.h"
+#include "SweepAndPrune.h"
+#include "TaskScheduler.h"
+#include "CollisionPairCache.h"
+#include "ContactSolver.h"
+#include "PhysicsBodyStore.h"
+#include "IntegrationKernels.h"
+#include "NarrowPhaseKernels.h"
+#include "PhysicsIslands.h"
+#include "FixedStepScheduler.h"
+#include "GameTimer.h"
+#include "PhysicsConfig.h"
 
 namespace NCL {
 	namespace CSC8503 {
 		class PhysicsSystem	{
 		public:
+			using BroadPhaseType = PhysicsConfig::BroadPhaseType;
+
+			//Seconds spent in each part of Update, added up since the last reset
+			struct PhaseTimings {
+				double	integrate		= 0.0;
+				double	broadPhase		= 0.0;
+				double	narrowPhase		= 0.0;
+				double	constraints		= 0.0;
+				double	collisionList	= 0.0;
+				int		steps			= 0;
+				int		frames			= 0;
+			};
+
 			PhysicsSystem(GameWorld& g);
 			~PhysicsSystem();
 
@@ -12,44 +37,180 @@ namespace NCL {
 
 			void Update(float dt);
 
-			void UseGravity(bool state) {
-				applyGravity = state;
-			}
+			//Changes every setting at once, through the setters below
+			void SetConfig(const PhysicsConfig& newConfig);
+			PhysicsConfig GetConfig() const;
 
-			void SetGlobalDamping(float d) {
-				globalDamping = d;
+			//Changing gravity wakes everything up, or sleeping objects would be left hanging in the air
+			void UseGravity(bool state);
+
+			//How much linear and angular velocity is lost per second
+			void SetDamping(float linear, float angular) {
+				config.linearDamping	= linear;
+				config.angularDamping	= angular;
 			}
 
 			void SetGravity(const Vector3& g);
+
+			void SetBroadPhase(BroadPhaseType type);
+
+			BroadPhaseType GetBroadPhase() const {
+				return config.broadPhase;
+			}
+
+			//Falls back to the scalar integrators if this CPU can't run the given set
+			void SetIntegrationPath(IntegrationKernels::InstructionSet set);
+
+			IntegrationKernels::InstructionSet GetIntegrationPath() const {
+				return integrationPath;
+			}
+
+			//Sphere/sphere and AABB/sphere pairs are tested in batches, using this instruction set
+			void SetNarrowPhasePath(IntegrationKernels::InstructionSet set);
+
+			IntegrationKernels::InstructionSet GetNarrowPhasePath() const {
+				return narrowPhasePath;
+			}
+
+			//With batching off, every pair goes through CollisionDetection::ObjectIntersection, to check the batches against
+			void SetNarrowPhaseBatching(bool batch) {
+				batchNarrowPhase = batch;
+			}
+
+			FixedStepScheduler& GetStepScheduler() {
+				return stepScheduler;
+			}
+
+			//How many times the constraints and contacts are solved each step
+			void SetConstraintIterationCount(int count);
+
+			int GetConstraintIterationCount() const {
+				return config.constraintIterations;
+			}
+
+			//Draws objects between their last two steps, rather than jumping from step to step
+			void SetInterpolation(bool state);
+
+			//Turning sleeping off wakes everything back up
+			void SetSleeping(bool state);
+
+			//How slow (in units / radians per second) an object must be moving to be considered resting
+			void SetSleepTolerances(float linear, float angular) {
+				config.linearSleepTolerance		= linear;
+				config.angularSleepTolerance	= angular;
+			}
+
+			//How long every object in an island must be resting before it goes to sleep
+			void SetTimeToSleep(float seconds) {
+				config.timeToSleep = seconds;
+			}
+
+			const PhaseTimings& GetPhaseTimings() const {
+				return phaseTimings;
+			}
+
+			void ResetPhaseTimings() {
+				phaseTimings = PhaseTimings();
+			}
 		protected:
+			void WakeAllBodies();
+
 			void BasicCollisionDetection();
 			void BroadPhase();
+			void SortAndSweep();
 			void NarrowPhase();
 
 			void ClearForces();
 
 			void IntegrateAccel(float dt);
 			void IntegrateVelocity(float dt);
+			void SweepContinuousObjects();
+			bool TouchesAnyCandidate(GameObject* object, const Vector3& position);
 
-			void UpdateConstraints(float dt);
+			void SolveIslands(float dt, int iterations);
+			void SolveIsland(int index, float dt, int iterations);
+			void SolveSplitIsland(int index, float dt, int iterations);
 
 			void UpdateCollisionList();
 			void UpdateObjectAABBs();
+			void SyncBroadphaseProxies();
+			void BuildStaticTree(const std::vector<GameObject*>& objects);
+			void ReleaseMovedStatics();
+			bool IsInStaticTree(const GameObject* o) const;
+			void RefreshChangedFilters();
+			void SyncBodyStore();
+			void RemoveStalePairs();
 
-			void ImpulseResolveCollision(GameObject& a , GameObject&b, CollisionDetection::ContactPoint& p) const;
+			void BuildIslands();
+			void UpdateSleeping(float dt);
+
+			void AddContact(CollisionDetection::CollisionInfo& info);
+
+			//Adds the time since the last phase ended onto the given phase
+			void EndPhase(double& phase) {
+				phaseTimer.Tick();
+				phase += phaseTimer.GetTimeDeltaSeconds();
+			}
+
+			struct NarrowPhaseContact {
+				int pairIndex;
+				CollisionDetection::CollisionInfo info;
+			};
+
+			//The pairs one narrowphase task found that can be tested in batches
+			struct NarrowPhaseBatch {
+				NarrowPhaseKernels::SphereSpherePairs	sphereSpheres;
+				NarrowPhaseKernels::AABBSpherePairs		aabbSpheres;
+			};
+
+			bool AddToNarrowPhaseBatch(int pairIndex, const CollisionDetection::CollisionInfo& pair, NarrowPhaseBatch& batch) const;
+			void TestNarrowPhaseBatch(NarrowPhaseBatch& batch, std::vector<NarrowPhaseContact>& contacts) const;
 
 			GameWorld& gameWorld;
 
-			bool	applyGravity;
-			Vector3 gravity;
-			float	dTOffset;
-			float	globalDamping;
+			PhysicsConfig		config;
+			FixedStepScheduler	stepScheduler;
+
+			PhaseTimings	phaseTimings;
+			GameTimer		phaseTimer;
 
-			std::set<CollisionDetection::CollisionInfo> allCollisions;
-			std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
+			PhysicsBodyStore bodies;
+			int bodyStoreWorldState = -1;
+			IntegrationKernels::InstructionSet integrationPath;
+
+			PhysicsIslands islands;
+			PhysicsIslands::Colouring islandColouring;
+			std::vector<Constraint*> worldConstraints;
+			std::vector<int> islandOrder;
+			int islandSplitSize	= 256;	//Islands with this many contacts and constraints are spread over every thread
+			int islandBatchSize	= 16;
+			std::vector<PhysicsObject*> newSleepers;
+
+			std::vector<GameObject*>	continuousObjects;
+			std::vector<Vector3>		continuousStarts;
+			std::vector<GameObject*>	sweepCandidates;
+			int continuousBisections = 4;	//How closely the first point of contact is found, once a sweep hits something
+
+			CollisionPairCache allCollisions;
+			int pairCacheWorldState = -1;
+			ContactSolver contactSolver;
 			std::vector<CollisionDetection::CollisionInfo> broadphaseCollisionsVec;
-			bool useBroadPhase		= true;
+
+			DynamicAABBTree<GameObject*>	broadphaseTree;
+			SweepAndPrune<GameObject*>		sweepAndPrune;
+			DynamicAABBTree<GameObject*>	staticTree;
+			std::vector<GameObject*>		staticObjects;	//Sorted, to tell if they've changed
+			std::vector<GameObject*>		sweepAndPruneObjects;
+			int broadphaseWorldState = -1;
 			int numCollisionFrames	= 5;
+
+			TaskScheduler taskScheduler;
+			std::vector<std::vector<NarrowPhaseContact>>	threadContacts;
+			std::vector<NarrowPhaseContact*>				mergedContacts;
+			int narrowPhaseBatchSize = 64;
+			std::vector<NarrowPhaseBatch>	threadBatches;
+			IntegrationKernels::InstructionSet narrowPhasePath;
+			bool batchNarrowPhase = true;
 		};
 	}
 }
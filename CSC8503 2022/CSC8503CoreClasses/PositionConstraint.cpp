@@ -52,8 +52,13 @@ void PositionConstraint::UpdateConstraint(float dt)	{
 			Vector3 aImpulse = offsetDir * lambda;
 			Vector3 bImpulse = -offsetDir * lambda;
 
-			physA->ApplyLinearImpulse(aImpulse); //Multiplied by the mass in function
-			physB->ApplyLinearImpulse(bImpulse);
+			//Static objects might be shared with other islands being solved at the same time
+			if (physA->GetInverseMass() > 0.0f) {
+				physA->ApplyLinearImpulse(aImpulse); //Multiplied by the mass in function
+			}
+			if (physB->GetInverseMass() > 0.0f) {
+				physB->ApplyLinearImpulse(bImpulse);
+			}
 		}
 	}
 }
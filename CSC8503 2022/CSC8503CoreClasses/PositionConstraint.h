@@ -12,6 +12,11 @@ namespace NCL {
 
 			void UpdateConstraint(float dt) override;
 
+			void GetObjects(GameObject*& a, GameObject*& b) const override {
+				a = objectA;
+				b = objectB;
+			}
+
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
@@ -0,0 +1,265 @@
+#include "SceneQuery.h"
+#include "GameObject.h"
+#include "CollisionDetection.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+using namespace NCL;
+using namespace NCL::CSC8503;
+
+//Spheres are set up like a box of the same radius, with their type changed
+SceneQuery::Query SceneQuery::MakeOverlapSphere(const Vector3& centre, float radius, uint32_t layerMask, GameObject* ignore) {
+	Query q = MakeOverlapBox(centre, Vector3(radius, radius, radius), layerMask, ignore);
+	q.type = QueryType::OverlapSphere;
+	return q;
+}
+
+SceneQuery::Query SceneQuery::MakeOverlapBox(const Vector3& centre, const Vector3& halfSizes, uint32_t layerMask, GameObject* ignore) {
+	Query q;
+	q.type			= QueryType::OverlapBox;
+	q.position		= centre;
+	q.halfSizes		= halfSizes;
+	q.maxDistance	= 0.0f;
+	q.layerMask		= layerMask;
+	q.ignore		= ignore;
+	q.firstResult	= 0;
+	q.resultCount	= 0;
+	return q;
+}
+
+SceneQuery::Query SceneQuery::MakeSphereCast(const Vector3& start, const Vector3& direction, float maxDistance, float radius, uint32_t layerMask, GameObject* ignore) {
+	Query q = MakeBoxCast(start, direction, maxDistance, Vector3(radius, radius, radius), layerMask, ignore);
+	q.type = QueryType::SphereCast;
+	return q;
+}
+
+SceneQuery::Query SceneQuery::MakeBoxCast(const Vector3& start, const Vector3& direction, float maxDistance, const Vector3& halfSizes, uint32_t layerMask, GameObject* ignore) {
+	Query q = MakeOverlapBox(start, halfSizes, layerMask, ignore);
+	q.type			= QueryType::BoxCast;
+	q.direction		= direction;
+	q.maxDistance	= maxDistance;
+	return q;
+}
+
+int SceneQuery::OverlapSphere(const GameWorld& world, const Vector3& centre, float radius, std::vector<GameObject*>& results, uint32_t layerMask) {
+	Query q = MakeOverlapSphere(centre, radius, layerMask);
+	Scratch scratch;
+	RunQuery(world, q, results, scratch);
+	return q.resultCount;
+}
+
+int SceneQuery::OverlapBox(const GameWorld& world, const Vector3& centre, const Vector3& halfSizes, std::vector<GameObject*>& results, uint32_t layerMask) {
+	Query q = MakeOverlapBox(centre, halfSizes, layerMask);
+	Scratch scratch;
+	RunQuery(world, q, results, scratch);
+	return q.resultCount;
+}
+
+bool SceneQuery::SphereCast(const GameWorld& world, const Vector3& start, const Vector3& direction, float maxDistance, float radius, SweepHit& hit, uint32_t layerMask, GameObject* ignore) {
+	Query q = MakeSphereCast(start, direction, maxDistance, radius, layerMask, ignore);
+	std::vector<GameObject*> unused;
+	Scratch scratch;
+	RunQuery(world, q, unused, scratch);
+	hit = q.hit;
+	return hit.object != nullptr;
+}
+
+bool SceneQuery::BoxCast(const GameWorld& world, const Vector3& start, const Vector3& direction, float maxDistance, const Vector3& halfSizes, SweepHit& hit, uint32_t layerMask, GameObject* ignore) {
+	Query q = MakeBoxCast(start, direction, maxDistance, halfSizes, layerMask, ignore);
+	std::vector<GameObject*> unused;
+	Scratch scratch;
+	RunQuery(world, q, unused, scratch);
+	hit = q.hit;
+	return hit.object != nullptr;
+}
+
+void SceneQuery::RunQueries(const GameWorld& world, std::vector<Query>& queries, std::vector<GameObject*>& results) {
+	PROFILE_SCOPE("SceneQuery::RunQueries");
+	Scratch scratch;
+	for (Query& q : queries) {
+		RunQuery(world, q, results, scratch);
+	}
+}
+
+void SceneQuery::GatherCandidates(const GameWorld& world, const Vector3& boxMin, const Vector3& boxMax, uint32_t layerMask, GameObject* ignore, std::vector<GameObject*>& candidates) {
+	candidates.clear();
+	auto consider = [&](GameObject* o) {
+		if (o != ignore && o->GetBoundingVolume() && (o->GetLayers() & layerMask)) {
+			candidates.push_back(o);
+		}
+	};
+	const DynamicAABBTree<GameObject*>* dynamicTree;
+	const DynamicAABBTree<GameObject*>* staticTree;
+	if (world.GetQueryTrees(dynamicTree, staticTree)) {
+		for (const DynamicAABBTree<GameObject*>* tree : { dynamicTree, staticTree }) {
+			if (!tree) {
+				continue;
+			}
+			tree->Query(boxMin, boxMax, [&](int proxy) {
+				consider(tree->GetObject(proxy));
+				return true;
+			});
+		}
+		return;
+	}
+	//Without the tree, there's no telling if an object's box is up to date, so they all get tested
+	GameObjectIterator first;
+	GameObjectIterator last;
+	world.GetObjectIterators(first, last);
+	for (auto i = first; i != last; ++i) {
+		consider(*i);
+	}
+}
+
+void SceneQuery::RunQuery(const GameWorld& world, Query& query, std::vector<GameObject*>& results, Scratch& scratch) {
+	bool isSphere	= query.type == QueryType::OverlapSphere || query.type == QueryType::SphereCast;
+	bool isCast		= query.type == QueryType::SphereCast || query.type == QueryType::BoxCast;
+
+	SphereVolume	sphere(query.halfSizes.x);
+	AABBVolume		box(query.halfSizes);
+	const CollisionVolume& volume = isSphere ? (const CollisionVolume&)sphere : (const CollisionVolume&)box;
+
+	Vector3 end		= query.position + (isCast ? query.direction * query.maxDistance : Vector3());
+	Vector3 boxMin	= Vector3(std::min(query.position.x, end.x), std::min(query.position.y, end.y), std::min(query.position.z, end.z)) - query.halfSizes;
+	Vector3 boxMax	= Vector3(std::max(query.position.x, end.x), std::max(query.position.y, end.y), std::max(query.position.z, end.z)) + query.halfSizes;
+	GatherCandidates(world, boxMin, boxMax, query.layerMask, query.ignore, scratch.candidates);
+
+	if (isCast) {
+		RunCast(query, volume, scratch);
+		return;
+	}
+	Transform shapeTransform;
+	shapeTransform.SetPosition(query.position);
+
+	query.firstResult = (int)results.size();
+	for (GameObject* o : scratch.candidates) {
+		CollisionDetection::CollisionInfo info;
+		if (CollisionDetection::VolumeIntersection(volume, shapeTransform, *o->GetBoundingVolume(), o->GetTransform(), info)) {
+			results.push_back(o);
+		}
+	}
+	query.resultCount = (int)results.size() - query.firstResult;
+}
+
+void SceneQuery::RunCast(Query& query, const CollisionVolume& volume, Scratch& scratch) {
+	query.hit = SweepHit();
+
+	std::vector<CastCandidate>& castCandidates = scratch.castCandidates;
+	castCandidates.clear();
+	for (GameObject* o : scratch.candidates) {
+		CastCandidate c;
+		c.object = o;
+		if (SweptBoxInterval(query.position, query.direction, query.maxDistance, query.halfSizes,
+			o->GetTransform().GetPosition(), o->CalculateBroadphaseAABB(), c.enter, c.exit)) {
+			castCandidates.push_back(c);
+		}
+	}
+	std::sort(castCandidates.begin(), castCandidates.end(), [](const CastCandidate& a, const CastCandidate& b) {
+		return a.enter < b.enter;
+	});
+
+	Transform shapeTransform;
+	auto touchesAt = [&](GameObject* o, float distance) {
+		shapeTransform.SetPosition(query.position + query.direction * distance);
+		CollisionDetection::CollisionInfo info;
+		return CollisionDetection::VolumeIntersection(volume, shapeTransform, *o->GetBoundingVolume(), o->GetTransform(), info);
+	};
+
+	float		stepLength	= std::min(query.halfSizes.x, std::min(query.halfSizes.y, query.halfSizes.z));
+	float		nearest		= query.maxDistance;
+	GameObject*	hitObject	= nullptr;
+	for (const CastCandidate& c : castCandidates) {
+		if (hitObject && c.enter >= nearest) {
+			break; //Everything left is further along than what's already been hit
+		}
+		//Already touching where its stretch starts, so the boxes say it can't have touched any sooner
+		if (touchesAt(c.object, c.enter)) {
+			if (!hitObject || c.enter < nearest) {
+				nearest		= c.enter;
+				hitObject	= c.object;
+			}
+			continue;
+		}
+		/*
+		Steps through this object's stretch, or as much of it as is nearer than
+		the last hit. The ends of the stretch are where the boxes only just
+		touch, which for two boxes is only just touching at all, so it's the
+		middle of each step that's tested.
+		*/
+		float last		= std::min(c.exit, nearest);
+		int stepCount	= stepLength > 0.0f ? std::max(1, (int)std::ceil((last - c.enter) / stepLength)) : 1;
+
+		float clear = c.enter;
+		float hitAt = -1.0f;
+		for (int i = 0; i < stepCount; ++i) {
+			float distance = c.enter + (last - c.enter) * ((i + 0.5f) / stepCount);
+			if (touchesAt(c.object, distance)) {
+				hitAt = distance;
+				break;
+			}
+			clear = distance;
+		}
+		if (hitAt < 0.0f) {
+			continue;
+		}
+		for (int i = 0; i < BisectionSteps; ++i) {
+			float distance = (clear + hitAt) * 0.5f;
+			if (touchesAt(c.object, distance)) {
+				hitAt = distance;
+			}
+			else {
+				clear = distance;
+			}
+		}
+		if (!hitObject || hitAt < nearest) {
+			nearest		= hitAt;
+			hitObject	= c.object;
+		}
+	}
+	if (!hitObject) {
+		return;
+	}
+
+	query.hit.object	= hitObject;
+	query.hit.distance	= nearest;
+	query.hit.position	= query.position + query.direction * nearest;
+
+	shapeTransform.SetPosition(query.hit.position);
+	CollisionDetection::CollisionInfo info;
+	if (CollisionDetection::VolumeIntersection(volume, shapeTransform, *hitObject->GetBoundingVolume(), hitObject->GetTransform(), info) && info.pointCount > 0) {
+		query.hit.normal = -info.points[0].normal;
+	}
+	else {
+		query.hit.normal = -query.direction;
+	}
+}
+
+//The slab test, against the two boxes' half sizes added together
+bool SceneQuery::SweptBoxInterval(const Vector3& start, const Vector3& direction, float maxDistance, const Vector3& halfSizes,
+	const Vector3& centre, const Vector3& otherHalfSizes, float& enter, float& exit) {
+	enter	= 0.0f;
+	exit	= maxDistance;
+	for (int axis = 0; axis < 3; ++axis) {
+		float extent	= halfSizes[axis] + otherHalfSizes[axis];
+		float offset	= centre[axis] - start[axis];
+		if (direction[axis] == 0.0f) {
+			if (std::abs(offset) > extent) {
+				return false;
+			}
+			continue;
+		}
+		float inverse	= 1.0f / direction[axis];
+		float axisEnter	= (offset - extent) * inverse;
+		float axisExit	= (offset + extent) * inverse;
+		if (axisEnter > axisExit) {
+			std::swap(axisEnter, axisExit);
+		}
+		enter	= std::max(enter, axisEnter);
+		exit	= std::min(exit, axisExit);
+		if (enter > exit) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "GameWorld.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Questions gameplay code can ask about what's where in a GameWorld,
+		without scanning through every object itself - what's inside a sphere
+		or box, and what a sphere or box would hit first if it moved in a
+		straight line. Boxes are axis aligned.
+
+		Like GameWorld::Raycast, these walk the PhysicsSystem's broadphase trees
+		while it's using them and they're up to date, so they only cost as much as
+		the objects near them, and test every object in the world otherwise.
+		Only objects on one of the layers in layerMask are found.
+
+		A cast first works out, for each object near its path, the stretch of
+		the path where the shape's box overlaps the object's box - it can't
+		touch the object anywhere else. Objects are then tried nearest stretch
+		first, moving the shape through just that stretch in steps no longer
+		than half its smallest size, so nothing can fit between two of them,
+		and narrowing down where it first touched by bisection - the same way
+		the PhysicsSystem sweeps objects flagged for continuous collision.
+		Once something has been hit, objects whose stretch starts beyond it
+		aren't tried at all.
+		*/
+		class SceneQuery {
+		public:
+			static constexpr uint32_t AllLayers = GameObject::AllLayers;
+
+			struct SweepHit {
+				GameObject*	object		= nullptr;
+				float		distance	= FLT_MAX;	//How far the shape travelled before touching it
+				Vector3		position;				//Where the shape's centre was then
+				Vector3		normal;					//Pointing out of the object, back towards the shape
+			};
+
+			enum class QueryType {
+				OverlapSphere,
+				OverlapBox,
+				SphereCast,
+				BoxCast
+			};
+
+			//One of a batch of queries to be answered together
+			struct Query {
+				QueryType	type;
+				Vector3		position;
+				Vector3		halfSizes;		//Spheres use x as their radius
+				Vector3		direction;		//Casts only, normalised
+				float		maxDistance;
+				uint32_t	layerMask;
+				GameObject*	ignore;
+
+				//Overlaps put the objects they find into the batch's results, starting here
+				int			firstResult;
+				int			resultCount;
+				SweepHit	hit;			//Casts only
+			};
+
+			static Query MakeOverlapSphere(const Vector3& centre, float radius, uint32_t layerMask = AllLayers, GameObject* ignore = nullptr);
+			static Query MakeOverlapBox(const Vector3& centre, const Vector3& halfSizes, uint32_t layerMask = AllLayers, GameObject* ignore = nullptr);
+			static Query MakeSphereCast(const Vector3& start, const Vector3& direction, float maxDistance, float radius, uint32_t layerMask = AllLayers, GameObject* ignore = nullptr);
+			static Query MakeBoxCast(const Vector3& start, const Vector3& direction, float maxDistance, const Vector3& halfSizes, uint32_t layerMask = AllLayers, GameObject* ignore = nullptr);
+
+			//Each return how many objects were added to results
+			static int OverlapSphere(const GameWorld& world, const Vector3& centre, float radius, std::vector<GameObject*>& results, uint32_t layerMask = AllLayers);
+			static int OverlapBox(const GameWorld& world, const Vector3& centre, const Vector3& halfSizes, std::vector<GameObject*>& results, uint32_t layerMask = AllLayers);
+
+			//Something already touching the shape where it starts is hit at a distance of 0
+			static bool SphereCast(const GameWorld& world, const Vector3& start, const Vector3& direction, float maxDistance, float radius, SweepHit& hit, uint32_t layerMask = AllLayers, GameObject* ignore = nullptr);
+			static bool BoxCast(const GameWorld& world, const Vector3& start, const Vector3& direction, float maxDistance, const Vector3& halfSizes, SweepHit& hit, uint32_t layerMask = AllLayers, GameObject* ignore = nullptr);
+
+			//Answers every query in turn, sharing the same scratch space, with the overlaps' objects all added to results
+			static void RunQueries(const GameWorld& world, std::vector<Query>& queries, std::vector<GameObject*>& results);
+
+		protected:
+			//An object near a cast's path, and how far along it the boxes overlap
+			struct CastCandidate {
+				GameObject*	object;
+				float		enter;
+				float		exit;
+			};
+
+			//Scratch space that can be kept between queries
+			struct Scratch {
+				std::vector<GameObject*>	candidates;
+				std::vector<CastCandidate>	castCandidates;
+			};
+
+			static void RunQuery(const GameWorld& world, Query& query, std::vector<GameObject*>& results, Scratch& scratch);
+			static void RunCast(Query& query, const CollisionVolume& volume, Scratch& scratch);
+
+			/*
+			Where along the ray a box of the given half sizes, moving from start,
+			overlaps a box at centre. Returns false if they never overlap within
+			maxDistance.
+			*/
+			static bool SweptBoxInterval(const Vector3& start, const Vector3& direction, float maxDistance, const Vector3& halfSizes,
+				const Vector3& centre, const Vector3& otherHalfSizes, float& enter, float& exit);
+
+			//Every object on the mask's layers whose box might overlap the given one
+			static void GatherCandidates(const GameWorld& world, const Vector3& boxMin, const Vector3& boxMax, uint32_t layerMask, GameObject* ignore, std::vector<GameObject*>& candidates);
+
+			//How many times a cast halves the gap between where it was clear and where it touched
+			static constexpr int BisectionSteps = 8;
+
+		private:
+			SceneQuery()	{}
+			~SceneQuery()	{}
+		};
+	}
+}
@@ -0,0 +1,219 @@
+#pragma once
+#include "Vector3.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		A sort and sweep broadphase. Every proxy contributes a min and a max
+		endpoint along one axis, and these endpoints are kept in a sorted array
+		that persists between frames. Objects don't move far in one physics step,
+		so the array is almost sorted already, and an insertion sort puts it back
+		in order in close to linear time.
+
+		Sweeping along the sorted array, any proxy whose min endpoint is reached
+		while another proxy is still 'open' overlaps it on the sort axis, and only
+		those pairs need checking on the other two axes.
+
+		The sort axis is picked as whichever one the objects are most spread out
+		along, so a long corridor of a level sorts along its length.
+		*/
+		template<class T>
+		class SweepAndPrune {
+		public:
+			static const int NullProxy = -1;
+
+			SweepAndPrune(int sortAxis = 0) {
+				axis = sortAxis;
+			}
+			~SweepAndPrune() {
+			}
+
+			void Clear() {
+				proxies.clear();
+				freeProxies.clear();
+				endpoints.clear();
+				active.clear();
+			}
+
+			int CreateProxy(const Vector3& pos, const Vector3& halfSize, T object) {
+				int proxy;
+				if (freeProxies.empty()) {
+					proxy = (int)proxies.size();
+					proxies.emplace_back();
+				}
+				else {
+					proxy = freeProxies.back();
+					freeProxies.pop_back();
+				}
+				Proxy& p = proxies[proxy];
+				p.min		= pos - halfSize;
+				p.max		= pos + halfSize;
+				p.object	= object;
+				p.inUse		= true;
+
+				//Added at the end, the next sort will move them into place
+				endpoints.push_back({ p.min[axis], proxy, true });
+				endpoints.push_back({ p.max[axis], proxy, false });
+				return proxy;
+			}
+
+			void DestroyProxy(int proxy) {
+				std::erase_if(endpoints, [&](const Endpoint& e) {
+					return e.proxy == proxy;
+				});
+				proxies[proxy].inUse = false;
+				freeProxies.push_back(proxy);
+			}
+
+			void MoveProxy(int proxy, const Vector3& pos, const Vector3& halfSize) {
+				proxies[proxy].min = pos - halfSize;
+				proxies[proxy].max = pos + halfSize;
+			}
+
+			bool IsValidProxy(int proxy) const {
+				return proxy >= 0 && proxy < (int)proxies.size() && proxies[proxy].inUse;
+			}
+
+			T GetObject(int proxy) const {
+				return proxies[proxy].object;
+			}
+
+			void GetAABB(int proxy, Vector3& outMin, Vector3& outMax) const {
+				outMin = proxies[proxy].min;
+				outMax = proxies[proxy].max;
+			}
+
+			int GetSortAxis() const {
+				return axis;
+			}
+
+			template<class Func>
+			void OperateOnProxies(Func&& func) const {
+				for (int i = 0; i < (int)proxies.size(); ++i) {
+					if (proxies[i].inUse) {
+						func(i, proxies[i].object);
+					}
+				}
+			}
+
+			/*
+			Brings the endpoint array up to date with the proxies' latest boxes,
+			then calls func(objectA, objectB) once for every overlapping pair.
+			*/
+			template<class Func>
+			void FindPairs(Func&& func) {
+				UpdateSortAxis();
+
+				for (Endpoint& e : endpoints) {
+					e.value = e.isMin ? proxies[e.proxy].min[axis] : proxies[e.proxy].max[axis];
+				}
+				InsertionSort();
+
+				int axisB = (axis + 1) % 3;
+				int axisC = (axis + 2) % 3;
+
+				active.clear();
+				for (const Endpoint& e : endpoints) {
+					if (!e.isMin) {
+						for (size_t i = 0; i < active.size(); ++i) {
+							if (active[i] == e.proxy) {
+								active[i] = active.back();
+								active.pop_back();
+								break;
+							}
+						}
+						continue;
+					}
+					const Proxy& p = proxies[e.proxy];
+					for (int other : active) {
+						const Proxy& o = proxies[other];
+						if (p.min[axisB] <= o.max[axisB] && p.max[axisB] >= o.min[axisB] &&
+							p.min[axisC] <= o.max[axisC] && p.max[axisC] >= o.min[axisC]) {
+							func(o.object, p.object);
+						}
+					}
+					active.push_back(e.proxy);
+				}
+			}
+
+		protected:
+			struct Proxy {
+				Vector3 min;
+				Vector3 max;
+				T		object;
+				bool	inUse;
+			};
+
+			struct Endpoint {
+				float	value;
+				int		proxy;
+				bool	isMin;
+			};
+
+			//Mins sort before maxes at the same value, so touching boxes still pair up
+			static bool Less(const Endpoint& a, const Endpoint& b) {
+				return a.value < b.value || (a.value == b.value && a.isMin && !b.isMin);
+			}
+
+			void InsertionSort() {
+				for (int i = 1; i < (int)endpoints.size(); ++i) {
+					Endpoint key = endpoints[i];
+					int j = i - 1;
+					while (j >= 0 && Less(key, endpoints[j])) {
+						endpoints[j + 1] = endpoints[j];
+						--j;
+					}
+					endpoints[j + 1] = key;
+				}
+			}
+
+			/*
+			Switches to the axis with the greatest spread of box centres. It has to
+			be clearly better than the current one before we switch, as switching
+			scrambles the endpoint order and needs a full sort.
+			*/
+			void UpdateSortAxis() {
+				Vector3 sum;
+				Vector3 sumSq;
+				int count = 0;
+				for (const Proxy& p : proxies) {
+					if (!p.inUse) {
+						continue;
+					}
+					Vector3 centre = (p.min + p.max) * 0.5f;
+					sum		+= centre;
+					sumSq	+= centre * centre;
+					count++;
+				}
+				if (count < 2) {
+					return;
+				}
+				Vector3 mean		= sum / (float)count;
+				Vector3 variance	= (sumSq / (float)count) - (mean * mean);
+
+				int bestAxis = axis;
+				for (int i = 0; i < 3; ++i) {
+					if (variance[i] > variance[bestAxis]) {
+						bestAxis = i;
+					}
+				}
+				if (bestAxis == axis || variance[bestAxis] < variance[axis] * 2.0f) {
+					return;
+				}
+				axis = bestAxis;
+				for (Endpoint& e : endpoints) {
+					e.value = e.isMin ? proxies[e.proxy].min[axis] : proxies[e.proxy].max[axis];
+				}
+				std::sort(endpoints.begin(), endpoints.end(), Less);
+			}
+
+			std::vector<Proxy>		proxies;
+			std::vector<int>		freeProxies;
+			std::vector<Endpoint>	endpoints;
+			std::vector<int>		active;
+
+			int axis;
+		};
+	}
+}
@@ -3,34 +3,57 @@
 using namespace NCL::CSC8503;
 
 Transform::Transform()	{
-	scale = Vector3(1, 1, 1);
+	scale		= Vector3(1, 1, 1);
+	matrixDirty	= true;
+
+	renderMatrixDirty	= true;
+	hasRenderPose		= false;
 }
 
 Transform::~Transform()	{
 
 }
 
-void Transform::UpdateMatrix() {
+void Transform::UpdateMatrix() const {
 	matrix =
 		Matrix4::Translation(position) *
 		Matrix4(orientation) *
 		Matrix4::Scale(scale);
+	matrixDirty = false;
+}
+
+void Transform::UpdateRenderMatrix() const {
+	renderMatrix =
+		Matrix4::Translation(renderPosition) *
+		Matrix4(renderOrientation) *
+		Matrix4::Scale(scale);
+	renderMatrixDirty = false;
+}
+
+void Transform::SetRenderPose(const Vector3& renderPos, const Quaternion& renderOr) {
+	renderPosition		= renderPos;
+	renderOrientation	= renderOr;
+	hasRenderPose		= true;
+	renderMatrixDirty	= true;
 }
 
 Transform& Transform::SetPosition(const Vector3& worldPos) {
 	position = worldPos;
-	UpdateMatrix();
+	matrixDirty = true;
+	hasRenderPose = false;
 	return *this;
 }
 
 Transform& Transform::SetScale(const Vector3& worldScale) {
 	scale = worldScale;
-	UpdateMatrix();
+	matrixDirty = true;
+	renderMatrixDirty = true;
 	return *this;
 }
 
 Transform& Transform::SetOrientation(const Quaternion& worldOrientation) {
 	orientation = worldOrientation;
-	UpdateMatrix();
+	matrixDirty = true;
+	hasRenderPose = false;
 	return *this;
 }
\ No newline at end of file
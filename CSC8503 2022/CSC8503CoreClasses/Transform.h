@@ -27,12 +27,40 @@ namespace NCL {
 				return orientation;
 			}
 
+			//The matrix is only rebuilt when asked for, so moving an object
+			//several times in one frame doesn't rebuild it each time
 			Matrix4 GetMatrix() const {
+				if (matrixDirty) {
+					UpdateMatrix();
+				}
 				return matrix;
 			}
-			void UpdateMatrix();
+			void UpdateMatrix() const;
+
+			//Where this should be drawn, if that's not quite where it is - the
+			//physics blends between its last two steps this way. Moving the
+			//transform again goes back to drawing it where it really is.
+			void SetRenderPose(const Vector3& renderPos, const Quaternion& renderOr);
+
+			Matrix4 GetRenderMatrix() const {
+				if (!hasRenderPose) {
+					return GetMatrix();
+				}
+				if (renderMatrixDirty) {
+					UpdateRenderMatrix();
+				}
+				return renderMatrix;
+			}
 		protected:
-			Matrix4		matrix;
+			void UpdateRenderMatrix() const;
+
+			mutable Matrix4	matrix;
+			mutable bool	matrixDirty;
+			mutable Matrix4	renderMatrix;
+			mutable bool	renderMatrixDirty;
+			bool			hasRenderPose;
+			Vector3			renderPosition;
+			Quaternion		renderOrientation;
 			Quaternion	orientation;
 			Vector3		position;
 
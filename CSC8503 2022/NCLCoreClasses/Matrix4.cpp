@@ -10,6 +10,7 @@ https://research.ncl.ac.uk/game/
 #include "Matrix3.h"
 #include "Maths.h"
 #include "Vector3.h"
+#include <cstring>
 #include "Vector4.h"
 #include "Quaternion.h"
 
@@ -0,0 +1,39 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#include "NullWindow.h"
+
+using namespace NCL;
+
+namespace {
+	class NullKeyboard : public Keyboard {
+	public:
+		NullKeyboard() {}
+	};
+
+	class NullMouse : public Mouse {
+	public:
+		NullMouse() {}
+	};
+}
+
+NullWindow::NullWindow(const std::string& title, int sizeX, int sizeY) {
+	windowTitle	= title;
+	size		= Vector2((float)sizeX, (float)sizeY);
+	defaultSize	= size;
+	minimised	= false;
+
+	keyboard	= new NullKeyboard();
+	mouse		= new NullMouse();
+
+	init		= true;
+}
+
+bool NullWindow::InternalUpdate() {
+	return true;
+}
@@ -0,0 +1,30 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+#include "Window.h"
+
+namespace NCL {
+	/*
+	A window with no OS window behind it, for running things like the physics
+	on machines with no display. It still has a keyboard, mouse and timer, so
+	code that polls them keeps working - they just never report any input.
+	*/
+	class NullWindow : public Window {
+	public:
+		friend class Window;
+		void	LockMouseToWindow(bool)	override {}
+		void	ShowOSPointer(bool)		override {}
+
+	protected:
+		NullWindow(const std::string& title, int sizeX, int sizeY);
+		virtual ~NullWindow(void) {}
+
+		bool	InternalUpdate()	override;
+	};
+}
@@ -0,0 +1,173 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#include "Profiler.h"
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+
+using namespace NCL;
+
+std::atomic<bool> Profiler::enabled = true;
+
+namespace {
+	enum class EventType {
+		Zone,
+		Counter
+	};
+
+	struct ProfileEvent {
+		const char*	name;
+		uint64_t	start;
+		uint64_t	duration;
+		double		value;
+		EventType	type;
+	};
+
+	/*
+	Only the owning thread writes to a buffer. It fills in the slot first,
+	then publishes it by bumping written, so a reader that sees the new
+	count also sees the event. Clearing just moves the point reading starts
+	from, so it never has to touch the writer's side.
+	*/
+	struct ThreadBuffer {
+		std::vector<ProfileEvent>	events;
+		std::atomic<uint64_t>		written		= 0;
+		std::atomic<uint64_t>		readStart	= 0;
+		int							threadID	= 0;
+		std::string					threadName;
+	};
+
+	//Buffers are kept after their thread exits, so its events can still be written out
+	struct BufferRegistry {
+		std::mutex									lock;
+		std::vector<std::unique_ptr<ThreadBuffer>>	buffers;
+	};
+
+	BufferRegistry& GetRegistry() {
+		static BufferRegistry registry;
+		return registry;
+	}
+
+	const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+
+	ThreadBuffer& GetThreadBuffer() {
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (!buffer) {
+			BufferRegistry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.lock);
+			registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+			buffer = registry.buffers.back().get();
+			buffer->events.resize(Profiler::EventsPerThread);
+			buffer->threadID = (int)registry.buffers.size();
+		}
+		return *buffer;
+	}
+
+	void PushEvent(const ProfileEvent& e) {
+		ThreadBuffer& buffer = GetThreadBuffer();
+		uint64_t index = buffer.written.load(std::memory_order_relaxed);
+		buffer.events[index % Profiler::EventsPerThread] = e;
+		buffer.written.store(index + 1, std::memory_order_release);
+	}
+
+	void WriteString(std::ostream& out, const char* s) {
+		out << '"';
+		for (; *s; ++s) {
+			if (*s == '"' || *s == '\\') {
+				out << '\\';
+			}
+			out << *s;
+		}
+		out << '"';
+	}
+}
+
+uint64_t Profiler::GetTimestamp() {
+	//Never 0, so a scope can use 0 to mean it started while profiling was off
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerEpoch).count() + 1;
+}
+
+void Profiler::RecordZone(const char* name, uint64_t start, uint64_t end) {
+	PushEvent({ name, start, end - start, 0.0, EventType::Zone });
+}
+
+void Profiler::RecordCounter(const char* name, double value) {
+	if (!IsEnabled()) {
+		return;
+	}
+	PushEvent({ name, GetTimestamp(), 0, value, EventType::Counter });
+}
+
+void Profiler::SetThreadName(const std::string& name) {
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(GetRegistry().lock);
+	buffer.threadName = name;
+}
+
+void Profiler::Clear() {
+	BufferRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.lock);
+	for (auto& buffer : registry.buffers) {
+		buffer->readStart.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+}
+
+/*
+Zones become complete ("X") events, and counters become counter ("C")
+events. Trace timestamps are in microseconds.
+*/
+void Profiler::WriteChromeTrace(std::ostream& out) {
+	BufferRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.lock);
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (auto& buffer : registry.buffers) {
+		if (!buffer->threadName.empty()) {
+			out << (first ? "" : ",\n");
+			out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadID << ",\"args\":{\"name\":";
+			WriteString(out, buffer->threadName.c_str());
+			out << "}}";
+			first = false;
+		}
+
+		uint64_t end	= buffer->written.load(std::memory_order_acquire);
+		uint64_t begin	= buffer->readStart.load(std::memory_order_relaxed);
+		if (end - begin > (uint64_t)EventsPerThread) {
+			begin = end - EventsPerThread; //The rest have been overwritten
+		}
+		for (uint64_t i = begin; i < end; ++i) {
+			const ProfileEvent& e = buffer->events[i % EventsPerThread];
+			out << (first ? "" : ",\n") << "{\"name\":";
+			WriteString(out, e.name);
+			if (e.type == EventType::Zone) {
+				out << ",\"ph\":\"X\",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << e.duration / 1000.0;
+			}
+			else {
+				out << ",\"ph\":\"C\",\"ts\":" << e.start / 1000.0 << ",\"args\":{\"value\":" << e.value << "}";
+			}
+			out << ",\"pid\":1,\"tid\":" << buffer->threadID << "}";
+			first = false;
+		}
+	}
+	out << "\n]}\n";
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filename) {
+	std::ofstream out(filename);
+	if (!out) {
+		return false;
+	}
+	WriteChromeTrace(out);
+	return true;
+}
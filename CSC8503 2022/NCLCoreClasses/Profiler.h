@@ -0,0 +1,96 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+#include <atomic>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+namespace NCL {
+	/*
+	Records timed zones and counter values, to be looked at afterwards in a
+	trace viewer (chrome://tracing, or ui.perfetto.dev).
+
+	Every thread that records anything gets its own ring buffer, so threads
+	never wait on each other while recording - a zone or counter is just a
+	write into the thread's buffer and a bump of its write count. Once a
+	buffer is full, the oldest events are overwritten.
+
+	Names are stored by pointer, so they must be string literals (or
+	otherwise outlive the profiler).
+
+	Everything is recorded through the PROFILE_ macros below, which compile
+	away to nothing unless USEPROFILING is defined.
+	*/
+	class Profiler {
+	public:
+		static const int EventsPerThread = 1 << 16;
+
+		static void SetEnabled(bool state) {
+			enabled.store(state, std::memory_order_relaxed);
+		}
+
+		static bool IsEnabled() {
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		//Nanoseconds since the profiler started
+		static uint64_t GetTimestamp();
+
+		static void RecordZone(const char* name, uint64_t start, uint64_t end);
+		static void RecordCounter(const char* name, double value);
+
+		//Shown in place of the thread's ID in the trace
+		static void SetThreadName(const std::string& name);
+
+		//Throws away everything recorded so far
+		static void Clear();
+
+		/*
+		Writes every buffer out in the Chrome trace event format. Threads can
+		keep recording while this runs, but anything they write to a part of
+		their buffer that's being read may come out garbled, so it's best
+		done between frames.
+		*/
+		static void WriteChromeTrace(std::ostream& out);
+		static bool WriteChromeTrace(const std::string& filename);
+
+	protected:
+		static std::atomic<bool> enabled;
+	};
+
+	//Times the rest of the enclosing scope as a zone
+	class ProfileScope {
+	public:
+		ProfileScope(const char* zoneName) {
+			name	= zoneName;
+			start	= Profiler::IsEnabled() ? Profiler::GetTimestamp() : 0;
+		}
+		~ProfileScope() {
+			if (start != 0 && Profiler::IsEnabled()) {
+				Profiler::RecordZone(name, start, Profiler::GetTimestamp());
+			}
+		}
+	protected:
+		const char*	name;
+		uint64_t	start;
+	};
+}
+
+#ifdef USEPROFILING
+#define NCL_PROFILE_JOIN_INNER(a, b) a##b
+#define NCL_PROFILE_JOIN(a, b) NCL_PROFILE_JOIN_INNER(a, b)
+#define PROFILE_SCOPE(name)				NCL::ProfileScope NCL_PROFILE_JOIN(profileScope, __LINE__)(name)
+#define PROFILE_COUNTER(name, value)	NCL::Profiler::RecordCounter(name, (double)(value))
+#define PROFILE_THREAD_NAME(name)		NCL::Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)				((void)0)
+#define PROFILE_COUNTER(name, value)	((void)0)
+#define PROFILE_THREAD_NAME(name)		((void)0)
+#endif
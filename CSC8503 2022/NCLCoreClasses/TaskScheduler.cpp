@@ -0,0 +1,179 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#include "TaskScheduler.h"
+#include "Profiler.h"
+#include <algorithm>
+
+using namespace NCL;
+
+TaskScheduler::TaskScheduler(int threadCount) {
+	if (threadCount <= 0) {
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	job				= nullptr;
+	jobGeneration	= 0;
+	workersBusy		= 0;
+	shuttingDown	= false;
+
+	rangeFunc		= nullptr;
+	rangeCount		= 0;
+	rangeBatchSize	= 1;
+	nextIndex		= 0;
+
+	taskFunc		= nullptr;
+	for (int i = 0; i < threadCount; ++i) {
+		taskQueues.push_back(std::make_unique<TaskQueue>());
+	}
+
+	for (int i = 1; i < threadCount; ++i) {
+		workers.emplace_back(&TaskScheduler::WorkerMain, this, i);
+	}
+}
+
+TaskScheduler::~TaskScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		shuttingDown = true;
+	}
+	jobStarted.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+}
+
+void TaskScheduler::Dispatch(const std::function<void(int)>& work) {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		job			= &work;
+		workersBusy	= (int)workers.size();
+		jobGeneration++;
+	}
+	jobStarted.notify_all();
+
+	work(0);
+
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobFinished.wait(lock, [&] { return workersBusy == 0; });
+	job = nullptr;
+}
+
+/*
+Splits [0, count) into batches, which the workers and the calling thread
+claim one at a time until there are none left - so a thread that gets
+cheap batches just claims more of them. Returns once every batch is done.
+*/
+void TaskScheduler::ParallelFor(int count, int batchSize, const RangeFunc& func) {
+	if (count <= 0) {
+		return;
+	}
+	batchSize = std::max(1, batchSize);
+	if (workers.empty() || count <= batchSize) {
+		func(0, count, 0); //Not worth waking anyone up for
+		return;
+	}
+	rangeFunc		= &func;
+	rangeCount		= count;
+	rangeBatchSize	= batchSize;
+	nextIndex		= 0;
+
+	Dispatch([this](int workerIndex) { RunBatches(workerIndex); });
+	rangeFunc = nullptr;
+}
+
+void TaskScheduler::RunBatches(int workerIndex) {
+	while (true) {
+		int begin = nextIndex.fetch_add(rangeBatchSize);
+		if (begin >= rangeCount) {
+			return;
+		}
+		int end = std::min(begin + rangeBatchSize, rangeCount);
+		(*rangeFunc)(begin, end, workerIndex);
+	}
+}
+
+/*
+The tasks are dealt out round robin, so each worker starts off with a
+similar mix of big and small tasks. Tasks never add more tasks, so once
+every queue is empty there's nothing left to do.
+*/
+void TaskScheduler::RunTasks(int count, const TaskFunc& func) {
+	if (count <= 0) {
+		return;
+	}
+	if (workers.empty() || count == 1) {
+		for (int i = 0; i < count; ++i) {
+			func(i, 0);
+		}
+		return;
+	}
+	for (int i = 0; i < count; ++i) {
+		taskQueues[i % taskQueues.size()]->tasks.push_back(i);
+	}
+	taskFunc = &func;
+
+	Dispatch([this](int workerIndex) { RunQueuedTasks(workerIndex); });
+	taskFunc = nullptr;
+}
+
+void TaskScheduler::RunQueuedTasks(int workerIndex) {
+	int task;
+	while (PopTask(workerIndex, task) || StealTask(workerIndex, task)) {
+		(*taskFunc)(task, workerIndex);
+	}
+}
+
+//A worker works through its own queue from the front...
+bool TaskScheduler::PopTask(int workerIndex, int& task) {
+	TaskQueue& queue = *taskQueues[workerIndex];
+	std::lock_guard<std::mutex> lock(queue.lock);
+	if (queue.tasks.empty()) {
+		return false;
+	}
+	task = queue.tasks.front();
+	queue.tasks.pop_front();
+	return true;
+}
+
+//...while thieves take from the back, so they rarely fight over the same end
+bool TaskScheduler::StealTask(int workerIndex, int& task) {
+	int queueCount = (int)taskQueues.size();
+	for (int i = 1; i < queueCount; ++i) {
+		TaskQueue& victim = *taskQueues[(workerIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(victim.lock);
+		if (!victim.tasks.empty()) {
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void TaskScheduler::WorkerMain(int workerIndex) {
+	PROFILE_THREAD_NAME("Worker " + std::to_string(workerIndex));
+	int seenGeneration = 0;
+	while (true) {
+		const std::function<void(int)>* work;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobStarted.wait(lock, [&] { return shuttingDown || jobGeneration != seenGeneration; });
+			if (shuttingDown) {
+				return;
+			}
+			seenGeneration	= jobGeneration;
+			work			= job;
+		}
+		(*work)(workerIndex);
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			workersBusy--;
+		}
+		jobFinished.notify_one();
+	}
+}
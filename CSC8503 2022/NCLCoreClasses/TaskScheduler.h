@@ -0,0 +1,85 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <memory>
+
+namespace NCL {
+	/*
+	A small pool of worker threads that sit asleep until handed some work.
+	The thread calling ParallelFor or RunTasks joins in as worker 0, so a
+	scheduler with no extra threads simply runs everything inline.
+
+	ParallelFor suits loops where every iteration costs about the same.
+	RunTasks is for lumpier work - each worker is dealt its own queue of
+	tasks, and once it runs dry it steals from the other end of someone
+	else's queue, so one expensive task doesn't leave the rest idle.
+	*/
+	class TaskScheduler {
+	public:
+		//func(begin, end, workerIndex) is called for each batch of the range
+		typedef std::function<void(int, int, int)> RangeFunc;
+		//func(task, workerIndex) is called once for each task
+		typedef std::function<void(int, int)> TaskFunc;
+
+		//A thread count of 0 uses one thread per hardware core
+		TaskScheduler(int threadCount = 0);
+		~TaskScheduler();
+
+		int GetThreadCount() const {
+			return (int)workers.size() + 1;
+		}
+
+		void ParallelFor(int count, int batchSize, const RangeFunc& func);
+
+		//Tasks are dealt out in order, so put the most expensive ones first
+		void RunTasks(int count, const TaskFunc& func);
+
+	protected:
+		struct TaskQueue {
+			std::mutex			lock;
+			std::deque<int>		tasks;
+		};
+
+		//Runs work(workerIndex) on every thread, returning once they've all finished
+		void Dispatch(const std::function<void(int)>& work);
+
+		void WorkerMain(int workerIndex);
+		void RunBatches(int workerIndex);
+		void RunQueuedTasks(int workerIndex);
+
+		bool PopTask(int workerIndex, int& task);
+		bool StealTask(int workerIndex, int& task);
+
+		std::vector<std::thread> workers;
+
+		std::mutex				jobMutex;
+		std::condition_variable	jobStarted;
+		std::condition_variable	jobFinished;
+
+		const std::function<void(int)>* job;
+		int					jobGeneration;
+		int					workersBusy;
+		bool				shuttingDown;
+
+		const RangeFunc*	rangeFunc;
+		int					rangeCount;
+		int					rangeBatchSize;
+		std::atomic<int>	nextIndex;
+
+		const TaskFunc*		taskFunc;
+		std::vector<std::unique_ptr<TaskQueue>> taskQueues;
+	};
+}
@@ -9,6 +9,7 @@
 #include "../Plugins/PlayStation4/PS4Window.h"
 #endif
 
+#include "NullWindow.h"
 #include "RendererBase.h"
 
 using namespace NCL;
@@ -33,7 +34,8 @@ Window::~Window()	{
 	delete timer;
 }
 
-Window* Window::CreateGameWindow(std::string title, int sizeX, int sizeY, bool fullScreen, int offsetX, int offsetY) {
+//Without an OS window, there's nowhere for the fullscreen and offset settings to go
+Window* Window::CreateGameWindow(std::string title, int sizeX, int sizeY, [[maybe_unused]] bool fullScreen, [[maybe_unused]] int offsetX, [[maybe_unused]] int offsetY) {
 	if (window) {
 		return nullptr;
 	}
@@ -43,6 +45,16 @@ Window* Window::CreateGameWindow(std::string title, int sizeX, int sizeY, bool f
 #ifdef __ORBIS__
 	return new PS4::PS4Window(title, sizeX, sizeY, fullScreen, offsetX, offsetY);
 #endif
+#if !defined(_WIN32) && !defined(__ORBIS__)
+	return CreateNullWindow(title, sizeX, sizeY);
+#endif
+}
+
+Window* Window::CreateNullWindow(std::string title, int sizeX, int sizeY) {
+	if (window) {
+		return nullptr;
+	}
+	return new NullWindow(title, sizeX, sizeY);
 }
 
 void	Window::SetRenderer(RendererBase* r) {
@@ -25,6 +25,8 @@ namespace NCL {
 	class Window {
 	public:
 		static Window* CreateGameWindow(std::string title = "NCLGL!", int sizeX = 800, int sizeY = 600, bool fullScreen = false, int offsetX = 100, int offsetY = 100);
+		//A window that never opens or receives input, for running without a display
+		static Window* CreateNullWindow(std::string title = "NCLGL!", int sizeX = 800, int sizeY = 600);
 
 		static void DestroyGameWindow() {
 			delete window;
@@ -54,16 +56,16 @@ namespace NCL {
 		virtual void	LockMouseToWindow(bool lock) = 0;
 		virtual void	ShowOSPointer(bool show) = 0;
 
-		virtual void	SetWindowPosition(int x, int y) {};
-		virtual void	SetFullScreen(bool state) {};
-		virtual void	SetConsolePosition(int x, int y) {};
-		virtual void	ShowConsole(bool state) {};
+		virtual void	SetWindowPosition(int, int) {};
+		virtual void	SetFullScreen(bool) {};
+		virtual void	SetConsolePosition(int, int) {};
+		virtual void	ShowConsole(bool) {};
 
 		static const Keyboard*	 GetKeyboard() { return keyboard; }
 		static const Mouse*		 GetMouse() { return mouse; }
 		static const GameTimer*	 GetTimer() { return timer; }
 
-		static Window*	const GetWindow() { return window; }
+		static Window*	GetWindow() { return window; }
 	protected:
 		Window();
 		virtual ~Window();
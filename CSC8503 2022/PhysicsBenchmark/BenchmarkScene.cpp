@@ -0,0 +1,406 @@
+#include "BenchmarkScene.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "CapsuleVolume.h"
+#include "GridBoxMerger.h"
+#include "Assets.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+These match the TutorialGame versions, minus the render objects.
+*/
+static GameObject* AddFloorToWorld(GameWorld& world, const Vector3& position) {
+	GameObject* floor = new GameObject();
+
+	Vector3 floorSize = Vector3(200, 2, 200);
+	AABBVolume* volume = new AABBVolume(floorSize);
+	floor->SetBoundingVolume((CollisionVolume*)volume);
+	floor->GetTransform()
+		.SetScale(floorSize * 2)
+		.SetPosition(position);
+
+	floor->SetPhysicsObject(new PhysicsObject(&floor->GetTransform(), floor->GetBoundingVolume()));
+
+	floor->GetPhysicsObject()->SetInverseMass(0);
+	floor->GetPhysicsObject()->InitCubeInertia();
+
+	world.AddGameObject(floor);
+
+	return floor;
+}
+
+static GameObject* AddSphereToWorld(GameWorld& world, const Vector3& position, float radius, float inverseMass = 10.0f) {
+	GameObject* sphere = new GameObject();
+
+	Vector3 sphereSize = Vector3(radius, radius, radius);
+	SphereVolume* volume = new SphereVolume(radius);
+	sphere->SetBoundingVolume((CollisionVolume*)volume);
+
+	sphere->GetTransform()
+		.SetScale(sphereSize)
+		.SetPosition(position);
+
+	sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+
+	sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
+	sphere->GetPhysicsObject()->InitSphereInertia();
+
+	world.AddGameObject(sphere);
+
+	return sphere;
+}
+
+static GameObject* AddCubeToWorld(GameWorld& world, const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f) {
+	GameObject* cube = new GameObject();
+
+	AABBVolume* volume = new AABBVolume(dimensions);
+	cube->SetBoundingVolume((CollisionVolume*)volume);
+
+	cube->GetTransform()
+		.SetPosition(position)
+		.SetScale(dimensions * 2);
+
+	cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
+
+	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+	cube->GetPhysicsObject()->InitCubeInertia();
+
+	world.AddGameObject(cube);
+
+	return cube;
+}
+
+static GameObject* AddOBBCubeToWorld(GameWorld& world, const Vector3& position, Vector3 dimensions, const Quaternion& orientation, float inverseMass = 10.0f) {
+	GameObject* cube = new GameObject();
+
+	OBBVolume* volume = new OBBVolume(dimensions);
+	cube->SetBoundingVolume((CollisionVolume*)volume);
+
+	cube->GetTransform()
+		.SetPosition(position)
+		.SetOrientation(orientation)
+		.SetScale(dimensions * 2);
+
+	cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
+
+	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+	cube->GetPhysicsObject()->InitCubeInertia();
+
+	world.AddGameObject(cube);
+
+	return cube;
+}
+
+static GameObject* AddCapsuleToWorld(GameWorld& world, const Vector3& position, float halfHeight, float radius, const Quaternion& orientation, float inverseMass = 10.0f) {
+	GameObject* capsule = new GameObject();
+
+	CapsuleVolume* volume = new CapsuleVolume(halfHeight, radius);
+	capsule->SetBoundingVolume((CollisionVolume*)volume);
+
+	capsule->GetTransform()
+		.SetPosition(position)
+		.SetOrientation(orientation)
+		.SetScale(Vector3(radius * 2, halfHeight * 2, radius * 2));
+
+	capsule->SetPhysicsObject(new PhysicsObject(&capsule->GetTransform(), capsule->GetBoundingVolume()));
+
+	capsule->GetPhysicsObject()->SetInverseMass(inverseMass);
+	capsule->GetPhysicsObject()->InitCubeInertia(); //Near enough, from the box around it
+
+	world.AddGameObject(capsule);
+
+	return capsule;
+}
+
+static void InitSphereGridWorld(GameWorld& world, int numRows, int numCols, float rowSpacing, float colSpacing, float radius) {
+	for (int x = 0; x < numCols; ++x) {
+		for (int z = 0; z < numRows; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
+			AddSphereToWorld(world, position, radius, 1.0f);
+		}
+	}
+	AddFloorToWorld(world, Vector3(0, -2, 0));
+}
+
+static void InitMixedGridWorld(GameWorld& world, int numRows, int numCols, float rowSpacing, float colSpacing) {
+	float sphereRadius = 1.0f;
+	Vector3 cubeDims = Vector3(1, 1, 1);
+
+	for (int x = 0; x < numCols; ++x) {
+		for (int z = 0; z < numRows; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 2.0f, z * rowSpacing);
+
+			if (rand() % 2) {
+				AddCubeToWorld(world, position, cubeDims);
+			}
+			else {
+				AddSphereToWorld(world, position, sphereRadius);
+			}
+		}
+	}
+}
+
+static void InitCubeGridWorld(GameWorld& world, int numRows, int numCols, float rowSpacing, float colSpacing, const Vector3& cubeDims) {
+	for (int x = 1; x < numCols + 1; ++x) {
+		for (int z = 1; z < numRows + 1; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
+			AddCubeToWorld(world, position, cubeDims, 1.0f);
+		}
+	}
+}
+
+//Like the cube grid, but with OBBs at random orientations, so they tumble when they land
+static void InitOBBGridWorld(GameWorld& world, int numRows, int numCols, float rowSpacing, float colSpacing, const Vector3& cubeDims) {
+	for (int x = 1; x < numCols + 1; ++x) {
+		for (int z = 1; z < numRows + 1; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
+			Quaternion orientation = Quaternion::EulerAnglesToQuaternion((float)(rand() % 360), (float)(rand() % 360), (float)(rand() % 360));
+			AddOBBCubeToWorld(world, position, cubeDims, orientation, 1.0f);
+		}
+	}
+}
+
+//Capsules at random orientations, dropped close enough together to land on each other
+static void InitCapsuleGridWorld(GameWorld& world, int numRows, int numCols, float rowSpacing, float colSpacing, float halfHeight, float radius) {
+	for (int x = 1; x < numCols + 1; ++x) {
+		for (int z = 1; z < numRows + 1; ++z) {
+			Vector3 position = Vector3(x * colSpacing, 10.0f, z * rowSpacing);
+			Quaternion orientation = Quaternion::EulerAnglesToQuaternion((float)(rand() % 360), (float)(rand() % 360), (float)(rand() % 360));
+			AddCapsuleToWorld(world, position, halfHeight, radius, orientation, 1.0f);
+		}
+	}
+}
+
+//Layers of spheres dropped into a walled pit, nudged a little so they don't stack in neat columns
+static void InitBallPit(GameWorld& world, int numRows, int numCols, int numLayers, float spacing, float radius) {
+	float width	= numCols * spacing;
+	float depth	= numRows * spacing;
+	float wallHeight = numLayers * spacing + 2.0f;
+
+	AddCubeToWorld(world, Vector3(-1.0f, wallHeight * 0.5f, depth * 0.5f), Vector3(1.0f, wallHeight * 0.5f, depth * 0.5f + 2.0f), 0);
+	AddCubeToWorld(world, Vector3(width + 1.0f, wallHeight * 0.5f, depth * 0.5f), Vector3(1.0f, wallHeight * 0.5f, depth * 0.5f + 2.0f), 0);
+	AddCubeToWorld(world, Vector3(width * 0.5f, wallHeight * 0.5f, -1.0f), Vector3(width * 0.5f, wallHeight * 0.5f, 1.0f), 0);
+	AddCubeToWorld(world, Vector3(width * 0.5f, wallHeight * 0.5f, depth + 1.0f), Vector3(width * 0.5f, wallHeight * 0.5f, 1.0f), 0);
+
+	for (int y = 0; y < numLayers; ++y) {
+		for (int x = 0; x < numCols; ++x) {
+			for (int z = 0; z < numRows; ++z) {
+				Vector3 jitter = Vector3((float)(rand() % 100), 0.0f, (float)(rand() % 100)) * (spacing * 0.001f);
+				Vector3 position = Vector3((x + 0.5f) * spacing, radius + y * spacing + 1.0f, (z + 0.5f) * spacing) + jitter;
+				AddSphereToWorld(world, position, radius, 1.0f);
+			}
+		}
+	}
+}
+
+static void InitCubeStacks(GameWorld& world, int numRows, int numCols, int height, float spacing, float halfSize) {
+	for (int x = 0; x < numCols; ++x) {
+		for (int z = 0; z < numRows; ++z) {
+			for (int y = 0; y < height; ++y) {
+				Vector3 position = Vector3(x * spacing, halfSize + y * halfSize * 2.0f, z * spacing);
+				AddCubeToWorld(world, position, Vector3(halfSize, halfSize, halfSize), 1.0f);
+			}
+		}
+	}
+}
+
+static void InitMaze(GameWorld& world, const std::string& filename) {
+	std::ifstream infile(Assets::DATADIR + filename);
+	if (!infile) {
+		std::cerr << "BenchmarkScene: can't open maze " << filename << std::endl;
+		return;
+	}
+	int nodeSize;
+	int gridWidth;
+	int gridHeight;
+	infile >> nodeSize;
+	infile >> gridWidth;
+	infile >> gridHeight;
+
+	std::vector<bool> walls(gridWidth * gridHeight);
+	for (int y = 0; y < gridHeight; ++y) {
+		for (int x = 0; x < gridWidth; ++x) {
+			char type = 0;
+			infile >> type;
+			walls[(gridWidth * y) + x] = type == 'x';
+		}
+	}
+	std::vector<GridBoxMerger::CellBox> boxes;
+	GridBoxMerger::MergeCells(walls, gridWidth, gridHeight, boxes);
+
+	Vector3 cellHalfSize = Vector3(10, 15, 10);
+	for (const GridBoxMerger::CellBox& box : boxes) {
+		Vector3 firstCell	= Vector3((float)(box.x * nodeSize), 0, (float)(box.y * nodeSize));
+		Vector3 halfSize	= Vector3(cellHalfSize.x * box.width, cellHalfSize.y, cellHalfSize.z * box.depth);
+		Vector3 centre		= firstCell + Vector3((box.width - 1) * nodeSize * 0.5f, 0, (box.depth - 1) * nodeSize * 0.5f);
+		AddCubeToWorld(world, centre + Vector3(-200, 8, -180), halfSize, 0);
+	}
+}
+
+BenchmarkScene::BenchmarkScene() {
+	physicsConfig.useGravity = true;
+	physicsConfig.broadPhase = PhysicsConfig::BroadPhaseType::AABBTree;
+}
+
+BenchmarkScene::~BenchmarkScene() {
+}
+
+/*
+Scene files are looked for where they're asked for first, and then in the
+benchmark folder of the data directory, so the bundled ones can be run by
+name from anywhere.
+*/
+bool BenchmarkScene::Load(const std::string& filename) {
+	std::ifstream infile(filename);
+	if (!infile) {
+		infile.open(Assets::DATADIR + "Benchmarks/" + filename);
+	}
+	if (!infile) {
+		std::cerr << "BenchmarkScene: can't open " << filename << std::endl;
+		return false;
+	}
+
+	name = filename;
+	commands.clear();
+
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(infile, text)) {
+		++lineNumber;
+		text = text.substr(0, text.find('#'));
+
+		std::istringstream line(text);
+		std::string keyword;
+		if (!(line >> keyword)) {
+			continue; //Blank, or only a comment
+		}
+		if (!ReadCommand(keyword, line)) {
+			std::cerr << "BenchmarkScene: " << filename << " line " << lineNumber << ": can't read '" << keyword << "'" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool BenchmarkScene::ReadCommand(const std::string& keyword, std::istream& line) {
+	auto readParams = [&](CommandType type, int count) {
+		Command command;
+		command.type = type;
+		command.params.resize(count);
+		for (float& p : command.params) {
+			if (!(line >> p)) {
+				return false;
+			}
+		}
+		commands.push_back(command);
+		return true;
+	};
+
+	if (keyword == "name") {
+		return (bool)(line >> name);
+	}
+	if (keyword == "frames") {
+		return (bool)(line >> frames);
+	}
+	if (keyword == "warmup") {
+		return (bool)(line >> warmupFrames);
+	}
+	if (keyword == "dt") {
+		return (bool)(line >> frameDT);
+	}
+	if (keyword == "seed") {
+		return (bool)(line >> seed);
+	}
+	if (keyword == "floor") {
+		return readParams(CommandType::Floor, 3);
+	}
+	if (keyword == "spheregrid") {
+		return readParams(CommandType::SphereGrid, 5);
+	}
+	if (keyword == "cubegrid") {
+		return readParams(CommandType::CubeGrid, 7);
+	}
+	if (keyword == "mixedgrid") {
+		return readParams(CommandType::MixedGrid, 4);
+	}
+	if (keyword == "obbgrid") {
+		return readParams(CommandType::OBBGrid, 7);
+	}
+	if (keyword == "capsulegrid") {
+		return readParams(CommandType::CapsuleGrid, 6);
+	}
+	if (keyword == "ballpit") {
+		return readParams(CommandType::BallPit, 5);
+	}
+	if (keyword == "cubestacks") {
+		return readParams(CommandType::CubeStacks, 5);
+	}
+	if (keyword == "maze") {
+		Command command;
+		command.type = CommandType::Maze;
+		if (!(line >> command.file)) {
+			return false;
+		}
+		commands.push_back(command);
+		return true;
+	}
+	return physicsConfig.ReadSetting(keyword, line);
+}
+
+/*
+The step rate is pinned, so a slow machine simulates the same steps as a
+fast one rather than dropping its rate - otherwise the timings couldn't be
+compared between them.
+*/
+void BenchmarkScene::Configure(PhysicsSystem& physics) const {
+	physics.SetConfig(physicsConfig);
+
+	FixedStepScheduler& scheduler = physics.GetStepScheduler();
+	scheduler.SetMinHZ(physicsConfig.stepHZ);
+	scheduler.Reset();
+}
+
+void BenchmarkScene::Build(GameWorld& world) const {
+	srand(seed);
+
+	for (const Command& c : commands) {
+		const std::vector<float>& p = c.params;
+		switch (c.type) {
+			case CommandType::Floor: {
+				AddFloorToWorld(world, Vector3(p[0], p[1], p[2]));
+			}break;
+			case CommandType::SphereGrid: {
+				InitSphereGridWorld(world, (int)p[0], (int)p[1], p[2], p[3], p[4]);
+			}break;
+			case CommandType::CubeGrid: {
+				InitCubeGridWorld(world, (int)p[0], (int)p[1], p[2], p[3], Vector3(p[4], p[5], p[6]));
+			}break;
+			case CommandType::MixedGrid: {
+				InitMixedGridWorld(world, (int)p[0], (int)p[1], p[2], p[3]);
+			}break;
+			case CommandType::OBBGrid: {
+				InitOBBGridWorld(world, (int)p[0], (int)p[1], p[2], p[3], Vector3(p[4], p[5], p[6]));
+			}break;
+			case CommandType::CapsuleGrid: {
+				InitCapsuleGridWorld(world, (int)p[0], (int)p[1], p[2], p[3], p[4], p[5]);
+			}break;
+			case CommandType::BallPit: {
+				InitBallPit(world, (int)p[0], (int)p[1], (int)p[2], p[3], p[4]);
+			}break;
+			case CommandType::CubeStacks: {
+				InitCubeStacks(world, (int)p[0], (int)p[1], (int)p[2], p[3], p[4]);
+			}break;
+			case CommandType::Maze: {
+				InitMaze(world, c.file);
+			}break;
+		}
+	}
+}
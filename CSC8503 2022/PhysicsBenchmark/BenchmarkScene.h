@@ -0,0 +1,105 @@
+#pragma once
+#include "PhysicsSystem.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A physics-only version of one of the test worlds, read in from a scene
+		description. Each line of the file is a setting or a command, followed
+		by its parameters, and anything after a # is ignored:
+
+			name		<string>
+			frames		<count>				how many frames are timed
+			warmup		<count>				frames stepped before timing starts
+			dt			<seconds>			time passed to each Update
+			seed		<number>			seeds rand() for the mixed, OBB and capsule grids, and the ball pit
+
+			floor		<x> <y> <z>
+			spheregrid	<rows> <cols> <rowSpacing> <colSpacing> <radius>
+			cubegrid	<rows> <cols> <rowSpacing> <colSpacing> <x> <y> <z>
+			mixedgrid	<rows> <cols> <rowSpacing> <colSpacing>
+			obbgrid		<rows> <cols> <rowSpacing> <colSpacing> <x> <y> <z>
+			capsulegrid	<rows> <cols> <rowSpacing> <colSpacing> <halfHeight> <radius>
+			cubestacks	<rows> <cols> <height> <spacing> <halfSize>
+			ballpit		<rows> <cols> <layers> <spacing> <radius>
+			maze		<filename>			a grid file from the data directory
+
+		The commands build the same objects as TutorialGame's InitSphereGridWorld,
+		InitCubeGridWorld, InitMixedGridWorld and InitMaze, just without anything
+		to render them with - other than obbgrid, which drops cubes with OBB
+		volumes at random orientations, capsulegrid, which does the same with
+		capsules, cubestacks, which rests towers of cubes on the floor, to see
+		how long they take to settle, and ballpit, which drops layers of
+		spheres into a walled pit, so most pairs are sphere/sphere or
+		box/sphere.
+
+		Any of the PhysicsConfig settings can be given too. Scenes default to
+		having gravity on, and using the AABB tree broadphase.
+		*/
+		class BenchmarkScene {
+		public:
+			BenchmarkScene();
+			~BenchmarkScene();
+
+			//Returns false (and prints why) if the file can't be read
+			bool Load(const std::string& filename);
+
+			void Configure(PhysicsSystem& physics) const;
+			void Build(GameWorld& world) const;
+
+			const std::string& GetName() const {
+				return name;
+			}
+
+			int GetFrames() const {
+				return frames;
+			}
+
+			void SetFrames(int count) {
+				frames = count;
+			}
+
+			int GetWarmupFrames() const {
+				return warmupFrames;
+			}
+
+			float GetFrameDT() const {
+				return frameDT;
+			}
+
+			const PhysicsConfig& GetPhysicsConfig() const {
+				return physicsConfig;
+			}
+
+		protected:
+			enum class CommandType {
+				Floor,
+				SphereGrid,
+				CubeGrid,
+				MixedGrid,
+				OBBGrid,
+				CapsuleGrid,
+				CubeStacks,
+				BallPit,
+				Maze
+			};
+
+			struct Command {
+				CommandType			type;
+				std::vector<float>	params;
+				std::string			file;
+			};
+
+			bool ReadCommand(const std::string& keyword, std::istream& line);
+
+			std::string name;
+			int		frames			= 600;
+			int		warmupFrames	= 0;
+			float	frameDT			= 1.0f / 60.0f;
+			unsigned int seed		= 0;
+			PhysicsConfig physicsConfig;
+
+			std::vector<Command> commands;
+		};
+	}
+}
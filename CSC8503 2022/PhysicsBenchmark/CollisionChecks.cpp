@@ -0,0 +1,205 @@
+#include "CollisionChecks.h"
+#include "CollisionDetection.h"
+#include "GameObject.h"
+#include "GameWorld.h"
+#include "PhysicsObject.h"
+#include "PhysicsSystem.h"
+
+#include <list>
+
+using namespace NCL;
+using namespace CSC8503;
+
+static const float PenetrationTolerance	= 0.001f;
+static const float NormalTolerance		= 0.999f; //Dot product with the expected normal
+
+struct CollisionCheck {
+	const char*	name;
+	GameObject*	a;
+	GameObject*	b;
+	bool		hit;
+	Vector3		normal;			//Zero if any direction will do
+	float		penetration;
+};
+
+//A list, as GameObjects can't be copied or moved about
+static GameObject* MakeObject(std::list<GameObject>& objects, CollisionVolume* volume, const Vector3& position, const Quaternion& orientation = Quaternion()) {
+	GameObject& o = objects.emplace_back();
+	o.SetBoundingVolume(volume);
+	o.GetTransform()
+		.SetPosition(position)
+		.SetOrientation(orientation);
+	return &o;
+}
+
+/*
+Every capsule has a half length of 1.5 and a radius of 0.5, and lies along
+the X axis unless it says otherwise. The floor's top is at y = 1.
+*/
+std::vector<CollisionChecks::Result> CollisionChecks::Run() {
+	std::list<GameObject> objects;
+
+	Quaternion alongX = Quaternion::EulerAnglesToQuaternion(0, 0, 90);
+	Quaternion alongZ = Quaternion::EulerAnglesToQuaternion(90, 0, 0);
+
+	GameObject* floor		= MakeObject(objects, (CollisionVolume*)new AABBVolume(Vector3(10, 1, 10)), Vector3(0, 0, 0));
+	GameObject* standing	= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(0, 2.4f, 0));
+	GameObject* lying		= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(3, 1.4f, 0), alongX);
+	GameObject* sunk		= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(-3, 0.8f, 0), alongX);
+
+	GameObject* capsule		= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(0, 0, 0), alongX);
+	GameObject* crossing	= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(0, 0.9f, 0), alongZ);
+	GameObject* parallel	= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(0, 0.9f, 0.2f), alongX);
+	GameObject* coincident	= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(0, 0, 0), alongX);
+	GameObject* apart		= MakeObject(objects, (CollisionVolume*)new CapsuleVolume(1.5f, 0.5f), Vector3(0.3f, 2.9f, 0.1f), alongZ);
+
+	GameObject* sphere		= MakeObject(objects, (CollisionVolume*)new SphereVolume(0.5f), Vector3(0.7f, 0.8f, 0));
+	GameObject* turnedBox	= MakeObject(objects, (CollisionVolume*)new OBBVolume(Vector3(1, 1, 1)), Vector3(0, 1.3f, 0), Quaternion::EulerAnglesToQuaternion(0, 45, 0));
+	GameObject* deepBox		= MakeObject(objects, (CollisionVolume*)new OBBVolume(Vector3(1, 1, 1)), Vector3(0, 0.5f, 0));
+
+	Vector3 up(0, 1, 0);
+	Vector3 parallelNormal = Vector3(0, 0.9f, 0.2f).Normalised();
+
+	CollisionCheck checks[] = {
+		{ "floor-standing capsule",		floor,		standing,	true,	up,				0.1f	},
+		{ "standing capsule-floor",		standing,	floor,		true,	-up,			0.1f	},
+		{ "floor-lying capsule",		floor,		lying,		true,	up,				0.1f	},
+		{ "floor-sunken capsule",		floor,		sunk,		true,	up,				0.7f	},
+		{ "crossing capsules",			capsule,	crossing,	true,	up,				0.1f	},
+		{ "parallel capsules",			capsule,	parallel,	true,	parallelNormal,	1.0f - Vector3(0, 0.9f, 0.2f).Length() },
+		{ "coincident capsules",		capsule,	coincident,	true,	Vector3(),		1.0f	},
+		{ "separate capsules",			capsule,	apart,		false,	Vector3(),		0.0f	},
+		{ "capsule-sphere",				capsule,	sphere,		true,	up,				0.2f	},
+		{ "sphere-capsule",				sphere,		capsule,	true,	-up,			0.2f	},
+		{ "capsule-turned box",			capsule,	turnedBox,	true,	up,				0.2f	},
+		{ "capsule core inside box",	capsule,	deepBox,	true,	up,				1.0f	},
+	};
+
+	std::vector<Result> results;
+	for (const CollisionCheck& c : checks) {
+		CollisionDetection::CollisionInfo info;
+		Result r;
+		r.name			= c.name;
+		r.hit			= CollisionDetection::ObjectIntersection(c.a, c.b, info);
+		r.penetration	= 0.0f;
+		if (r.hit) {
+			//The pair might have been swapped around, so the normal would point the other way
+			r.normal		= info.a == c.a ? info.points[0].normal : -info.points[0].normal;
+			r.penetration	= info.points[0].penetration;
+		}
+		r.passed = r.hit == c.hit;
+		if (r.hit && c.hit) {
+			bool normalGood = c.normal == Vector3() ?
+				std::abs(r.normal.Length() - 1.0f) < PenetrationTolerance :
+				Vector3::Dot(r.normal, c.normal) > NormalTolerance;
+			r.passed = normalGood && std::abs(r.penetration - c.penetration) < PenetrationTolerance;
+		}
+		results.push_back(r);
+	}
+	AddFilterChecks(results);
+	return results;
+}
+
+//Counts the collisions it's been told about
+class FilterCheckObject : public GameObject {
+public:
+	void OnCollisionBegin(GameObject*) override {
+		begun++;
+	}
+	int begun = 0;
+};
+
+static FilterCheckObject* AddBox(std::list<FilterCheckObject>& objects, GameWorld& world, const Vector3& position, float halfSize, float inverseMass, uint32_t layers, uint32_t mask) {
+	FilterCheckObject& o = objects.emplace_back();
+	o.SetBoundingVolume((CollisionVolume*)new AABBVolume(Vector3(halfSize, halfSize, halfSize)));
+	o.GetTransform()
+		.SetPosition(position)
+		.SetScale(Vector3(halfSize, halfSize, halfSize) * 2);
+	o.SetPhysicsObject(new PhysicsObject(&o.GetTransform(), o.GetBoundingVolume()));
+	o.GetPhysicsObject()->SetInverseMass(inverseMass);
+	o.GetPhysicsObject()->InitCubeInertia();
+	o.SetLayers(layers);
+	o.SetCollisionMask(mask);
+	world.AddGameObject(&o);
+	return &o;
+}
+
+/*
+There's no gravity, so each box stays where it's put, overlapping the floor
+or another box, until their masks let them collide.
+*/
+void CollisionChecks::AddFilterChecks(std::vector<Result>& results) {
+	const float	frameDT		= 1.0f / 60.0f;
+	const int	restFrames	= 120;	//Well past the time it takes to fall asleep
+	const int	checkFrames	= 5;
+
+	const uint32_t FloorLayer	= 1;
+	const uint32_t BoxLayer		= 2;
+
+	PhysicsConfig::BroadPhaseType broadPhases[] = {
+		PhysicsConfig::BroadPhaseType::None,
+		PhysicsConfig::BroadPhaseType::AABBTree,
+		PhysicsConfig::BroadPhaseType::SweepAndPrune
+	};
+	const char* broadPhaseNames[] = { "none", "tree", "sweep and prune" };
+
+	enum Change {
+		BoxMask,	//A box on the floor lets the floor in
+		FloorMask,	//The floor lets a box on it in
+		BoxMasks,	//Two overlapping boxes let each other in
+		ChangeCount
+	};
+	const char* changeNames[] = { "box mask allows floor", "floor mask allows box", "box masks allow each other" };
+
+	for (int bp = 0; bp < 3; ++bp) {
+		for (int change = 0; change < ChangeCount; ++change) {
+			GameWorld		world;
+			PhysicsSystem	physics(world);
+			PhysicsConfig	config = physics.GetConfig();
+			config.broadPhase	= broadPhases[bp];
+			config.useGravity	= false;
+			physics.SetConfig(config);
+
+			std::list<FilterCheckObject> objects;
+			FilterCheckObject* floor	= AddBox(objects, world, Vector3(0, -10, 0), 10.0f, 0.0f, FloorLayer, change == FloorMask ? FloorLayer : GameObject::AllLayers);
+			FilterCheckObject* box		= nullptr;
+			FilterCheckObject* other	= nullptr;
+			if (change == BoxMasks) {
+				box		= AddBox(objects, world, Vector3(0, 5, 0), 0.5f, 1.0f, BoxLayer, FloorLayer);
+				other	= AddBox(objects, world, Vector3(0.5f, 5, 0), 0.5f, 1.0f, BoxLayer, FloorLayer);
+			}
+			else {
+				box		= AddBox(objects, world, Vector3(0, 0.4f, 0), 0.5f, 1.0f, BoxLayer, change == BoxMask ? BoxLayer : GameObject::AllLayers);
+			}
+			FilterCheckObject* watched = other ? other : floor;
+
+			for (int i = 0; i < restFrames; ++i) {
+				physics.Update(frameDT);
+			}
+			bool ignoredAtRest	= watched->begun == 0;
+			bool fellAsleep		= box->GetPhysicsObject()->IsAsleep();
+
+			if (change == FloorMask) {
+				floor->SetCollisionMask(GameObject::AllLayers);
+			}
+			else {
+				box->SetCollisionMask(GameObject::AllLayers);
+			}
+			if (other) {
+				other->SetCollisionMask(GameObject::AllLayers);
+			}
+			for (int i = 0; i < checkFrames; ++i) {
+				physics.Update(frameDT);
+			}
+
+			Result r;
+			r.name			= std::string(changeNames[change]) + " (" + broadPhaseNames[bp] + ")";
+			r.hit			= watched->begun > 0;
+			r.penetration	= 0.0f;
+			r.passed		= ignoredAtRest && fellAsleep && r.hit;
+			results.push_back(r);
+
+			world.Clear(); //The list deletes them
+		}
+	}
+}
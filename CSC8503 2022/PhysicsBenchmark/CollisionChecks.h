@@ -0,0 +1,42 @@
+#pragma once
+#include "Vector3.h"
+
+#include <string>
+#include <vector>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		A handful of collision tests with known answers, for the pairs that go
+		through GJK and EPA - capsules against boxes, spheres and each other,
+		including cores that overlap, and parallel and coincident capsules
+		where the Minkowski difference is flat. Each one checks whether the
+		shapes touch, and if so the contact normal (pointing from the first
+		shape to the second) and the depth.
+
+		After those, a few objects that start out ignoring each other are
+		left to fall asleep, then have their collision masks changed so they
+		don't, in each broadphase - hit is whether the physics noticed, and
+		began a collision between them.
+		*/
+		class CollisionChecks {
+		public:
+			struct Result {
+				std::string name;
+				bool	passed;
+				bool	hit;
+				Vector3	normal;
+				float	penetration;
+			};
+
+			static std::vector<Result> Run();
+
+		private:
+			static void AddFilterChecks(std::vector<Result>& results);
+
+			CollisionChecks()	{}
+			~CollisionChecks()	{}
+		};
+	}
+}
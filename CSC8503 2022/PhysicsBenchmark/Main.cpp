@@ -0,0 +1,358 @@
+#include "Window.h"
+#include "GameTimer.h"
+
+#include "GameWorld.h"
+#include "PhysicsSystem.h"
+#include "PhysicsObject.h"
+#include "PhysicsBodyStore.h"
+#include "IntegrationKernels.h"
+
+#include "BenchmarkScene.h"
+#include "CollisionChecks.h"
+#include "Profiler.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+
+A headless benchmark for the physics. Each scene description given on the
+command line is built into its own world, stepped for a set number of
+frames, and the time each phase of the physics update took is written out
+as JSON - to stdout, or to the file given by --output. There's no renderer
+and no OS window (PhysicsSystem is given a null one), so this can run on
+build machines without a GPU to catch performance regressions.
+
+When built with USE_PROFILING, --trace also writes out the profiling zones
+recorded during the run (the most recent ones, if there were too many to
+keep) as a Chrome trace.
+
+--kernels also times each of the integration paths on their own, so the
+scalar, SSE and AVX ones can be compared directly.
+
+--collision-checks runs a few collision tests with known answers (see
+CollisionChecks), and exits with an error if any of them fail.
+
+Anything else starting with a - (or an option missing its value) is an
+error, rather than being taken for a scene file. Only the JSON goes to
+stdout, so errors and progress go to stderr.
+
+	PhysicsBenchmark [--frames N] [--output file.json] [--trace trace.json] [--kernels] [--collision-checks] [scene.txt...]
+
+*/
+
+struct BenchmarkResult {
+	std::string name;
+	std::string broadPhase;
+	int		objectCount;
+	int		sleepingCount;	//How many had come to rest by the end
+	int		frames;
+	double	totalSeconds;
+	double	maxFrameSeconds;
+	PhysicsSystem::PhaseTimings phases;
+};
+
+static BenchmarkResult RunScene(const BenchmarkScene& scene) {
+	GameWorld		world;
+	PhysicsSystem	physics(world);
+
+	scene.Configure(physics);
+	scene.Build(world);
+
+	for (int i = 0; i < scene.GetWarmupFrames(); ++i) {
+		physics.Update(scene.GetFrameDT());
+	}
+	physics.ResetPhaseTimings();
+
+	BenchmarkResult result;
+	result.name				= scene.GetName();
+	result.broadPhase		= PhysicsConfig::GetBroadPhaseName(scene.GetPhysicsConfig().broadPhase);
+	result.frames			= scene.GetFrames();
+	result.totalSeconds		= 0.0;
+	result.maxFrameSeconds	= 0.0;
+
+	GameTimer t;
+	for (int i = 0; i < scene.GetFrames(); ++i) {
+		t.Tick();
+		physics.Update(scene.GetFrameDT());
+		t.Tick();
+		result.totalSeconds		+= t.GetTimeDeltaSeconds();
+		result.maxFrameSeconds	= std::max(result.maxFrameSeconds, (double)t.GetTimeDeltaSeconds());
+	}
+	result.phases = physics.GetPhaseTimings();
+
+	GameObjectIterator first;
+	GameObjectIterator last;
+	world.GetObjectIterators(first, last);
+	result.objectCount		= (int)(last - first);
+	result.sleepingCount	= (int)std::count_if(first, last, [](const GameObject* o) {
+		return o->GetPhysicsObject() && o->GetPhysicsObject()->IsAsleep() && o->GetPhysicsObject()->GetInverseMass() > 0.0f;
+	});
+
+	world.ClearAndErase();
+	physics.Clear();
+
+	return result;
+}
+
+struct KernelResult {
+	std::string name;
+	bool	supported;
+	double	bodiesPerSecond;
+	float	maxDifference;	//Furthest any body ended up from where the scalar path put it
+};
+
+/*
+Times each of the integration paths on the same set of bodies, the same way
+the PhysicsSystem runs them each step. Every path should end up with exactly
+the same positions as the scalar one.
+*/
+static std::vector<KernelResult> RunIntegrationKernels() {
+	const int bodyCount = 100000;
+	const int stepCount = 200;
+	const float dt		= 1.0f / 120.0f;
+
+	std::vector<KernelResult>	results;
+	std::vector<Vector3>		scalarPositions;
+
+	IntegrationKernels::InstructionSet sets[] = {
+		IntegrationKernels::InstructionSet::Scalar,
+		IntegrationKernels::InstructionSet::SSE,
+		IntegrationKernels::InstructionSet::AVX
+	};
+	for (IntegrationKernels::InstructionSet set : sets) {
+		KernelResult result;
+		result.name				= IntegrationKernels::GetName(set);
+		result.supported		= IntegrationKernels::IsSupported(set);
+		result.bodiesPerSecond	= 0.0;
+		result.maxDifference	= 0.0f;
+		if (!result.supported) {
+			results.push_back(result);
+			continue;
+		}
+		std::cerr << "Running " << result.name << " integration..." << std::endl;
+
+		std::vector<Transform>		transforms(bodyCount);
+		std::vector<PhysicsObject*>	objects;
+		PhysicsBodyStore			bodies;
+
+		for (int i = 0; i < bodyCount; ++i) {
+			transforms[i].SetPosition(Vector3((float)(i % 100), (float)(i / 10000), (float)((i / 100) % 100)));
+			transforms[i].SetOrientation(Quaternion::EulerAnglesToQuaternion((float)(i % 360), 0.0f, 0.0f));
+
+			PhysicsObject* o = new PhysicsObject(&transforms[i], nullptr);
+			o->SetInverseMass(i % 10 == 0 ? 0.0f : 1.0f);
+			o->InitSphereInertia();
+			o->SetLinearVelocity(Vector3((float)(i % 7), 0.0f, (float)(i % 5)));
+			o->SetAngularVelocity(Vector3(0.0f, (float)(i % 3), 0.0f));
+			o->AddForce(Vector3(0.0f, 0.0f, (float)(i % 11)));
+			objects.push_back(o);
+			bodies.AddBody(o, &transforms[i]);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int step = 0; step < stepCount; ++step) {
+			IntegrationKernels::IntegrateLinearAccel(set, bodies, Vector3(0.0f, -9.8f, 0.0f), dt);
+			IntegrationKernels::IntegrateLinearVelocity(set, bodies, 1.0f - (0.4f * dt), dt);
+			IntegrationKernels::IntegrateAngularVelocity(set, bodies, 1.0f - (0.4f * dt), dt);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		result.bodiesPerSecond = (bodyCount * (double)stepCount) / seconds;
+
+		for (int i = 0; i < bodyCount; ++i) {
+			Vector3 pos = bodies.positions.Get(i);
+			if (set == IntegrationKernels::InstructionSet::Scalar) {
+				scalarPositions.push_back(pos);
+			}
+			else {
+				result.maxDifference = std::max(result.maxDifference, (pos - scalarPositions[i]).Length());
+			}
+		}
+		results.push_back(result);
+
+		for (PhysicsObject* o : objects) {
+			delete o;
+		}
+	}
+	return results;
+}
+
+static std::string JSONString(const std::string& s) {
+	std::string out = "\"";
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+		}
+		out += c;
+	}
+	return out + "\"";
+}
+
+static void WritePhase(std::ostream& out, const char* name, double seconds, int frames, bool last = false) {
+	out << "\t\t\t\t" << JSONString(name) << ": { \"totalMs\": " << seconds * 1000.0
+		<< ", \"meanFrameMs\": " << (frames > 0 ? seconds * 1000.0 / frames : 0.0) << " }"
+		<< (last ? "\n" : ",\n");
+}
+
+static void WriteResults(std::ostream& out, const std::vector<BenchmarkResult>& results, const std::vector<KernelResult>& kernels, const std::vector<CollisionChecks::Result>& checks) {
+	out << std::fixed << std::setprecision(4);
+	out << "{\n\t\"scenes\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchmarkResult& r = results[i];
+		out << "\t\t{\n";
+		out << "\t\t\t\"name\": "			<< JSONString(r.name)		<< ",\n";
+		out << "\t\t\t\"broadphase\": "		<< JSONString(r.broadPhase)	<< ",\n";
+		out << "\t\t\t\"objects\": "		<< r.objectCount			<< ",\n";
+		out << "\t\t\t\"sleeping\": "		<< r.sleepingCount			<< ",\n";
+		out << "\t\t\t\"frames\": "			<< r.frames					<< ",\n";
+		out << "\t\t\t\"steps\": "			<< r.phases.steps			<< ",\n";
+		out << "\t\t\t\"totalMs\": "		<< r.totalSeconds * 1000.0	<< ",\n";
+		out << "\t\t\t\"meanFrameMs\": "	<< (r.frames > 0 ? r.totalSeconds * 1000.0 / r.frames : 0.0) << ",\n";
+		out << "\t\t\t\"maxFrameMs\": "		<< r.maxFrameSeconds * 1000.0 << ",\n";
+		out << "\t\t\t\"phases\": {\n";
+		WritePhase(out, "integrate",		r.phases.integrate,		r.frames);
+		WritePhase(out, "broadphase",		r.phases.broadPhase,	r.frames);
+		WritePhase(out, "narrowphase",		r.phases.narrowPhase,	r.frames);
+		WritePhase(out, "constraints",		r.phases.constraints,	r.frames);
+		WritePhase(out, "collisionList",	r.phases.collisionList,	r.frames, true);
+		out << "\t\t\t}\n";
+		out << "\t\t}" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "\t],\n\t\"kernels\": [\n";
+	for (size_t i = 0; i < kernels.size(); ++i) {
+		const KernelResult& k = kernels[i];
+		out << "\t\t{ \"name\": " << JSONString(k.name)
+			<< ", \"supported\": " << (k.supported ? "true" : "false")
+			<< ", \"bodiesPerSecond\": " << k.bodiesPerSecond
+			<< ", \"maxDifference\": " << k.maxDifference << " }"
+			<< (i + 1 < kernels.size() ? ",\n" : "\n");
+	}
+	out << "\t],\n\t\"collisionChecks\": [\n";
+	for (size_t i = 0; i < checks.size(); ++i) {
+		const CollisionChecks::Result& c = checks[i];
+		out << "\t\t{ \"name\": " << JSONString(c.name)
+			<< ", \"passed\": " << (c.passed ? "true" : "false")
+			<< ", \"hit\": " << (c.hit ? "true" : "false")
+			<< ", \"normal\": [" << c.normal.x << ", " << c.normal.y << ", " << c.normal.z << "]"
+			<< ", \"penetration\": " << c.penetration << " }"
+			<< (i + 1 < checks.size() ? ",\n" : "\n");
+	}
+	out << "\t]\n}\n";
+}
+
+static void PrintUsage(std::ostream& out) {
+	out << "Usage: PhysicsBenchmark [--frames N] [--output file.json] [--trace trace.json] [--kernels] [--collision-checks] [scene.txt...]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> sceneFiles;
+	std::string outputFile;
+	std::string traceFile;
+	int frameOverride = -1;
+	bool runKernels = false;
+	bool runChecks	= false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--frames" && i + 1 < argc) {
+			frameOverride = std::atoi(argv[++i]);
+		}
+		else if (arg == "--output" && i + 1 < argc) {
+			outputFile = argv[++i];
+		}
+		else if (arg == "--trace" && i + 1 < argc) {
+			traceFile = argv[++i];
+		}
+		else if (arg == "--kernels") {
+			runKernels = true;
+		}
+		else if (arg == "--collision-checks") {
+			runChecks = true;
+		}
+		else if (arg == "--help" || arg == "-h") {
+			PrintUsage(std::cout);
+			return 0;
+		}
+		else if (arg[0] == '-') {
+			std::cerr << "Unknown option, or missing its value: " << arg << std::endl;
+			PrintUsage(std::cerr);
+			return 1;
+		}
+		else {
+			sceneFiles.push_back(arg);
+		}
+	}
+	if (sceneFiles.empty() && !runKernels && !runChecks) {
+		PrintUsage(std::cerr);
+		return 1;
+	}
+
+	Window::CreateNullWindow("PhysicsBenchmark");
+	PROFILE_THREAD_NAME("Main");
+
+	std::vector<BenchmarkResult> results;
+	for (const std::string& file : sceneFiles) {
+		BenchmarkScene scene;
+		if (!scene.Load(file)) {
+			Window::DestroyGameWindow();
+			return 1;
+		}
+		if (frameOverride >= 0) {
+			scene.SetFrames(frameOverride);
+		}
+		std::cerr << "Running " << scene.GetName() << "..." << std::endl;
+		results.push_back(RunScene(scene));
+	}
+
+	std::vector<KernelResult> kernels;
+	if (runKernels) {
+		kernels = RunIntegrationKernels();
+	}
+
+	std::vector<CollisionChecks::Result> checks;
+	if (runChecks) {
+		checks = CollisionChecks::Run();
+	}
+	bool checksFailed = std::any_of(checks.begin(), checks.end(), [](const CollisionChecks::Result& c) {
+		return !c.passed;
+	});
+	for (const CollisionChecks::Result& c : checks) {
+		if (!c.passed) {
+			std::cerr << "Collision check failed: " << c.name << std::endl;
+		}
+	}
+
+	//Still write the results out, but fail the run, so a missing trace doesn't go unnoticed
+	bool traceFailed = false;
+	if (!traceFile.empty()) {
+#ifdef USEPROFILING
+		if (!Profiler::WriteChromeTrace(traceFile)) {
+			std::cerr << "Can't write to " << traceFile << std::endl;
+			traceFailed = true;
+		}
+#else
+		std::cerr << "Built without USE_PROFILING, so there's no trace to write" << std::endl;
+#endif
+	}
+
+	Window::DestroyGameWindow();
+
+	if (outputFile.empty()) {
+		WriteResults(std::cout, results, kernels, checks);
+		return (checksFailed || traceFailed) ? 1 : 0;
+	}
+	std::ofstream out(outputFile);
+	if (!out) {
+		std::cerr << "Can't write to " << outputFile << std::endl;
+		return 1;
+	}
+	WriteResults(out, results, kernels, checks);
+	return (checksFailed || traceFailed) ? 1 : 0;
+}